@@ -21,12 +21,17 @@
 // THE SOFTWARE.
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -59,6 +64,33 @@
 // ZMEYA_ASSERT
 //
 //
+// To override software prefetch
+// ZMEYA_PREFETCH
+//
+//
+// To disable SSE2 code paths (BVH box tests, etc)
+// ZMEYA_DISABLE_SIMD
+//
+//
+// Size of relative offsets and array sizes in bits (32 or 64), default is 32
+// 64-bit offsets are required for blobs larger than 2 GB
+// ZMEYA_ROFFSET_BITS
+//
+//
+// Use non-owning BlobPtr (builder pointer + offset) instead of std::weak_ptr, no atomic reference counting on the hot path
+// Note: BlobPtr must not outlive its BlobBuilder in this mode
+// ZMEYA_FAST_BLOBPTR
+//
+//
+// Validate that the BlobBuilder is still alive on every BlobPtr access (enabled by default in _DEBUG with ZMEYA_FAST_BLOBPTR)
+// ZMEYA_VALIDATE_BLOBPTR
+//
+//
+// To disable virtual memory based BlobBuilder storage (BlobStorageType::VirtualMemory falls back to std::vector,
+// BlobBuilder::createFileMapped returns nullptr)
+// ZMEYA_DISABLE_VIRTUAL_MEMORY
+//
+//
 
 #if !defined(ZMEYA_ALLOC) || !defined(ZMEYA_FREE)
 #if defined(_WIN32)
@@ -92,6 +124,45 @@ inline void* alloc_aligned_posix(size_t sizeInBytes, size_t alignment)
 #define ZMEYA_ASSERT(cond) assert(cond)
 #endif
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if !defined(ZMEYA_DISABLE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define ZMEYA_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(ZMEYA_ENABLE_SERIALIZE_SUPPORT) && !defined(ZMEYA_DISABLE_VIRTUAL_MEMORY)
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#define ZMEYA_UNDEF_WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#ifdef ZMEYA_UNDEF_WIN32_LEAN_AND_MEAN
+#undef WIN32_LEAN_AND_MEAN
+#undef ZMEYA_UNDEF_WIN32_LEAN_AND_MEAN
+#endif
+#define ZMEYA_VIRTUAL_MEMORY_WIN32
+#elif defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <unistd.h>
+#define ZMEYA_VIRTUAL_MEMORY_POSIX
+#endif
+#endif
+
+#ifndef ZMEYA_PREFETCH
+#if defined(__GNUC__) || defined(__clang__)
+#define ZMEYA_PREFETCH(ptr) __builtin_prefetch(ptr)
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define ZMEYA_PREFETCH(ptr) _mm_prefetch((const char*)(ptr), _MM_HINT_T0)
+#else
+#define ZMEYA_PREFETCH(ptr) ((void)(ptr))
+#endif
+#endif
+
 #ifndef ZMEYA_NODISCARD
 #if __cplusplus >= 201703L
 #define ZMEYA_NODISCARD [[nodiscard]]
@@ -114,6 +185,15 @@ inline void* alloc_aligned_posix(size_t sizeInBytes, size_t alignment)
 #define ZMEYA_VALIDATE_HASH_DUPLICATES
 #endif
 
+#if defined(_DEBUG) && defined(ZMEYA_FAST_BLOBPTR) && !defined(ZMEYA_VALIDATE_BLOBPTR)
+#define ZMEYA_VALIDATE_BLOBPTR
+#endif
+
+#ifdef ZMEYA_ENABLE_SERIALIZE_SUPPORT
+#include <mutex>
+#include <thread>
+#endif
+
 namespace zm
 {
 
@@ -200,8 +280,20 @@ ZMEYA_NODISCARD inline size_t hashString(const char* str)
 // absolute offset/difference type
 using offset_t = std::uintptr_t;
 using diff_t = std::ptrdiff_t;
-// relative offset type
+// relative offset type and array size type
+#ifndef ZMEYA_ROFFSET_BITS
+#define ZMEYA_ROFFSET_BITS 32
+#endif
+
+#if ZMEYA_ROFFSET_BITS == 32
 using roffset_t = int32_t;
+using asize_t = uint32_t;
+#elif ZMEYA_ROFFSET_BITS == 64
+using roffset_t = int64_t;
+using asize_t = uint64_t;
+#else
+#error "ZMEYA_ROFFSET_BITS must be 32 or 64"
+#endif
 
 ZMEYA_NODISCARD inline offset_t toAbsolute(offset_t base, roffset_t offset)
 {
@@ -219,6 +311,34 @@ ZMEYA_NODISCARD inline uintptr_t toAbsoluteAddr(uintptr_t base, roffset_t offset
 template <typename T> class BlobPtr;
 #endif
 
+/*
+
+    Span
+
+*/
+template <typename T> struct Span
+{
+    T* data = nullptr;
+    size_t size = 0;
+
+    Span() = default;
+    Span(T* _data, size_t _size)
+        : data(_data)
+        , size(_size)
+    {
+    }
+
+    ZMEYA_NODISCARD T& operator[](const size_t index) const noexcept
+    {
+        ZMEYA_ASSERT(index < size);
+        return data[index];
+    }
+
+    ZMEYA_NODISCARD T* begin() const noexcept { return data; }
+    ZMEYA_NODISCARD T* end() const noexcept { return data + size; }
+    ZMEYA_NODISCARD bool empty() const noexcept { return size == 0; }
+};
+
 /*
     Pointer - self-relative pointer relative to its own memory address
 */
@@ -275,6 +395,141 @@ template <typename T> class Pointer
     friend class BlobBuilder;
 };
 
+/*
+    Pointer16 - compact (16-bit) self-relative pointer, the target must be within +/-32 KB from the pointer
+*/
+template <typename T> class Pointer16
+{
+    // addr = this + offset, offset(0) = nullptr
+    int16_t relativeOffset;
+
+    ZMEYA_NODISCARD T* getUnsafe() const noexcept
+    {
+        ZMEYA_ASSERT(relativeOffset != 0);
+        return reinterpret_cast<T*>(uintptr_t(this) + ptrdiff_t(relativeOffset));
+    }
+
+  public:
+    Pointer16() noexcept = default;
+
+    ZMEYA_NODISCARD T* get() const noexcept
+    {
+        uintptr_t addr = (relativeOffset == 0) ? uintptr_t(0) : uintptr_t(this) + ptrdiff_t(relativeOffset);
+        return reinterpret_cast<T*>(addr);
+    }
+
+#ifdef ZMEYA_ENABLE_SERIALIZE_SUPPORT
+    Pointer16& operator=(const BlobPtr<T>& other);
+#endif
+
+    ZMEYA_NODISCARD T* operator->() const noexcept { return getUnsafe(); }
+
+    ZMEYA_NODISCARD T& operator*() const noexcept { return *(getUnsafe()); }
+
+    ZMEYA_NODISCARD bool operator==(const Pointer16& other) const noexcept { return get() == other.get(); }
+    ZMEYA_NODISCARD bool operator!=(const Pointer16& other) const noexcept { return get() != other.get(); }
+
+    operator bool() const noexcept { return relativeOffset != 0; }
+    ZMEYA_NODISCARD bool operator==(std::nullptr_t) const noexcept { return relativeOffset == 0; }
+    ZMEYA_NODISCARD bool operator!=(std::nullptr_t) const noexcept { return relativeOffset != 0; }
+
+    friend class BlobBuilder;
+};
+
+/*
+    VariantPointer - self-relative pointer to one of the Ts types
+    the type index is packed into the low (alignment) bits of the relative offset
+    so the type can be checked without dereferencing the pointer
+*/
+template <typename U, typename... Ts> struct VariantTypeIndex;
+
+template <typename U, typename... Ts> struct VariantTypeIndex<U, U, Ts...>
+{
+    static constexpr size_t value = 0;
+};
+
+template <typename U, typename T, typename... Ts> struct VariantTypeIndex<U, T, Ts...>
+{
+    static constexpr size_t value = 1 + VariantTypeIndex<U, Ts...>::value;
+};
+
+template <typename U> struct VariantTypeIndex<U>
+{
+    static_assert(sizeof(U) == 0, "Type is not a part of the VariantPointer type list");
+    static constexpr size_t value = 0;
+};
+
+constexpr size_t variantMinAlignment(size_t a) { return a; }
+template <typename... Args> constexpr size_t variantMinAlignment(size_t a, size_t b, Args... args)
+{
+    return variantMinAlignment((a < b) ? a : b, args...);
+}
+
+template <typename... Ts> class VariantPointer
+{
+  public:
+    static constexpr size_t kNumTypes = sizeof...(Ts);
+    // offset between VariantPointer and target is always a multiple of this value
+    static constexpr size_t kTagAlignment = variantMinAlignment(alignof(roffset_t), alignof(Ts)...);
+
+  private:
+    static_assert(kNumTypes > 0, "VariantPointer requires at least one type");
+    static_assert(kNumTypes <= kTagAlignment, "Not enough alignment bits to store the type index, increase types alignment");
+    static constexpr roffset_t kTagMask = roffset_t(kTagAlignment - 1);
+
+    // (target - this) | typeIndex, zero = nullptr
+    roffset_t relativeOffset;
+
+    ZMEYA_NODISCARD uintptr_t getAddress() const noexcept
+    {
+        ZMEYA_ASSERT(relativeOffset != 0);
+        return toAbsoluteAddr(uintptr_t(this), roffset_t(relativeOffset & ~kTagMask));
+    }
+
+    template <typename Func, typename Result, typename U> static Result invokeVisitor(Func& func, uintptr_t addr)
+    {
+        return func(*reinterpret_cast<U*>(addr));
+    }
+
+  public:
+    VariantPointer() noexcept = default;
+
+    // type index (only valid for non-null pointers)
+    ZMEYA_NODISCARD size_t index() const noexcept
+    {
+        ZMEYA_ASSERT(relativeOffset != 0);
+        return size_t(relativeOffset & kTagMask);
+    }
+
+    template <typename U> ZMEYA_NODISCARD bool is() const noexcept
+    {
+        return relativeOffset != 0 && size_t(relativeOffset & kTagMask) == VariantTypeIndex<U, Ts...>::value;
+    }
+
+    // returns nullptr if the pointer is null or points to another type
+    template <typename U> ZMEYA_NODISCARD U* get() const noexcept { return is<U>() ? reinterpret_cast<U*>(getAddress()) : nullptr; }
+
+    // call func(U&) for the actual type of the target (pointer must be non-null)
+    template <typename Func> decltype(auto) visit(Func&& func) const
+    {
+        typedef typename std::tuple_element<0, std::tuple<Ts...>>::type FirstType;
+        typedef decltype(func(std::declval<FirstType&>())) Result;
+        typedef Result (*Invoker)(Func&, uintptr_t);
+        static constexpr Invoker table[] = {&invokeVisitor<Func, Result, Ts>...};
+        return table[index()](func, getAddress());
+    }
+
+#ifdef ZMEYA_ENABLE_SERIALIZE_SUPPORT
+    template <typename U> VariantPointer& operator=(const BlobPtr<U>& other);
+#endif
+
+    operator bool() const noexcept { return relativeOffset != 0; }
+    ZMEYA_NODISCARD bool operator==(std::nullptr_t) const noexcept { return relativeOffset == 0; }
+    ZMEYA_NODISCARD bool operator!=(std::nullptr_t) const noexcept { return relativeOffset != 0; }
+
+    friend class BlobBuilder;
+};
+
 /*
     String
 */
@@ -341,10 +596,12 @@ ZMEYA_NODISCARD inline bool operator!=(const std::string& left, const String& ri
 /*
     Array
 */
+template <typename T> class ArrayWriter;
+
 template <typename T> class Array
 {
     roffset_t relativeOffset;
-    uint32_t numElements;
+    asize_t numElements;
 
   private:
     ZMEYA_NODISCARD const T* getConstData() const noexcept
@@ -402,6 +659,45 @@ template <typename T> class Array
 
     ZMEYA_NODISCARD bool empty() const noexcept { return size() == 0; }
 
+    friend class BlobBuilder;
+    friend class ArrayWriter<T>;
+};
+
+/*
+    SmallArray - compact array (16-bit relative offset + 16-bit size)
+    array data must be within +/-32 KB from the array header, up to 65535 elements
+*/
+template <typename T> class SmallArray
+{
+    int16_t relativeOffset;
+    uint16_t numElements;
+
+    ZMEYA_NODISCARD const T* getConstData() const noexcept
+    {
+        return reinterpret_cast<const T*>(uintptr_t(this) + ptrdiff_t(relativeOffset));
+    }
+
+    ZMEYA_NODISCARD T* getData() const noexcept { return const_cast<T*>(getConstData()); }
+
+  public:
+    SmallArray() noexcept = default;
+
+    ZMEYA_NODISCARD size_t size() const noexcept { return size_t(numElements); }
+
+    ZMEYA_NODISCARD const T& operator[](const size_t index) const noexcept
+    {
+        ZMEYA_ASSERT(index < size());
+        return getConstData()[index];
+    }
+
+    ZMEYA_NODISCARD const T* data() const noexcept { return getConstData(); }
+
+    ZMEYA_NODISCARD const T* begin() const noexcept { return getConstData(); }
+
+    ZMEYA_NODISCARD const T* end() const noexcept { return getConstData() + size(); }
+
+    ZMEYA_NODISCARD bool empty() const noexcept { return size() == 0; }
+
     friend class BlobBuilder;
 };
 
@@ -461,8 +757,8 @@ template <typename Key> class HashSet
     typedef Key Item;
     struct Bucket
     {
-        uint32_t beginIndex;
-        uint32_t endIndex;
+        asize_t beginIndex;
+        asize_t endIndex;
     };
     Array<Bucket> buckets;
     Array<Item> items;
@@ -537,8 +833,8 @@ template <typename Key, typename Value> class HashMap
     typedef Pair<const Key, Value> Item;
     struct Bucket
     {
-        uint32_t beginIndex;
-        uint32_t endIndex;
+        asize_t beginIndex;
+        asize_t endIndex;
     };
     Array<Bucket> buckets;
     Array<Item> items;
@@ -671,872 +967,5435 @@ template <typename Key, typename Value> class HashMap
     }
 
     friend class BlobBuilder;
+    friend class BlobSizePlanner;
 };
 
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-#ifdef ZMEYA_ENABLE_SERIALIZE_SUPPORT
-
-ZMEYA_NODISCARD inline diff_t diff(offset_t a, offset_t b) noexcept
+/*
+    Bit utils
+*/
+ZMEYA_NODISCARD inline uint32_t popCount64(uint64_t v) noexcept
 {
-    diff_t res = a - b;
-    return res;
+#if defined(__GNUC__) || defined(__clang__)
+    return uint32_t(__builtin_popcountll(v));
+#else
+    v = v - ((v >> 1) & 0x5555555555555555ull);
+    v = (v & 0x3333333333333333ull) + ((v >> 2) & 0x3333333333333333ull);
+    v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return uint32_t((v * 0x0101010101010101ull) >> 56);
+#endif
 }
 
-ZMEYA_NODISCARD inline offset_t diffAddr(uintptr_t a, uintptr_t b)
+// note: result is undefined for zero input
+ZMEYA_NODISCARD inline uint32_t countTrailingZeros64(uint64_t v) noexcept
 {
-    ZMEYA_ASSERT(a >= b);
-    uintptr_t res = a - b;
-    ZMEYA_ASSERT(res <= uintptr_t(std::numeric_limits<offset_t>::max()));
-    return offset_t(res);
+    ZMEYA_ASSERT(v != 0);
+#if defined(__GNUC__) || defined(__clang__)
+    return uint32_t(__builtin_ctzll(v));
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long index;
+    _BitScanForward64(&index, v);
+    return uint32_t(index);
+#else
+    return popCount64((v & (~v + 1)) - 1);
+#endif
 }
 
-ZMEYA_NODISCARD inline roffset_t toRelativeOffset(diff_t v)
+// position of the k-th (zero-based) set bit
+ZMEYA_NODISCARD inline uint32_t selectInWord64(uint64_t v, uint32_t k) noexcept
 {
-    ZMEYA_ASSERT(v >= diff_t(std::numeric_limits<roffset_t>::min()));
-    ZMEYA_ASSERT(v <= diff_t(std::numeric_limits<roffset_t>::max()));
-    return roffset_t(v);
+    ZMEYA_ASSERT(k < popCount64(v));
+    uint32_t base = 0;
+    for (;;)
+    {
+        uint32_t byteCount = popCount64(v & 0xffull);
+        if (k < byteCount)
+        {
+            break;
+        }
+        k -= byteCount;
+        v >>= 8;
+        base += 8;
+    }
+    for (uint32_t i = 0; i < k; i++)
+    {
+        // clear lowest set bit
+        v &= v - 1;
+    }
+    return base + countTrailingZeros64(v);
 }
 
-constexpr bool inline isPowerOfTwo(size_t v) { return v && ((v & (v - 1)) == 0); }
-
-class BlobBuilder;
-
 /*
-    This is a non-serializable pointer to blob internal memory
-    Note: blob is able to relocate its own memory that's is why we cannot use
-   standard pointers or references
+    BitSet - a dense set of bits with the rank/select directory
+    rank(i) = number of set bits in the range [0, i)
+    select(k) = index of the k-th (zero-based) set bit
 */
-template <typename T> class BlobPtr
+class BitSet
 {
-    std::weak_ptr<const BlobBuilder> blob;
-    offset_t absoluteOffset = 0;
+  public:
+    static constexpr size_t kBitsPerWord = 64;
+    // one rank directory entry per block
+    static constexpr size_t kWordsPerBlock = 8;
+    static constexpr size_t kBitsPerBlock = kBitsPerWord * kWordsPerBlock;
 
-    bool isEqual(const BlobPtr<T>& other) const
+  private:
+    Array<uint64_t> words;
+    Array<uint32_t> ranks;
+    uint32_t numBits;
+    uint32_t numSetBits;
+
+    template <typename Op> void combineTo(const BitSet& other, uint64_t* result, Op op) const noexcept
     {
-        if (blob.lock() != other.blob.lock())
+        ZMEYA_ASSERT(size() == other.size());
+        const uint64_t* a = words.data();
+        const uint64_t* b = other.words.data();
+        size_t num = numWords();
+        for (size_t i = 0; i < num; i++)
         {
-            return false;
+            result[i] = op(a[i], b[i]);
         }
-        return absoluteOffset == other.absoluteOffset;
     }
 
   public:
-    explicit BlobPtr(std::weak_ptr<const BlobBuilder>&& _blob, offset_t _absoluteOffset)
-        : blob(std::move(_blob))
-        , absoluteOffset(_absoluteOffset)
-    {
-    }
+    BitSet() noexcept = default;
 
-    BlobPtr() = default;
+    ZMEYA_NODISCARD size_t size() const noexcept { return size_t(numBits); }
 
-    BlobPtr(BlobPtr&&) = default;
-    BlobPtr& operator=(BlobPtr&&) = default;
-    BlobPtr(const BlobPtr&) = default;
-    BlobPtr& operator=(const BlobPtr&) = default;
+    ZMEYA_NODISCARD size_t count() const noexcept { return size_t(numSetBits); }
 
-    template <typename T2> BlobPtr(const BlobPtr<T2>& other)
+    ZMEYA_NODISCARD bool empty() const noexcept { return numBits == 0; }
+
+    ZMEYA_NODISCARD size_t numWords() const noexcept { return words.size(); }
+
+    ZMEYA_NODISCARD const uint64_t* data() const noexcept { return words.data(); }
+
+    ZMEYA_NODISCARD bool test(const size_t index) const noexcept
     {
-        static_assert(std::is_convertible<T2*, T*>::value, "Uncompatible types");
-        blob = other.blob;
-        absoluteOffset = other.absoluteOffset;
+        ZMEYA_ASSERT(index < size());
+        uint64_t word = words[index / kBitsPerWord];
+        return ((word >> (index % kBitsPerWord)) & 1) != 0;
     }
-    template <class T2> friend class BlobPtr;
 
-    offset_t getAbsoluteOffset() const { return absoluteOffset; }
+    ZMEYA_NODISCARD bool operator[](const size_t index) const noexcept { return test(index); }
 
-    ZMEYA_NODISCARD T* get() const;
+    ZMEYA_NODISCARD size_t rank(const size_t index) const noexcept
+    {
+        ZMEYA_ASSERT(index <= size());
+        size_t wordIndex = index / kBitsPerWord;
+        size_t blockIndex = wordIndex / kWordsPerBlock;
+        size_t res = (blockIndex < ranks.size()) ? size_t(ranks[blockIndex]) : count();
+        const uint64_t* data = words.data();
+        for (size_t i = blockIndex * kWordsPerBlock; i < wordIndex; i++)
+        {
+            res += popCount64(data[i]);
+        }
+        size_t bitIndex = index % kBitsPerWord;
+        if (bitIndex != 0)
+        {
+            uint64_t mask = (uint64_t(1) << bitIndex) - 1;
+            res += popCount64(data[wordIndex] & mask);
+        }
+        return res;
+    }
 
-    T* operator->() const { return get(); }
-    T& operator*() const { return *(get()); }
+    // returns size() if k is out of range
+    ZMEYA_NODISCARD size_t select(size_t k) const noexcept
+    {
+        if (k >= count())
+        {
+            return size();
+        }
 
-    operator bool() const { return get() != nullptr; }
-    bool operator==(const BlobPtr& other) const { return isEqual(other); }
-    bool operator!=(const BlobPtr& other) const { return !isEqual(other); }
+        // find the last block with ranks[block] <= k
+        size_t lo = 0;
+        size_t hi = ranks.size();
+        while (hi - lo > 1)
+        {
+            size_t mid = (lo + hi) / 2;
+            if (size_t(ranks[mid]) <= k)
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
 
-    template <typename T2> friend class Pointer;
-};
-
-/*
-    Blob allocator - aligned allocator for internal Blob usage
-*/
-template <typename T, int Alignment> class BlobBuilderAllocator : public std::allocator<T>
-{
-  public:
-    typedef size_t size_type;
-    typedef T* pointer;
-    typedef const T* const_pointer;
-
-    template <typename _Tp1> struct rebind
-    {
-        typedef BlobBuilderAllocator<_Tp1, Alignment> other;
-    };
-
-    pointer allocate(size_type n)
-    {
-        const size_t alignment = Alignment;
-        void* const pv = ZMEYA_ALLOC(n * sizeof(T), alignment);
-        return static_cast<pointer>(pv);
+        k -= size_t(ranks[lo]);
+        const uint64_t* data = words.data();
+        size_t wordIndex = lo * kWordsPerBlock;
+        for (;; wordIndex++)
+        {
+            ZMEYA_ASSERT(wordIndex < numWords());
+            size_t wordCount = popCount64(data[wordIndex]);
+            if (k < wordCount)
+            {
+                break;
+            }
+            k -= wordCount;
+        }
+        return wordIndex * kBitsPerWord + selectInWord64(data[wordIndex], uint32_t(k));
     }
 
-    void deallocate(pointer p, size_type)
+    // result = this & other (result must have at least numWords() elements)
+    void andTo(const BitSet& other, uint64_t* result) const noexcept
     {
-        //
-        ZMEYA_FREE(p);
+        combineTo(other, result, [](uint64_t a, uint64_t b) { return a & b; });
     }
 
-    BlobBuilderAllocator()
-        : std::allocator<T>()
+    // result = this | other (result must have at least numWords() elements)
+    void orTo(const BitSet& other, uint64_t* result) const noexcept
     {
+        combineTo(other, result, [](uint64_t a, uint64_t b) { return a | b; });
     }
-    BlobBuilderAllocator(const BlobBuilderAllocator& a)
-        : std::allocator<T>(a)
+
+    // result = this & ~other (result must have at least numWords() elements)
+    void andNotTo(const BitSet& other, uint64_t* result) const noexcept
     {
+        combineTo(other, result, [](uint64_t a, uint64_t b) { return a & ~b; });
     }
-    template <class U>
-    BlobBuilderAllocator(const BlobBuilderAllocator<U, Alignment>& a)
-        : std::allocator<T>(a)
+
+    // call func(index) for every set bit (in ascending order)
+    template <typename Func> void forEachSetBit(Func func) const
     {
+        const uint64_t* data = words.data();
+        size_t num = numWords();
+        for (size_t wordIndex = 0; wordIndex < num; wordIndex++)
+        {
+            uint64_t word = data[wordIndex];
+            while (word != 0)
+            {
+                size_t index = wordIndex * kBitsPerWord + countTrailingZeros64(word);
+                func(index);
+                word &= word - 1;
+            }
+        }
     }
+
+    friend class BlobBuilder;
 };
 
 /*
-
-    Span
-
+    JaggedArray - array of variable length rows
+    all rows are stored in one contiguous values array, row(i) = values[offsets[i], offsets[i + 1])
 */
-template <typename T> struct Span
+template <typename T> class JaggedArray
 {
-    T* data = nullptr;
-    size_t size = 0;
+    Array<uint32_t> offsets;
+    Array<T> values;
 
-    Span() = default;
-    Span(T* _data, size_t _size)
-        : data(_data)
-        , size(_size)
-    {
-    }
-};
+  public:
+    JaggedArray() noexcept = default;
 
-template <typename T> std::weak_ptr<T> weak_from(T* p)
-{
-    std::shared_ptr<T> shared = p->shared_from_this();
-    return shared;
-}
+    // number of rows
+    ZMEYA_NODISCARD size_t size() const noexcept { return offsets.empty() ? 0 : offsets.size() - 1; }
 
-/*
-    Blob - a binary blob of data that is able to store POD types and special
-   "movable" data structures Note: Zmeya containers can be freely moved in
-   memory and deserialize from raw bytes without any extra work.
-*/
-class BlobBuilder : public std::enable_shared_from_this<BlobBuilder>
-{
-    std::vector<char, BlobBuilderAllocator<char, ZMEYA_MAX_ALIGN>> data;
+    ZMEYA_NODISCARD bool empty() const noexcept { return size() == 0; }
 
-  private:
-    ZMEYA_NODISCARD const char* get(offset_t absoluteOffset) const
+    // total number of elements (in all rows)
+    ZMEYA_NODISCARD size_t numValues() const noexcept { return values.size(); }
+
+    ZMEYA_NODISCARD const T* data() const noexcept { return values.data(); }
+
+    ZMEYA_NODISCARD size_t rowSize(const size_t index) const noexcept
     {
-        ZMEYA_ASSERT(absoluteOffset < data.size());
-        return &data[absoluteOffset];
+        ZMEYA_ASSERT(index < size());
+        return size_t(offsets[index + 1] - offsets[index]);
     }
 
-    template <typename T> ZMEYA_NODISCARD BlobPtr<T> getBlobPtr(const T* p) const
+    ZMEYA_NODISCARD Span<const T> row(const size_t index) const noexcept
     {
-        ZMEYA_ASSERT(containsPointer(p));
-        offset_t absoluteOffset = diffAddr(uintptr_t(p), uintptr_t(data.data()));
-        return BlobPtr<T>(weak_from(this), absoluteOffset);
+        ZMEYA_ASSERT(index < size());
+        uint32_t first = offsets[index];
+        uint32_t last = offsets[index + 1];
+        return Span<const T>(values.data() + first, size_t(last - first));
     }
 
-    struct PrivateToken
-    {
-    };
+    ZMEYA_NODISCARD Span<const T> operator[](const size_t index) const noexcept { return row(index); }
 
-  public:
-    BlobBuilder() = delete;
+    friend class BlobBuilder;
+};
 
-    BlobBuilder(size_t initialSizeInBytes, PrivateToken)
-    {
-        static_assert(std::is_trivially_copyable<Pointer<int>>::value, "Pointer is_trivially_copyable check failed");
-        static_assert(std::is_trivially_copyable<Array<int>>::value, "Array is_trivially_copyable check failed");
-        static_assert(std::is_trivially_copyable<HashSet<int>>::value, "HashSet is_trivially_copyable check failed");
-        static_assert(std::is_trivially_copyable<Pair<int, float>>::value, "Pair is_trivially_copyable check failed");
-        static_assert(std::is_trivially_copyable<HashMap<int, int>>::value, "HashMap is_trivially_copyable check failed");
-        static_assert(std::is_trivially_copyable<String>::value, "String is_trivially_copyable check failed");
+/*
+    Graph - directed graph stored in the compressed sparse row (CSR) form
+    neighbors(i) = edgeTargets[edgeOffsets[i], edgeOffsets[i + 1])
+    Note: traversal functions prefetch node data of the discovered neighbors
+*/
+struct GraphNoEdgeData
+{
+};
 
-        data.reserve(initialSizeInBytes);
+template <typename NodeData, typename EdgeData = GraphNoEdgeData> class Graph
+{
+    Array<NodeData> nodes;
+    Array<uint32_t> edgeOffsets;
+    Array<uint32_t> edgeTargets;
+    // empty if EdgeData is an empty type
+    Array<EdgeData> edges;
+    // node index -> node index in the source adjacency list (empty if the nodes were not reordered)
+    Array<uint32_t> originalIndices;
+
+    void prefetchNode(uint32_t index) const noexcept
+    {
+        ZMEYA_PREFETCH(nodes.data() + index);
+        ZMEYA_PREFETCH(edgeOffsets.data() + index);
     }
 
-    ~BlobBuilder() = default;
+  public:
+    Graph() noexcept = default;
 
-    bool containsPointer(const void* p) const { return (!data.empty() && (p >= &data.front() && p <= &data.back())); }
+    ZMEYA_NODISCARD size_t numNodes() const noexcept { return nodes.size(); }
 
-    BlobPtr<char> allocate(size_t numBytes, size_t alignment)
-    {
-        ZMEYA_ASSERT(isPowerOfTwo(alignment));
-        ZMEYA_ASSERT(alignment < ZMEYA_MAX_ALIGN);
-        //
-        size_t cursor = data.size();
+    ZMEYA_NODISCARD size_t numEdges() const noexcept { return edgeTargets.size(); }
 
-        // padding / alignment
-        size_t off = cursor & (alignment - 1);
-        size_t padding = 0;
-        if (off != 0)
-        {
-            padding = alignment - off;
-        }
-        size_t absoluteOffset = cursor + padding;
-        size_t numBytesToAllocate = numBytes + padding;
+    ZMEYA_NODISCARD bool empty() const noexcept { return nodes.empty(); }
 
-        // Allocate more memory
-        // Note: new memory is filled with zeroes
-        // Zmeya containers rely on this behavior and we want to have all the padding zeroed as well
-        data.resize(data.size() + numBytesToAllocate, char(0));
+    ZMEYA_NODISCARD const NodeData& node(const size_t index) const noexcept { return nodes[index]; }
 
-        // check alignment
-        ZMEYA_ASSERT((uintptr_t(&data[absoluteOffset]) & (alignment - 1)) == 0);
-        ZMEYA_ASSERT(absoluteOffset < size_t(std::numeric_limits<offset_t>::max()));
-        return BlobPtr<char>(weak_from(this), offset_t(absoluteOffset));
+    ZMEYA_NODISCARD size_t degree(const size_t index) const noexcept
+    {
+        ZMEYA_ASSERT(index < numNodes());
+        return size_t(edgeOffsets[index + 1] - edgeOffsets[index]);
     }
 
-    template <typename T, typename... _Valty> void placementCtor(void* ptr, _Valty&&... _Val)
+    ZMEYA_NODISCARD Span<const uint32_t> neighbors(const size_t index) const noexcept
     {
-        ::new (const_cast<void*>(static_cast<const volatile void*>(ptr))) T(std::forward<_Valty>(_Val)...);
+        ZMEYA_ASSERT(index < numNodes());
+        uint32_t first = edgeOffsets[index];
+        return Span<const uint32_t>(edgeTargets.data() + first, size_t(edgeOffsets[index + 1] - first));
     }
 
-    template <typename T, typename... _Valty> BlobPtr<T> allocate(_Valty&&... _Val)
+    ZMEYA_NODISCARD Span<const EdgeData> edgeData(const size_t index) const noexcept
     {
-        // compile time checks
-        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types allowed");
-        constexpr size_t alignOfT = std::alignment_of<T>::value;
-        static_assert(isPowerOfTwo(alignOfT), "Non power of two alignment not supported");
-        static_assert(alignOfT < ZMEYA_MAX_ALIGN, "Unsupported alignment");
-        constexpr size_t sizeOfT = sizeof(T);
-
-        BlobPtr<char> ptr = allocate(sizeOfT, alignOfT);
-
-        placementCtor<T>(ptr.get(), std::forward<_Valty>(_Val)...);
-
-        return BlobPtr<T>(weak_from(this), ptr.getAbsoluteOffset());
+        static_assert(!std::is_empty<EdgeData>::value, "Graph has no edge data");
+        ZMEYA_ASSERT(index < numNodes());
+        uint32_t first = edgeOffsets[index];
+        return Span<const EdgeData>(edges.data() + first, size_t(edgeOffsets[index + 1] - first));
     }
 
-    template <typename T> T* getDirectMemoryAccessUnsafe(offset_t absoluteOffset)
+    ZMEYA_NODISCARD size_t originalIndex(const size_t index) const noexcept
     {
-        const char* p = get(absoluteOffset);
-        return const_cast<T*>(reinterpret_cast<const T*>(p));
+        return originalIndices.empty() ? index : size_t(originalIndices[index]);
     }
 
-    template <typename T> void setArrayOffset(const BlobPtr<Array<T>>& dst, offset_t absoluteOffset)
+    // breadth-first traversal, func(nodeIndex, nodeData)
+    template <typename Func> void bfs(const size_t start, Func func) const
     {
-        dst->relativeOffset = toRelativeOffset(diff(absoluteOffset, dst.getAbsoluteOffset()));
+        ZMEYA_ASSERT(start < numNodes());
+        std::vector<uint8_t> visited(numNodes(), uint8_t(0));
+        std::vector<uint32_t> queue;
+        queue.push_back(uint32_t(start));
+        visited[start] = 1;
+        for (size_t head = 0; head < queue.size(); head++)
+        {
+            uint32_t index = queue[head];
+            for (uint32_t next : neighbors(index))
+            {
+                if (visited[next] == 0)
+                {
+                    visited[next] = 1;
+                    prefetchNode(next);
+                    queue.push_back(next);
+                }
+            }
+            func(size_t(index), nodes[index]);
+        }
     }
 
-    template <typename T> offset_t resizeArrayWithoutInitialization(Array<T>& _dst, size_t numElements)
+    // depth-first (pre-order) traversal, func(nodeIndex, nodeData)
+    template <typename Func> void dfs(const size_t start, Func func) const
     {
-        constexpr size_t alignOfT = std::alignment_of<T>::value;
-        constexpr size_t sizeOfT = sizeof(T);
-        static_assert((sizeOfT % alignOfT) == 0, "The size must be a multiple of the alignment");
-
-        BlobPtr<Array<T>> dst = getBlobPtr(&_dst);
-        // An array can be assigned/resized only once (non empty array detected)
-        ZMEYA_ASSERT(dst->relativeOffset == 0 && dst->numElements == 0);
+        ZMEYA_ASSERT(start < numNodes());
+        std::vector<uint8_t> visited(numNodes(), uint8_t(0));
+        std::vector<uint32_t> stack;
+        stack.push_back(uint32_t(start));
+        while (!stack.empty())
+        {
+            uint32_t index = stack.back();
+            stack.pop_back();
+            if (visited[index] != 0)
+            {
+                continue;
+            }
+            visited[index] = 1;
 
-        BlobPtr<char> arrData = allocate(sizeOfT * numElements, alignOfT);
-        ZMEYA_ASSERT(numElements < size_t(std::numeric_limits<uint32_t>::max()));
-        dst->numElements = uint32_t(numElements);
-        setArrayOffset(dst, arrData.getAbsoluteOffset());
-        return arrData.getAbsoluteOffset();
+            // push in reverse order to visit the first neighbor first
+            Span<const uint32_t> adj = neighbors(index);
+            for (size_t i = adj.size; i > 0; i--)
+            {
+                uint32_t next = adj[i - 1];
+                if (visited[next] == 0)
+                {
+                    prefetchNode(next);
+                    stack.push_back(next);
+                }
+            }
+            func(size_t(index), nodes[index]);
+        }
     }
 
-    // get writeable pointer to array element
-    template <typename T> ZMEYA_NODISCARD BlobPtr<T> getArrayElement(Array<T>& arr, const size_t index) const noexcept
+    // topological order (Kahn's algorithm), returns false if the graph has a cycle
+    bool topologicalOrder(std::vector<uint32_t>& order) const
     {
-        T* rawElementPtr = arr.getData() + index;
-        BlobPtr<T> element = getBlobPtr(rawElementPtr);
-        return element;
-    }
+        size_t num = numNodes();
+        std::vector<uint32_t> inDegree(num, 0);
+        const uint32_t* targets = edgeTargets.data();
+        for (size_t i = 0; i < numEdges(); i++)
+        {
+            inDegree[targets[i]]++;
+        }
 
-    // resize array (using copy constructor)
-    template <typename T> offset_t resizeArray(Array<T>& _dst, size_t numElements, const T& emptyElement)
-    {
-        BlobPtr<Array<T>> dst = getBlobPtr(&_dst);
-        offset_t absoluteOffset = resizeArrayWithoutInitialization(_dst, numElements);
-        T* current = getDirectMemoryAccessUnsafe<T>(absoluteOffset);
-        for (size_t i = 0; i < numElements; i++)
+        order.clear();
+        order.reserve(num);
+        for (size_t i = 0; i < num; i++)
         {
-            // call copy ctor
-            placementCtor<T>(current, emptyElement);
-            current++;
+            if (inDegree[i] == 0)
+            {
+                order.push_back(uint32_t(i));
+            }
         }
-        return absoluteOffset;
-    }
 
-    // resize array (using default constructor)
-    template <typename T> offset_t resizeArray(Array<T>& _dst, size_t numElements)
-    {
-        BlobPtr<Array<T>> dst = getBlobPtr(&_dst);
-        offset_t absoluteOffset = resizeArrayWithoutInitialization(_dst, numElements);
-        T* current = getDirectMemoryAccessUnsafe<T>(absoluteOffset);
-        for (size_t i = 0; i < numElements; i++)
+        for (size_t head = 0; head < order.size(); head++)
         {
-            // default ctor
-            placementCtor<T>(current);
-            current++;
+            for (uint32_t next : neighbors(order[head]))
+            {
+                inDegree[next]--;
+                if (inDegree[next] == 0)
+                {
+                    prefetchNode(next);
+                    order.push_back(next);
+                }
+            }
         }
-        return absoluteOffset;
+        return order.size() == num;
     }
 
-    // copyTo array fast (without using convertor)
-    template <typename T> offset_t copyToArrayFast(BlobPtr<Array<T>> dst, const T* begin, size_t numElements)
+    friend class BlobBuilder;
+};
+
+/*
+    Axis aligned bounding box
+*/
+struct Aabb
+{
+    float min[3];
+    float max[3];
+
+    Aabb() noexcept = default;
+
+    Aabb(float minX, float minY, float minZ, float maxX, float maxY, float maxZ) noexcept
+        : min{minX, minY, minZ}
+        , max{maxX, maxY, maxZ}
     {
-        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types allowed");
-        offset_t absoluteOffset = resizeArrayWithoutInitialization(*dst, numElements);
-        T* arrData = getDirectMemoryAccessUnsafe<T>(absoluteOffset);
-        std::memcpy(arrData, begin, sizeof(T) * numElements);
-        return absoluteOffset;
     }
 
-    // copyTo array fast (without using convertor)
-    template <typename T> offset_t copyToArrayFast(Array<T>& _dst, const T* begin, size_t numElements)
+    ZMEYA_NODISCARD static Aabb invalid() noexcept
     {
-        BlobPtr<Array<T>> dst = getBlobPtr(&_dst);
-        return copyToArrayFast(dst, begin, numElements);
+        const float inf = std::numeric_limits<float>::infinity();
+        return Aabb(inf, inf, inf, -inf, -inf, -inf);
     }
 
-    // copyTo array from range
-    template <typename T, typename Iter, typename ConvertorFunc>
-    offset_t copyToArray(BlobPtr<Array<T>> dst, const Iter begin, const Iter end, int64_t size, ConvertorFunc convertorFunc)
+    void grow(const Aabb& other) noexcept
     {
-        size_t numElements = (size >= 0) ? size_t(size) : std::distance(begin, end);
-        resizeArray(*dst, numElements);
-
-        BlobPtr<T> firstElement = getBlobPtr(dst->data());
-        offset_t absoluteOffset = firstElement.getAbsoluteOffset();
-        offset_t currentIndex = 0;
-        for (Iter cur = begin; cur != end; ++cur)
+        for (int axis = 0; axis < 3; axis++)
         {
-            offset_t currentItemAbsoluteOffset = absoluteOffset + sizeof(T) * currentIndex;
-            convertorFunc(this, currentItemAbsoluteOffset, *cur);
-            currentIndex++;
+            min[axis] = (other.min[axis] < min[axis]) ? other.min[axis] : min[axis];
+            max[axis] = (other.max[axis] > max[axis]) ? other.max[axis] : max[axis];
         }
-        return absoluteOffset;
     }
 
-    // copyTo array from range
-    template <typename T, typename Iter, typename ConvertorFunc>
-    offset_t copyToArray(Array<T>& _dst, const Iter begin, const Iter end, int64_t size, ConvertorFunc convertorFunc)
+    void grow(const float point[3]) noexcept
     {
-        BlobPtr<Array<T>> dst = getBlobPtr(&_dst);
-        return copyToArray(dst, begin, end, size, convertorFunc);
+        for (int axis = 0; axis < 3; axis++)
+        {
+            min[axis] = (point[axis] < min[axis]) ? point[axis] : min[axis];
+            max[axis] = (point[axis] > max[axis]) ? point[axis] : max[axis];
+        }
     }
 
-    // copyTo hash container
-    template <typename ItemSrcAdapter, typename ItemDstAdapter, typename HashType, typename Iter, typename ConvertorFunc>
-    void copyToHash(HashType& _dst, Iter begin, Iter end, int64_t size, ConvertorFunc convertorFunc)
+    ZMEYA_NODISCARD float surfaceArea() const noexcept
     {
-        // Note: this bucketing method relies on the fact that the input data set is (already) unique
-        size_t numElements = (size >= 0) ? size_t(size) : std::distance(begin, end);
-        ZMEYA_ASSERT(numElements > 0);
-        size_t numBuckets = numElements * 2;
-        ZMEYA_ASSERT(numBuckets < size_t(std::numeric_limits<uint32_t>::max()));
-        size_t hashMod = numBuckets;
-
-        BlobPtr<HashType> dst = getBlobPtr(&_dst);
-        // allocate buckets & items
-        resizeArray(dst->buckets, numBuckets);
-
-        // 1-st pass count the number of elements per bucket (beginIndex / endIndex)
-        typename HashType::Bucket* buckets = dst->buckets.get_raw_ptr_unsafe_can_be_relocated();
-        for (Iter cur = begin; cur != end; ++cur)
+        float dx = max[0] - min[0];
+        float dy = max[1] - min[1];
+        float dz = max[2] - min[2];
+        if (dx < 0.0f || dy < 0.0f || dz < 0.0f)
         {
-            const auto& current = *cur;
-            size_t hash = ItemSrcAdapter::hash(current);
-            size_t bucketIndex = hash % hashMod;
-            buckets[bucketIndex].beginIndex++; // temporary use beginIndex to store the number of items
+            return 0.0f;
         }
+        return 2.0f * (dx * dy + dy * dz + dz * dx);
+    }
 
-        size_t beginIndex = 0;
-        for (size_t bucketIndex = 0; bucketIndex < numBuckets; bucketIndex++)
-        {
-            typename HashType::Bucket& bucket = buckets[bucketIndex];
-            size_t numElementsInBucket = bucket.beginIndex;
-            bucket.beginIndex = uint32_t(beginIndex);
+    ZMEYA_NODISCARD bool overlaps(const Aabb& other) const noexcept
+    {
+        return min[0] <= other.max[0] && other.min[0] <= max[0] && min[1] <= other.max[1] && other.min[1] <= max[1] &&
+               min[2] <= other.max[2] && other.min[2] <= max[2];
+    }
+
+    // squared distance from the point to the box (zero if the point is inside)
+    ZMEYA_NODISCARD float distanceSq(const float point[3]) const noexcept
+    {
+        float res = 0.0f;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float d = 0.0f;
+            if (point[axis] < min[axis])
+            {
+                d = min[axis] - point[axis];
+            }
+            else if (point[axis] > max[axis])
+            {
+                d = point[axis] - max[axis];
+            }
+            res += d * d;
+        }
+        return res;
+    }
+};
+
+/*
+    Ray (dir does not need to be normalized, hit distances are measured in dir units)
+*/
+struct Ray
+{
+    float origin[3];
+    float dir[3];
+};
+
+/*
+    BVH node: leaf if count > 0 (items [index, index + count)), otherwise an inner node
+    inner node children are: (this + 1) and nodes[index] (depth-first order)
+*/
+struct BvhNode
+{
+    Aabb bounds;
+    uint32_t index;
+    uint32_t count;
+};
+
+/*
+    BVH - bounding volume hierarchy over items of type T, built with the binned SAH
+*/
+template <typename T> class BVH
+{
+    Array<BvhNode> nodes;
+    // item bounds (parallel to the items array)
+    Array<Aabb> itemBounds;
+    Array<T> items;
+
+  public:
+    // max traversal stack depth (the builder never produces deeper trees)
+    static constexpr size_t kMaxDepth = 64;
+
+  private:
+    struct RayData
+    {
+        float origin[4];
+        float invDir[4];
+    };
+
+#ifdef ZMEYA_SSE2
+    // load box min/max without reading outside of the box (lane 3 is undefined)
+    static void loadAabb(const Aabb& box, __m128& boxMin, __m128& boxMax) noexcept
+    {
+        // the box is loaded as 6 consecutive floats (min0, min1, min2, max0, max1, max2)
+        static_assert(offsetof(Aabb, max) == 3 * sizeof(float) && sizeof(Aabb) == 6 * sizeof(float), "Unexpected Aabb layout");
+        // (min0, min1, min2, max0)
+        boxMin = _mm_loadu_ps(&box.min[0]);
+        // (min2, max0, max1, max2) -> (max0, max1, max2, max2)
+        __m128 v = _mm_loadu_ps(&box.min[2]);
+        boxMax = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 2, 1));
+    }
+#endif
+
+    // returns true if the ray hits the box within [0, tMax], tEnter = entry distance
+    static bool intersect(const RayData& ray, const Aabb& box, float tMax, float& tEnter) noexcept
+    {
+#ifdef ZMEYA_SSE2
+        // note: lane 3 contains garbage and it's replaced with lane 0 before reduction
+        __m128 origin = _mm_loadu_ps(ray.origin);
+        __m128 invDir = _mm_loadu_ps(ray.invDir);
+        __m128 boxMin, boxMax;
+        loadAabb(box, boxMin, boxMax);
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(boxMin, origin), invDir);
+        __m128 t2 = _mm_mul_ps(_mm_sub_ps(boxMax, origin), invDir);
+        // the ray is parallel to the axis and the origin lies on the slab plane (0 * inf = NaN): the axis does not limit the hit
+        __m128 parallel = _mm_cmpunord_ps(t1, t2);
+        const __m128 inf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+        __m128 tNear = _mm_or_ps(_mm_andnot_ps(parallel, _mm_min_ps(t1, t2)), _mm_and_ps(parallel, _mm_sub_ps(_mm_setzero_ps(), inf)));
+        __m128 tFar = _mm_or_ps(_mm_andnot_ps(parallel, _mm_max_ps(t1, t2)), _mm_and_ps(parallel, inf));
+        tNear = _mm_shuffle_ps(tNear, tNear, _MM_SHUFFLE(0, 2, 1, 0));
+        tFar = _mm_shuffle_ps(tFar, tFar, _MM_SHUFFLE(0, 2, 1, 0));
+        tNear = _mm_max_ps(tNear, _mm_shuffle_ps(tNear, tNear, _MM_SHUFFLE(2, 3, 0, 1)));
+        tNear = _mm_max_ps(tNear, _mm_shuffle_ps(tNear, tNear, _MM_SHUFFLE(1, 0, 3, 2)));
+        tFar = _mm_min_ps(tFar, _mm_shuffle_ps(tFar, tFar, _MM_SHUFFLE(2, 3, 0, 1)));
+        tFar = _mm_min_ps(tFar, _mm_shuffle_ps(tFar, tFar, _MM_SHUFFLE(1, 0, 3, 2)));
+        float tn = _mm_cvtss_f32(tNear);
+        float tf = _mm_cvtss_f32(tFar);
+#else
+        float tn = 0.0f;
+        float tf = tMax;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float t1 = (box.min[axis] - ray.origin[axis]) * ray.invDir[axis];
+            float t2 = (box.max[axis] - ray.origin[axis]) * ray.invDir[axis];
+            // the ray is parallel to the axis and the origin lies on the slab plane (0 * inf = NaN): the axis does not limit the hit
+            if (t1 != t1 || t2 != t2)
+            {
+                continue;
+            }
+            float tAxisNear = (t1 < t2) ? t1 : t2;
+            float tAxisFar = (t1 < t2) ? t2 : t1;
+            tn = (tAxisNear > tn) ? tAxisNear : tn;
+            tf = (tAxisFar < tf) ? tAxisFar : tf;
+        }
+#endif
+        tn = (tn > 0.0f) ? tn : 0.0f;
+        tf = (tf < tMax) ? tf : tMax;
+        tEnter = tn;
+        return tn <= tf;
+    }
+
+    // box = (min[0], min[1], min[2], <unused>, max[0], max[1], max[2], <unused>)
+    static bool overlaps(const Aabb& node, const float box[8]) noexcept
+    {
+#ifdef ZMEYA_SSE2
+        __m128 nodeMin, nodeMax;
+        loadAabb(node, nodeMin, nodeMax);
+        __m128 le1 = _mm_cmple_ps(nodeMin, _mm_loadu_ps(box + 4));
+        __m128 le2 = _mm_cmple_ps(_mm_loadu_ps(box), nodeMax);
+        return (_mm_movemask_ps(_mm_and_ps(le1, le2)) & 7) == 7;
+#else
+        return node.min[0] <= box[4] && box[0] <= node.max[0] && node.min[1] <= box[5] && box[1] <= node.max[1] &&
+               node.min[2] <= box[6] && box[2] <= node.max[2];
+#endif
+    }
+
+  public:
+    BVH() noexcept = default;
+
+    ZMEYA_NODISCARD size_t size() const noexcept { return items.size(); }
+
+    ZMEYA_NODISCARD bool empty() const noexcept { return items.empty(); }
+
+    ZMEYA_NODISCARD size_t numNodes() const noexcept { return nodes.size(); }
+
+    ZMEYA_NODISCARD const Aabb& bounds() const noexcept { return nodes[0].bounds; }
+
+    // items in the BVH (leaf) order
+    ZMEYA_NODISCARD const T* begin() const noexcept { return items.begin(); }
+    ZMEYA_NODISCARD const T* end() const noexcept { return items.end(); }
+
+    ZMEYA_NODISCARD const Aabb& itemBox(const T& item) const noexcept
+    {
+        ZMEYA_ASSERT(&item >= items.begin() && &item < items.end());
+        return itemBounds[size_t(&item - items.begin())];
+    }
+
+    // call func(item) for every item which bounding box overlaps the box
+    template <typename Func> void overlap(const Aabb& box, Func func) const
+    {
+        if (nodes.empty())
+        {
+            return;
+        }
+        const float boxData[8] = {box.min[0], box.min[1], box.min[2], 0.0f, box.max[0], box.max[1], box.max[2], 0.0f};
+        const BvhNode* nodesData = nodes.data();
+        uint32_t stack[kMaxDepth];
+        size_t stackSize = 0;
+        uint32_t current = 0;
+        for (;;)
+        {
+            const BvhNode& node = nodesData[current];
+            if (overlaps(node.bounds, boxData))
+            {
+                if (node.count > 0)
+                {
+                    for (uint32_t i = node.index; i < node.index + node.count; i++)
+                    {
+                        if (overlaps(itemBounds[i], boxData))
+                        {
+                            func(items[i]);
+                        }
+                    }
+                }
+                else
+                {
+                    ZMEYA_ASSERT(stackSize < kMaxDepth);
+                    stack[stackSize++] = node.index;
+                    current++;
+                    continue;
+                }
+            }
+            if (stackSize == 0)
+            {
+                break;
+            }
+            current = stack[--stackSize];
+        }
+    }
+
+    // ray query (closest child first)
+    // func(item, tMax) should return the hit distance (or any value >= tMax if there is no hit)
+    // returns the closest hit distance (or tMax if nothing was hit)
+    template <typename Func> float raycast(const Ray& ray, float tMax, Func func) const
+    {
+        if (nodes.empty())
+        {
+            return tMax;
+        }
+
+        RayData rayData;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            rayData.origin[axis] = ray.origin[axis];
+            rayData.invDir[axis] = 1.0f / ray.dir[axis];
+        }
+        rayData.origin[3] = 0.0f;
+        rayData.invDir[3] = 0.0f;
+
+        const BvhNode* nodesData = nodes.data();
+        uint32_t stack[kMaxDepth];
+        size_t stackSize = 0;
+        float tEnter;
+        if (!intersect(rayData, nodesData[0].bounds, tMax, tEnter))
+        {
+            return tMax;
+        }
+
+        uint32_t current = 0;
+        for (;;)
+        {
+            const BvhNode& node = nodesData[current];
+            if (node.count > 0)
+            {
+                for (uint32_t i = node.index; i < node.index + node.count; i++)
+                {
+                    if (!intersect(rayData, itemBounds[i], tMax, tEnter))
+                    {
+                        continue;
+                    }
+                    float t = func(items[i], tMax);
+                    tMax = (t < tMax) ? t : tMax;
+                }
+            }
+            else
+            {
+                uint32_t left = current + 1;
+                uint32_t right = node.index;
+                float tLeft, tRight;
+                bool hitLeft = intersect(rayData, nodesData[left].bounds, tMax, tLeft);
+                bool hitRight = intersect(rayData, nodesData[right].bounds, tMax, tRight);
+                if (hitLeft && hitRight)
+                {
+                    ZMEYA_ASSERT(stackSize < kMaxDepth);
+                    if (tRight < tLeft)
+                    {
+                        stack[stackSize++] = left;
+                        current = right;
+                    }
+                    else
+                    {
+                        stack[stackSize++] = right;
+                        current = left;
+                    }
+                    continue;
+                }
+                if (hitLeft || hitRight)
+                {
+                    current = hitLeft ? left : right;
+                    continue;
+                }
+            }
+
+            // pop (skip nodes that are further than the closest hit)
+            bool found = false;
+            while (stackSize > 0)
+            {
+                current = stack[--stackSize];
+                if (intersect(rayData, nodesData[current].bounds, tMax, tEnter))
+                {
+                    found = true;
+                    break;
+                }
+            }
+            if (!found)
+            {
+                break;
+            }
+        }
+        return tMax;
+    }
+
+    // find k nearest items to the point
+    // distanceSqFunc(item, point) should return the squared distance from the point to the item
+    // result is sorted by distance (closest first)
+    template <typename Func>
+    void nearest(const float point[3], size_t k, Func distanceSqFunc, std::vector<std::pair<float, const T*>>& result) const
+    {
+        result.clear();
+        if (nodes.empty() || k == 0)
+        {
+            return;
+        }
+
+        auto cmp = [](const std::pair<float, const T*>& a, const std::pair<float, const T*>& b) { return a.first < b.first; };
+        const BvhNode* nodesData = nodes.data();
+        // (distance, node) pairs
+        std::pair<float, uint32_t> stack[kMaxDepth];
+        size_t stackSize = 0;
+        stack[stackSize++] = std::make_pair(nodesData[0].bounds.distanceSq(point), uint32_t(0));
+        while (stackSize > 0)
+        {
+            std::pair<float, uint32_t> top = stack[--stackSize];
+            // result is a max-heap of the best k candidates
+            if (result.size() == k && top.first > result.front().first)
+            {
+                continue;
+            }
+
+            const BvhNode& node = nodesData[top.second];
+            if (node.count > 0)
+            {
+                for (uint32_t i = node.index; i < node.index + node.count; i++)
+                {
+                    if (result.size() == k && itemBounds[i].distanceSq(point) > result.front().first)
+                    {
+                        continue;
+                    }
+                    const T& item = items[i];
+                    float d = distanceSqFunc(item, point);
+                    if (result.size() < k)
+                    {
+                        result.emplace_back(d, &item);
+                        std::push_heap(result.begin(), result.end(), cmp);
+                    }
+                    else if (d < result.front().first)
+                    {
+                        std::pop_heap(result.begin(), result.end(), cmp);
+                        result.back() = std::make_pair(d, &item);
+                        std::push_heap(result.begin(), result.end(), cmp);
+                    }
+                }
+                continue;
+            }
+
+            // push the farthest child first (the closest one is processed next)
+            uint32_t left = top.second + 1;
+            uint32_t right = node.index;
+            float dLeft = nodesData[left].bounds.distanceSq(point);
+            float dRight = nodesData[right].bounds.distanceSq(point);
+            ZMEYA_ASSERT(stackSize + 2 <= kMaxDepth);
+            if (dLeft < dRight)
+            {
+                stack[stackSize++] = std::make_pair(dRight, right);
+                stack[stackSize++] = std::make_pair(dLeft, left);
+            }
+            else
+            {
+                stack[stackSize++] = std::make_pair(dLeft, left);
+                stack[stackSize++] = std::make_pair(dRight, right);
+            }
+        }
+        std::sort_heap(result.begin(), result.end(), cmp);
+    }
+
+    friend class BlobBuilder;
+};
+
+/*
+    Interval [start, end] (inclusive) with the associated value
+*/
+template <typename K, typename V> struct Interval
+{
+    K start;
+    K end;
+    V value;
+};
+
+/*
+    IntervalIndex - static interval index, overlap and stabbing queries cost O(log n + k)
+    overlap(first, last) reports two disjoint sets of intervals
+    1. intervals that start inside [first, last] (binary search over the intervals sorted by start)
+    2. intervals that start before 'first' and contain it (stabbing query over the centered interval tree)
+    every tree node stores the intervals that contain its center, sorted by start and by end
+*/
+template <typename K, typename V> class IntervalIndex
+{
+  public:
+    struct Node
+    {
+        K center;
+        // node intervals range in the byStart/byEnd arrays
+        uint32_t first;
+        uint32_t count;
+        // child nodes: intervals that end before the center (left) and start after the center (right)
+        // zero means no child (the root node is never a child)
+        uint32_t left;
+        uint32_t right;
+    };
+
+  private:
+    // sorted by start
+    Array<Interval<K, V>> intervals;
+    Array<Node> nodes;
+    // node intervals (indices in the intervals array) sorted by start ascending and by end descending
+    Array<uint32_t> byStart;
+    Array<uint32_t> byEnd;
+
+  public:
+    IntervalIndex() noexcept = default;
+
+    ZMEYA_NODISCARD size_t size() const noexcept { return intervals.size(); }
+
+    ZMEYA_NODISCARD bool empty() const noexcept { return intervals.empty(); }
+
+    // call func(start, end, value) for every interval that overlaps [first, last]
+    template <typename Func> void overlap(const K& first, const K& last, Func func) const
+    {
+        if (empty())
+        {
+            return;
+        }
+        const Interval<K, V>* items = intervals.data();
+
+        // intervals that start before 'first' and contain it (a single root to leaf path)
+        uint32_t nodeIndex = 0;
+        for (;;)
+        {
+            const Node& node = nodes[nodeIndex];
+            if (node.center < first)
+            {
+                // all the node intervals start before 'first'
+                const uint32_t* ids = byEnd.data() + node.first;
+                for (uint32_t i = 0; i < node.count && !(items[ids[i]].end < first); i++)
+                {
+                    const Interval<K, V>& item = items[ids[i]];
+                    func(item.start, item.end, item.value);
+                }
+                nodeIndex = node.right;
+            }
+            else
+            {
+                // all the node intervals contain 'first' (they end at or after the center)
+                const uint32_t* ids = byStart.data() + node.first;
+                for (uint32_t i = 0; i < node.count && items[ids[i]].start < first; i++)
+                {
+                    const Interval<K, V>& item = items[ids[i]];
+                    func(item.start, item.end, item.value);
+                }
+                // the left subtree ends before the center, the right subtree starts after it
+                nodeIndex = (first < node.center) ? node.left : 0;
+            }
+            if (nodeIndex == 0)
+            {
+                break;
+            }
+        }
+
+        // intervals that start inside [first, last]
+        size_t lo = 0;
+        size_t hi = size();
+        while (lo < hi)
+        {
+            size_t mid = lo + (hi - lo) / 2;
+            if (items[mid].start < first)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        for (size_t i = lo; i < size() && !(last < items[i].start); i++)
+        {
+            func(items[i].start, items[i].end, items[i].value);
+        }
+    }
+
+    // call func(start, end, value) for every interval that contains the point
+    template <typename Func> void stab(const K& point, Func func) const { overlap(point, point, func); }
+
+    friend class BlobBuilder;
+};
+
+/*
+    InvertedIndex - term -> sorted list of document ids (posting list)
+    posting lists are split into blocks of up to kBlockSize ids
+    every block stores (delta - 1) values bit-packed with the minimal bit width
+    and block headers (first/last id) are used as skip pointers during intersection
+*/
+class InvertedIndex
+{
+  public:
+    static constexpr size_t kBlockSize = 128;
+
+    struct Block
+    {
+        uint32_t firstId;
+        uint32_t lastId;
+        // offset in the packed words array
+        uint32_t dataOffset;
+        uint16_t count;
+        uint8_t bitWidth;
+        uint8_t reserved;
+    };
+
+    struct PostingList
+    {
+        uint32_t firstBlock;
+        uint32_t numBlocks;
+        uint32_t numIds;
+    };
+
+  private:
+    HashMap<String, uint32_t> terms;
+    Array<PostingList> lists;
+    Array<Block> blocks;
+    // note: there is always one extra zero word at the end (decoder can read one word ahead)
+    Array<uint32_t> packed;
+
+    // decoded block with the padding for SIMD scans (padding is filled with the max id)
+    struct DecodedBlock
+    {
+        uint32_t ids[kBlockSize + 4];
+        size_t count;
+    };
+
+    void decodeBlock(const Block& block, DecodedBlock& res) const noexcept
+    {
+        const uint32_t* words = packed.data() + block.dataOffset;
+        const uint32_t bitWidth = block.bitWidth;
+        const uint32_t mask = (bitWidth >= 32) ? ~0u : ((1u << bitWidth) - 1);
+        uint32_t id = block.firstId;
+        res.ids[0] = id;
+        size_t bitPos = 0;
+        for (size_t i = 1; i < block.count; i++)
+        {
+            uint32_t delta = 0;
+            if (bitWidth > 0)
+            {
+                size_t wordIndex = bitPos / 32;
+                uint32_t shift = uint32_t(bitPos % 32);
+                uint64_t v = uint64_t(words[wordIndex]) | (uint64_t(words[wordIndex + 1]) << 32);
+                delta = uint32_t(v >> shift) & mask;
+                bitPos += bitWidth;
+            }
+            id += delta + 1;
+            res.ids[i] = id;
+        }
+        res.count = block.count;
+        for (size_t i = res.count; i < kBlockSize + 4; i++)
+        {
+            res.ids[i] = ~0u;
+        }
+    }
+
+    // first index in [from, count) where ids[index] >= target (or count)
+    static size_t lowerBound(const DecodedBlock& block, size_t from, uint32_t target) noexcept
+    {
+#ifdef ZMEYA_SSE2
+        // unsigned compare using signed SSE2 instructions (flip the sign bit)
+        const __m128i signBit = _mm_set1_epi32(int32_t(0x80000000u));
+        const __m128i t = _mm_xor_si128(_mm_set1_epi32(int32_t(target)), signBit);
+        for (size_t i = from; i < block.count; i += 4)
+        {
+            __m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block.ids + i)), signBit);
+            int lessMask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(v, t)));
+            if (lessMask != 0xF)
+            {
+                size_t index = i + countTrailingZeros64(uint64_t(~lessMask & 0xF));
+                return (index < block.count) ? index : block.count;
+            }
+        }
+        return block.count;
+#else
+        size_t i = from;
+        while (i < block.count && block.ids[i] < target)
+        {
+            i++;
+        }
+        return i;
+#endif
+    }
+
+    // forward-only cursor over the posting list
+    struct Cursor
+    {
+        const InvertedIndex* index;
+        const PostingList* list;
+        size_t blockIndex;
+        size_t pos;
+        DecodedBlock decoded;
+
+        void load(size_t newBlockIndex) noexcept
+        {
+            blockIndex = newBlockIndex;
+            pos = 0;
+            if (blockIndex < list->numBlocks)
+            {
+                index->decodeBlock(index->blocks[list->firstBlock + blockIndex], decoded);
+            }
+        }
+
+        // move to the first id >= target, returns false if the list is exhausted
+        bool seek(uint32_t target) noexcept
+        {
+            const Block* listBlocks = index->blocks.data() + list->firstBlock;
+            size_t numBlocks = list->numBlocks;
+            if (blockIndex >= numBlocks)
+            {
+                return false;
+            }
+            if (listBlocks[blockIndex].lastId < target)
+            {
+                // gallop over the skip pointers (block last ids)
+                size_t lo = blockIndex;
+                size_t step = 1;
+                size_t hi = lo + step;
+                while (hi < numBlocks && listBlocks[hi].lastId < target)
+                {
+                    lo = hi;
+                    step *= 2;
+                    hi = lo + step;
+                }
+                hi = (hi < numBlocks) ? hi : numBlocks;
+                // binary search in (lo, hi]
+                while (hi - lo > 1)
+                {
+                    size_t mid = lo + (hi - lo) / 2;
+                    if (listBlocks[mid].lastId < target)
+                    {
+                        lo = mid;
+                    }
+                    else
+                    {
+                        hi = mid;
+                    }
+                }
+                if (hi >= numBlocks)
+                {
+                    blockIndex = numBlocks;
+                    return false;
+                }
+                load(hi);
+            }
+            pos = lowerBound(decoded, pos, target);
+            ZMEYA_ASSERT(pos < decoded.count);
+            return true;
+        }
+
+        ZMEYA_NODISCARD uint32_t current() const noexcept { return decoded.ids[pos]; }
+    };
+
+  public:
+    InvertedIndex() noexcept = default;
+
+    // number of terms
+    ZMEYA_NODISCARD size_t size() const noexcept { return lists.size(); }
+
+    ZMEYA_NODISCARD bool empty() const noexcept { return lists.empty(); }
+
+    ZMEYA_NODISCARD const PostingList* find(const char* term) const noexcept
+    {
+        const uint32_t* listIndex = terms.find(term);
+        return listIndex ? &lists[*listIndex] : nullptr;
+    }
+
+    ZMEYA_NODISCARD size_t count(const char* term) const noexcept
+    {
+        const PostingList* list = find(term);
+        return list ? size_t(list->numIds) : 0;
+    }
+
+    // decode the whole posting list of the term (appends to result)
+    void decode(const char* term, std::vector<uint32_t>& result) const
+    {
+        const PostingList* list = find(term);
+        if (!list)
+        {
+            return;
+        }
+        DecodedBlock decoded;
+        for (size_t i = 0; i < list->numBlocks; i++)
+        {
+            decodeBlock(blocks[list->firstBlock + i], decoded);
+            result.insert(result.end(), decoded.ids, decoded.ids + decoded.count);
+        }
+    }
+
+    // ids that contain all of the terms (sorted)
+    void andQuery(const char* const* queryTerms, size_t numTerms, std::vector<uint32_t>& result) const
+    {
+        result.clear();
+        std::vector<const PostingList*> queryLists;
+        for (size_t i = 0; i < numTerms; i++)
+        {
+            const PostingList* list = find(queryTerms[i]);
+            if (!list)
+            {
+                return;
+            }
+            queryLists.push_back(list);
+        }
+        if (queryLists.empty())
+        {
+            return;
+        }
+
+        // start from the shortest list
+        std::sort(queryLists.begin(), queryLists.end(), [](const PostingList* a, const PostingList* b) { return a->numIds < b->numIds; });
+
+        std::vector<Cursor> cursors(queryLists.size() - 1);
+        for (size_t i = 0; i < cursors.size(); i++)
+        {
+            cursors[i].index = this;
+            cursors[i].list = queryLists[i + 1];
+            cursors[i].load(0);
+        }
+
+        DecodedBlock decoded;
+        const PostingList* shortest = queryLists[0];
+        for (size_t blockIndex = 0; blockIndex < shortest->numBlocks; blockIndex++)
+        {
+            decodeBlock(blocks[shortest->firstBlock + blockIndex], decoded);
+            for (size_t i = 0; i < decoded.count; i++)
+            {
+                uint32_t id = decoded.ids[i];
+                bool found = true;
+                for (Cursor& cursor : cursors)
+                {
+                    if (!cursor.seek(id))
+                    {
+                        return;
+                    }
+                    if (cursor.current() != id)
+                    {
+                        found = false;
+                        break;
+                    }
+                }
+                if (found)
+                {
+                    result.push_back(id);
+                }
+            }
+        }
+    }
+
+    void andQuery(std::initializer_list<const char*> queryTerms, std::vector<uint32_t>& result) const
+    {
+        andQuery(queryTerms.begin(), queryTerms.size(), result);
+    }
+
+    // ids that contain any of the terms (sorted, unique)
+    void orQuery(const char* const* queryTerms, size_t numTerms, std::vector<uint32_t>& result) const
+    {
+        result.clear();
+        std::vector<uint32_t> ids;
+        std::vector<uint32_t> merged;
+        for (size_t i = 0; i < numTerms; i++)
+        {
+            ids.clear();
+            decode(queryTerms[i], ids);
+            merged.clear();
+            std::set_union(result.begin(), result.end(), ids.begin(), ids.end(), std::back_inserter(merged));
+            result.swap(merged);
+        }
+    }
+
+    void orQuery(std::initializer_list<const char*> queryTerms, std::vector<uint32_t>& result) const
+    {
+        orQuery(queryTerms.begin(), queryTerms.size(), result);
+    }
+
+    friend class BlobBuilder;
+};
+
+/*
+    Grid2D - 2D grid stored in square tiles (TileSize x TileSize cells, row-major inside the tile)
+    tiles are stored in row-major order, so small neighborhoods touch only a few cache lines
+    Note: the last row/column of tiles is padded
+*/
+template <typename T, uint32_t TileSize = 8> class Grid2D
+{
+    static_assert(TileSize > 0 && (TileSize & (TileSize - 1)) == 0, "TileSize must be a power of two");
+
+    Array<T> cells;
+    uint32_t gridWidth;
+    uint32_t gridHeight;
+    uint32_t tilesX;
+    uint32_t tilesY;
+
+  public:
+    static constexpr uint32_t kTileSize = TileSize;
+    static constexpr uint32_t kCellsPerTile = TileSize * TileSize;
+
+    Grid2D() noexcept = default;
+
+    ZMEYA_NODISCARD size_t width() const noexcept { return size_t(gridWidth); }
+
+    ZMEYA_NODISCARD size_t height() const noexcept { return size_t(gridHeight); }
+
+    ZMEYA_NODISCARD size_t numTilesX() const noexcept { return size_t(tilesX); }
+
+    ZMEYA_NODISCARD size_t numTilesY() const noexcept { return size_t(tilesY); }
+
+    ZMEYA_NODISCARD bool empty() const noexcept { return cells.empty(); }
+
+    // index of the cell in the tiled storage
+    ZMEYA_NODISCARD static size_t cellIndex(size_t x, size_t y, size_t numTilesX) noexcept
+    {
+        size_t tileIndex = (y / TileSize) * numTilesX + (x / TileSize);
+        return tileIndex * kCellsPerTile + (y % TileSize) * TileSize + (x % TileSize);
+    }
+
+    ZMEYA_NODISCARD bool contains(int64_t x, int64_t y) const noexcept
+    {
+        return x >= 0 && y >= 0 && x < int64_t(gridWidth) && y < int64_t(gridHeight);
+    }
+
+    ZMEYA_NODISCARD const T& at(size_t x, size_t y) const noexcept
+    {
+        ZMEYA_ASSERT(x < width() && y < height());
+        return cells[cellIndex(x, y, tilesX)];
+    }
+
+    ZMEYA_NODISCARD const T& operator()(size_t x, size_t y) const noexcept { return at(x, y); }
+
+    // all (kCellsPerTile) cells of the tile
+    ZMEYA_NODISCARD const T* tile(size_t tileX, size_t tileY) const noexcept
+    {
+        ZMEYA_ASSERT(tileX < numTilesX() && tileY < numTilesY());
+        return cells.data() + (tileY * tilesX + tileX) * kCellsPerTile;
+    }
+
+    // call func(tileX, tileY, cells) for every tile
+    template <typename Func> void forEachTile(Func func) const
+    {
+        for (size_t tileY = 0; tileY < numTilesY(); tileY++)
+        {
+            for (size_t tileX = 0; tileX < numTilesX(); tileX++)
+            {
+                func(tileX, tileY, tile(tileX, tileY));
+            }
+        }
+    }
+
+    // call func(x, y, cell) for every cell in [x0, x1) x [y0, y1) (clipped to the grid, visited tile by tile)
+    template <typename Func> void forEachInRegion(int64_t x0, int64_t y0, int64_t x1, int64_t y1, Func func) const
+    {
+        size_t minX = size_t(std::max(x0, int64_t(0)));
+        size_t minY = size_t(std::max(y0, int64_t(0)));
+        size_t maxX = size_t(std::max(std::min(x1, int64_t(gridWidth)), int64_t(0)));
+        size_t maxY = size_t(std::max(std::min(y1, int64_t(gridHeight)), int64_t(0)));
+        if (minX >= maxX || minY >= maxY)
+        {
+            return;
+        }
+        for (size_t tileY = minY / TileSize; tileY <= (maxY - 1) / TileSize; tileY++)
+        {
+            for (size_t tileX = minX / TileSize; tileX <= (maxX - 1) / TileSize; tileX++)
+            {
+                const T* tileCells = tile(tileX, tileY);
+                size_t yBegin = std::max(minY, tileY * TileSize);
+                size_t yEnd = std::min(maxY, (tileY + 1) * TileSize);
+                size_t xBegin = std::max(minX, tileX * TileSize);
+                size_t xEnd = std::min(maxX, (tileX + 1) * TileSize);
+                for (size_t y = yBegin; y < yEnd; y++)
+                {
+                    const T* row = tileCells + (y % TileSize) * TileSize;
+                    for (size_t x = xBegin; x < xEnd; x++)
+                    {
+                        func(x, y, row[x % TileSize]);
+                    }
+                }
+            }
+        }
+    }
+
+    friend class BlobBuilder;
+};
+
+/*
+    24-bit unsigned integer (little-endian, no alignment requirements)
+*/
+struct UInt24
+{
+    uint8_t bytes[3];
+};
+
+ZMEYA_NODISCARD inline uint32_t handleIndexGet(uint16_t v) noexcept { return uint32_t(v); }
+ZMEYA_NODISCARD inline uint32_t handleIndexGet(uint32_t v) noexcept { return v; }
+ZMEYA_NODISCARD inline uint32_t handleIndexGet(const UInt24& v) noexcept
+{
+    return uint32_t(v.bytes[0]) | (uint32_t(v.bytes[1]) << 8) | (uint32_t(v.bytes[2]) << 16);
+}
+
+inline void handleIndexSet(uint16_t& dst, uint32_t v) noexcept { dst = uint16_t(v); }
+inline void handleIndexSet(uint32_t& dst, uint32_t v) noexcept { dst = v; }
+inline void handleIndexSet(UInt24& dst, uint32_t v) noexcept
+{
+    dst.bytes[0] = uint8_t(v);
+    dst.bytes[1] = uint8_t(v >> 8);
+    dst.bytes[2] = uint8_t(v >> 16);
+}
+
+/*
+    Handle - index of the object in the Pool<T> (16, 24 or 32 bits)
+    unlike Pointer<T>, handles to the same object are bitwise identical and can be compared/sorted/hashed
+    the stored value is (index + 1), so a zero-initialized handle is null (the same as Pointer<T>)
+*/
+template <typename T, size_t Bits = 32> class Handle
+{
+    static_assert(Bits == 16 || Bits == 24 || Bits == 32, "Only 16, 24 and 32 bit handles are supported");
+    typedef typename std::conditional<Bits == 16, uint16_t, typename std::conditional<Bits == 24, UInt24, uint32_t>::type>::type Storage;
+
+    // index + 1 (zero = null handle)
+    Storage value;
+
+  public:
+    static constexpr uint32_t kMaxIndex = uint32_t((uint64_t(1) << Bits) - 2);
+
+    Handle() noexcept = default;
+
+    explicit Handle(size_t index) noexcept
+    {
+        ZMEYA_ASSERT(index <= size_t(kMaxIndex));
+        handleIndexSet(value, uint32_t(index + 1));
+    }
+
+    ZMEYA_NODISCARD static Handle invalid() noexcept
+    {
+        Handle handle;
+        handleIndexSet(handle.value, 0);
+        return handle;
+    }
+
+    ZMEYA_NODISCARD uint32_t index() const noexcept
+    {
+        ZMEYA_ASSERT(isValid());
+        return handleIndexGet(value) - 1;
+    }
+
+    ZMEYA_NODISCARD bool isValid() const noexcept { return handleIndexGet(value) != 0; }
+
+    operator bool() const noexcept { return isValid(); }
+
+    // null handles are equal to each other and are ordered before the valid ones
+    ZMEYA_NODISCARD bool operator==(const Handle& other) const noexcept { return handleIndexGet(value) == handleIndexGet(other.value); }
+    ZMEYA_NODISCARD bool operator!=(const Handle& other) const noexcept { return handleIndexGet(value) != handleIndexGet(other.value); }
+    ZMEYA_NODISCARD bool operator<(const Handle& other) const noexcept { return handleIndexGet(value) < handleIndexGet(other.value); }
+};
+
+/*
+    Pool - contiguous storage for the objects of the same type, objects are referenced by Handle<T>
+*/
+template <typename T> class Pool
+{
+    Array<T> items;
+
+  public:
+    Pool() noexcept = default;
+
+    ZMEYA_NODISCARD size_t size() const noexcept { return items.size(); }
+
+    ZMEYA_NODISCARD bool empty() const noexcept { return items.empty(); }
+
+    ZMEYA_NODISCARD const T* begin() const noexcept { return items.begin(); }
+
+    ZMEYA_NODISCARD const T* end() const noexcept { return items.end(); }
+
+    template <size_t Bits> ZMEYA_NODISCARD const T& operator[](const Handle<T, Bits>& handle) const noexcept
+    {
+        ZMEYA_ASSERT(handle.isValid() && handle.index() < size());
+        return items[handle.index()];
+    }
+
+    // returns nullptr for invalid handles
+    template <size_t Bits> ZMEYA_NODISCARD const T* get(const Handle<T, Bits>& handle) const noexcept
+    {
+        if (!handle.isValid())
+        {
+            return nullptr;
+        }
+        ZMEYA_ASSERT(handle.index() < size());
+        return items.data() + handle.index();
+    }
+
+    template <size_t Bits = 32> ZMEYA_NODISCARD Handle<T, Bits> handleOf(const T& item) const noexcept
+    {
+        ZMEYA_ASSERT(&item >= begin() && &item < end());
+        return Handle<T, Bits>(size_t(&item - begin()));
+    }
+
+    friend class BlobBuilder;
+};
+
+/*
+    Prefetching traversal helpers
+    relative pointer targets are not predictable by the hardware prefetcher, so these helpers issue software prefetches ahead
+    default distances were picked using DISABLED_PrefetchDistanceBenchmark (see ZmeyaTest23.cpp)
+*/
+struct PrefetchDefaults
+{
+    static constexpr size_t kPrefetchDistance = 8;
+    static constexpr size_t kListLookahead = 4;
+};
+
+/*
+    PrefetchingRange - iterates over a contiguous range of pointers (Pointer<T>, Pointer16<T>, ...) and yields pointer targets,
+    targets are prefetched 'distance' elements ahead of the current one
+*/
+template <typename PointerType> class PrefetchingRange
+{
+  public:
+    typedef decltype(std::declval<const PointerType&>().get()) ValueType;
+
+    class Iterator
+    {
+        const PointerType* current;
+        const PointerType* prefetchCursor;
+        const PointerType* last;
+
+      public:
+        Iterator(const PointerType* _current, const PointerType* _prefetchCursor, const PointerType* _last) noexcept
+            : current(_current)
+            , prefetchCursor(_prefetchCursor)
+            , last(_last)
+        {
+        }
+
+        ZMEYA_NODISCARD ValueType operator*() const noexcept { return current->get(); }
+
+        Iterator& operator++() noexcept
+        {
+            if (prefetchCursor != last)
+            {
+                ZMEYA_PREFETCH(prefetchCursor->get());
+                ++prefetchCursor;
+            }
+            ++current;
+            return *this;
+        }
+
+        ZMEYA_NODISCARD bool operator==(const Iterator& other) const noexcept { return current == other.current; }
+        ZMEYA_NODISCARD bool operator!=(const Iterator& other) const noexcept { return current != other.current; }
+    };
+
+  private:
+    const PointerType* first;
+    const PointerType* last;
+    size_t distance;
+
+  public:
+    PrefetchingRange(const PointerType* _first, const PointerType* _last, size_t _distance) noexcept
+        : first(_first)
+        , last(_last)
+        , distance(_distance)
+    {
+    }
+
+    ZMEYA_NODISCARD Iterator begin() const noexcept
+    {
+        // warm up: prefetch the first 'distance' targets
+        const PointerType* prefetchCursor = first;
+        for (size_t i = 0; i < distance && prefetchCursor != last; i++, ++prefetchCursor)
+        {
+            ZMEYA_PREFETCH(prefetchCursor->get());
+        }
+        return Iterator(first, prefetchCursor, last);
+    }
+
+    ZMEYA_NODISCARD Iterator end() const noexcept { return Iterator(last, last, last); }
+};
+
+// iterate over array of pointers with software prefetching, for example
+// for (const Node* node : zm::prefetching(root->children)) { ... }
+template <typename Container>
+ZMEYA_NODISCARD auto prefetching(const Container& container, size_t distance = PrefetchDefaults::kPrefetchDistance)
+    -> PrefetchingRange<typename std::remove_cv<typename std::remove_reference<decltype(*container.begin())>::type>::type>
+{
+    return {container.begin(), container.end(), distance};
+}
+
+// walk a linked list with a lookahead cursor that runs 'lookahead' nodes ahead and prefetches them
+// next - pointer to the member that holds the next node pointer, for example &Node::next
+template <typename T, typename PointerType, typename Func>
+void forEachInList(const T* head, PointerType T::*next, Func func, size_t lookahead = PrefetchDefaults::kListLookahead)
+{
+    const T* ahead = head;
+    for (size_t i = 0; i < lookahead && ahead != nullptr; i++)
+    {
+        ahead = (ahead->*next).get();
+        ZMEYA_PREFETCH(ahead);
+    }
+
+    for (const T* node = head; node != nullptr; node = (node->*next).get())
+    {
+        if (ahead != nullptr)
+        {
+            ahead = (ahead->*next).get();
+            ZMEYA_PREFETCH(ahead);
+        }
+        func(*node);
+    }
+}
+
+/*
+    BlobFooter - stamped at the very end of every finalized blob, describes the binary format of the blob
+*/
+struct BlobFooter
+{
+    static constexpr uint32_t kMagic = 0x41594D5A; // 'ZMYA'
+    static constexpr uint8_t kVersion = 1;
+    // the relocation table is stored right before the footer
+    static constexpr uint16_t kFlagRelocationTable = 1;
+
+    // size of the blob data (not including the footer)
+    uint64_t dataSize;
+    uint8_t version;
+    uint8_t roffsetBits;
+    uint16_t flags;
+    uint32_t magic;
+};
+static_assert(sizeof(BlobFooter) == 16, "Unexpected BlobFooter size");
+
+// returns blob footer or nullptr if the blob has no (valid) footer
+ZMEYA_NODISCARD inline const BlobFooter* getBlobFooter(const void* blob, size_t sizeInBytes) noexcept
+{
+    if (blob == nullptr || sizeInBytes < sizeof(BlobFooter))
+    {
+        return nullptr;
+    }
+    const char* footerAddr = reinterpret_cast<const char*>(blob) + (sizeInBytes - sizeof(BlobFooter));
+    if ((uintptr_t(footerAddr) & (alignof(BlobFooter) - 1)) != 0)
+    {
+        return nullptr;
+    }
+    const BlobFooter* footer = reinterpret_cast<const BlobFooter*>(footerAddr);
+    if (footer->magic != BlobFooter::kMagic || footer->dataSize != uint64_t(sizeInBytes - sizeof(BlobFooter)))
+    {
+        return nullptr;
+    }
+    return footer;
+}
+
+// returns true if the blob was built using the same binary format (offset size, version) as the current reader
+ZMEYA_NODISCARD inline bool isBlobCompatible(const void* blob, size_t sizeInBytes) noexcept
+{
+    const BlobFooter* footer = getBlobFooter(blob, sizeInBytes);
+    return footer && footer->version == BlobFooter::kVersion && footer->roffsetBits == uint8_t(ZMEYA_ROFFSET_BITS);
+}
+
+/*
+    BlobRelocationTable - optional trailer that lists every relative offset (pointer site) of the blob and its target
+    the table is sorted by the site offset, so the generic tools (validation, compaction, diffing) don't need any type information
+    layout: site offsets[n], target offsets[n], types[n], padding, BlobRelocationTableHeader, BlobFooter
+*/
+enum class BlobRelocationType : uint8_t
+{
+    // roffset_t relative to the site (Pointer, String)
+    Pointer = 0,
+    // roffset_t relative to the site, the low bits store the type index (VariantPointer)
+    VariantPointer = 1,
+    // int16_t relative to the site (Pointer16)
+    Pointer16 = 2,
+    // roffset_t relative to the site followed by the number of elements (Array)
+    Array = 3,
+    // int16_t relative to the site followed by the number of elements (SmallArray)
+    SmallArray = 4,
+};
+
+struct BlobRelocation
+{
+    offset_t siteOffset;
+    offset_t targetOffset;
+    BlobRelocationType type;
+    // VariantPointer: number of the low bits used by the type index
+    uint8_t numTagBits;
+};
+
+struct BlobRelocationTableHeader
+{
+    uint64_t tableOffset;
+    uint64_t numRelocations;
+};
+static_assert(sizeof(BlobRelocationTableHeader) == 16, "Unexpected BlobRelocationTableHeader size");
+
+// size of the relative offset stored at the relocation site
+ZMEYA_NODISCARD inline size_t getBlobRelocationSiteSize(BlobRelocationType type) noexcept
+{
+    return (type == BlobRelocationType::Pointer16 || type == BlobRelocationType::SmallArray) ? sizeof(int16_t) : sizeof(roffset_t);
+}
+
+// read the target offset currently stored at the relocation site (returns false for the null pointer / empty array)
+// site - address of the relocation site (blob + relocation.siteOffset)
+ZMEYA_NODISCARD inline bool readBlobRelocationTarget(const void* site, const BlobRelocation& relocation, offset_t& targetOffset) noexcept
+{
+    int64_t relativeOffset = 0;
+    if (getBlobRelocationSiteSize(relocation.type) == sizeof(int16_t))
+    {
+        int16_t v;
+        std::memcpy(&v, site, sizeof(v));
+        relativeOffset = v;
+    }
+    else
+    {
+        roffset_t v;
+        std::memcpy(&v, site, sizeof(v));
+        if (relocation.type == BlobRelocationType::VariantPointer)
+        {
+            v = roffset_t(v & ~roffset_t((roffset_t(1) << relocation.numTagBits) - 1));
+        }
+        relativeOffset = v;
+    }
+    targetOffset = offset_t(int64_t(relocation.siteOffset) + relativeOffset);
+    return relativeOffset != 0;
+}
+
+// reader for the relocation table (empty if the blob was built without the relocation table)
+class BlobRelocationTable
+{
+    using uoffset_t = std::make_unsigned<roffset_t>::type;
+
+    const char* blob = nullptr;
+    const uoffset_t* siteOffsets = nullptr;
+    const uoffset_t* targetOffsets = nullptr;
+    const uint8_t* types = nullptr;
+    size_t numRelocations = 0;
+    size_t tableOffset = 0;
+
+  public:
+    BlobRelocationTable() = default;
+    BlobRelocationTable(const void* _blob, size_t sizeInBytes) noexcept
+    {
+        const BlobFooter* footer = getBlobFooter(_blob, sizeInBytes);
+        if (footer == nullptr || (footer->flags & BlobFooter::kFlagRelocationTable) == 0 ||
+            footer->dataSize < sizeof(BlobRelocationTableHeader))
+        {
+            return;
+        }
+        const char* bytes = reinterpret_cast<const char*>(_blob);
+        size_t headerOffset = size_t(footer->dataSize) - sizeof(BlobRelocationTableHeader);
+        const BlobRelocationTableHeader* header = reinterpret_cast<const BlobRelocationTableHeader*>(bytes + headerOffset);
+        // corrupted header
+        uint64_t entrySize = sizeof(uoffset_t) * 2 + sizeof(uint8_t);
+        if (header->tableOffset > headerOffset || (header->tableOffset % alignof(uoffset_t)) != 0 ||
+            header->numRelocations > (headerOffset - header->tableOffset) / entrySize)
+        {
+            return;
+        }
+        blob = bytes;
+        numRelocations = size_t(header->numRelocations);
+        tableOffset = size_t(header->tableOffset);
+        siteOffsets = reinterpret_cast<const uoffset_t*>(bytes + tableOffset);
+        targetOffsets = siteOffsets + numRelocations;
+        types = reinterpret_cast<const uint8_t*>(targetOffsets + numRelocations);
+    }
+
+    ZMEYA_NODISCARD size_t size() const noexcept { return numRelocations; }
+    ZMEYA_NODISCARD bool empty() const noexcept { return numRelocations == 0; }
+
+    // size of the blob data in front of the relocation table
+    ZMEYA_NODISCARD size_t getDataSize() const noexcept { return tableOffset; }
+
+    ZMEYA_NODISCARD BlobRelocation operator[](const size_t index) const noexcept
+    {
+        ZMEYA_ASSERT(index < numRelocations);
+        BlobRelocation relocation;
+        relocation.siteOffset = offset_t(siteOffsets[index]);
+        relocation.targetOffset = offset_t(targetOffsets[index]);
+        relocation.type = BlobRelocationType(types[index] & 0xF);
+        relocation.numTagBits = uint8_t(types[index] >> 4);
+        return relocation;
+    }
+
+    // untyped validation: all the sites are sorted and every site stores the recorded target offset
+    ZMEYA_NODISCARD bool validate() const noexcept
+    {
+        for (size_t index = 0; index < numRelocations; index++)
+        {
+            BlobRelocation relocation = (*this)[index];
+            if (relocation.type > BlobRelocationType::SmallArray || relocation.targetOffset > tableOffset ||
+                relocation.siteOffset + getBlobRelocationSiteSize(relocation.type) > tableOffset)
+            {
+                return false;
+            }
+            if (index > 0 && offset_t(siteOffsets[index - 1]) >= relocation.siteOffset)
+            {
+                return false;
+            }
+            offset_t targetOffset = 0;
+            const char* site = blob + relocation.siteOffset;
+            if (!readBlobRelocationTarget(site, relocation, targetOffset) || targetOffset != relocation.targetOffset)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// returns the relocation table of the blob
+ZMEYA_NODISCARD inline BlobRelocationTable getBlobRelocations(const void* blob, size_t sizeInBytes) noexcept
+{
+    return BlobRelocationTable(blob, sizeInBytes);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifdef ZMEYA_ENABLE_SERIALIZE_SUPPORT
+
+ZMEYA_NODISCARD inline diff_t diff(offset_t a, offset_t b) noexcept
+{
+    diff_t res = a - b;
+    return res;
+}
+
+ZMEYA_NODISCARD inline offset_t diffAddr(uintptr_t a, uintptr_t b)
+{
+    ZMEYA_ASSERT(a >= b);
+    uintptr_t res = a - b;
+    ZMEYA_ASSERT(res <= uintptr_t(std::numeric_limits<offset_t>::max()));
+    return offset_t(res);
+}
+
+ZMEYA_NODISCARD inline roffset_t toRelativeOffset(diff_t v)
+{
+    ZMEYA_ASSERT(v >= diff_t(std::numeric_limits<roffset_t>::min()));
+    ZMEYA_ASSERT(v <= diff_t(std::numeric_limits<roffset_t>::max()));
+    return roffset_t(v);
+}
+
+constexpr bool inline isPowerOfTwo(size_t v) { return v && ((v & (v - 1)) == 0); }
+
+class BlobBuilder;
+
+/*
+    Node order for the graphs created by BlobBuilder
+    BreadthFirst and ReverseCuthillMcKee reduce the graph bandwidth (neighbors are stored close to each other)
+*/
+enum class GraphNodeOrder
+{
+    Original,
+    BreadthFirst,
+    ReverseCuthillMcKee,
+};
+
+/*
+    This is a non-serializable pointer to blob internal memory
+    Note: blob is able to relocate its own memory that's is why we cannot use
+   standard pointers or references
+*/
+#ifdef ZMEYA_FAST_BLOBPTR
+/*
+    BlobBuilderRef - non-owning reference to the BlobBuilder (no reference counting)
+*/
+class BlobBuilderRef
+{
+    const BlobBuilder* builder = nullptr;
+#ifdef ZMEYA_VALIDATE_BLOBPTR
+    uint64_t serial = 0;
+#endif
+
+  public:
+    BlobBuilderRef() noexcept = default;
+    explicit BlobBuilderRef(const BlobBuilder* _builder) noexcept;
+
+    // 'lock' for API compatibility with std::weak_ptr
+    ZMEYA_NODISCARD const BlobBuilder* lock() const noexcept;
+};
+#else
+typedef std::weak_ptr<const BlobBuilder> BlobBuilderRef;
+#endif
+
+// raw builder pointer from the BlobBuilderRef::lock() result
+ZMEYA_NODISCARD inline const BlobBuilder* getBlobBuilder(const BlobBuilder* p) noexcept { return p; }
+ZMEYA_NODISCARD inline const BlobBuilder* getBlobBuilder(const std::shared_ptr<const BlobBuilder>& p) noexcept { return p.get(); }
+
+template <typename T> class BlobPtr
+{
+    BlobBuilderRef blob;
+    offset_t absoluteOffset = 0;
+    // BlobBuilder generation (BlobBuilder::reset invalidates all outstanding BlobPtrs)
+    uint32_t generation = 0;
+
+    bool isEqual(const BlobPtr<T>& other) const
+    {
+        if (blob.lock() != other.blob.lock())
+        {
+            return false;
+        }
+        return absoluteOffset == other.absoluteOffset && generation == other.generation;
+    }
+
+  public:
+    explicit BlobPtr(BlobBuilderRef&& _blob, uint32_t _generation, offset_t _absoluteOffset)
+        : blob(std::move(_blob))
+        , absoluteOffset(_absoluteOffset)
+        , generation(_generation)
+    {
+    }
+
+    BlobPtr() = default;
+
+    BlobPtr(BlobPtr&&) = default;
+    BlobPtr& operator=(BlobPtr&&) = default;
+    BlobPtr(const BlobPtr&) = default;
+    BlobPtr& operator=(const BlobPtr&) = default;
+
+    template <typename T2> BlobPtr(const BlobPtr<T2>& other)
+    {
+        static_assert(std::is_convertible<T2*, T*>::value, "Uncompatible types");
+        blob = other.blob;
+        absoluteOffset = other.absoluteOffset;
+        generation = other.generation;
+    }
+    template <class T2> friend class BlobPtr;
+
+    offset_t getAbsoluteOffset() const { return absoluteOffset; }
+
+    ZMEYA_NODISCARD T* get() const;
+
+    T* operator->() const { return get(); }
+    T& operator*() const { return *(get()); }
+
+    operator bool() const { return get() != nullptr; }
+    bool operator==(const BlobPtr& other) const { return isEqual(other); }
+    bool operator!=(const BlobPtr& other) const { return !isEqual(other); }
+
+    template <typename T2> friend class Pointer;
+    template <typename T2> friend class Pointer16;
+    template <typename... Ts> friend class VariantPointer;
+    friend class BlobBuilder;
+    friend class BlobLinker;
+};
+
+/*
+    Blob allocator - aligned allocator for internal Blob usage
+*/
+template <typename T, int Alignment> class BlobBuilderAllocator : public std::allocator<T>
+{
+  public:
+    typedef size_t size_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+
+    template <typename _Tp1> struct rebind
+    {
+        typedef BlobBuilderAllocator<_Tp1, Alignment> other;
+    };
+
+    pointer allocate(size_type n)
+    {
+        const size_t alignment = Alignment;
+        void* const pv = ZMEYA_ALLOC(n * sizeof(T), alignment);
+        return static_cast<pointer>(pv);
+    }
+
+    void deallocate(pointer p, size_type)
+    {
+        //
+        ZMEYA_FREE(p);
+    }
+
+    BlobBuilderAllocator()
+        : std::allocator<T>()
+    {
+    }
+    BlobBuilderAllocator(const BlobBuilderAllocator& a)
+        : std::allocator<T>(a)
+    {
+    }
+    template <class U>
+    BlobBuilderAllocator(const BlobBuilderAllocator<U, Alignment>& a)
+        : std::allocator<T>(a)
+    {
+    }
+};
+
+// aligned offset of the next allocation
+ZMEYA_NODISCARD inline size_t alignBlobOffset(size_t cursor, size_t alignment) noexcept
+{
+    return (cursor + alignment - 1) & ~(alignment - 1);
+}
+
+// offset of the blob footer, so that the final blob size is a multiple of desiredSizeShouldBeMultipleOf
+ZMEYA_NODISCARD inline size_t getBlobFooterOffset(size_t dataSize, size_t desiredSizeShouldBeMultipleOf) noexcept
+{
+    ZMEYA_ASSERT(desiredSizeShouldBeMultipleOf > 0);
+    size_t footerOffset = alignBlobOffset(dataSize, alignof(BlobFooter));
+    while (((footerOffset + sizeof(BlobFooter)) % desiredSizeShouldBeMultipleOf) != 0)
+    {
+        footerOffset += alignof(BlobFooter);
+    }
+    return footerOffset;
+}
+
+/*
+    BlobSizePlanner - computes the exact blob size (alignment, padding and footer included) without writing any data
+    replay the same sequence of allocations as the real build, then create the BlobBuilder using finalize() size
+    Note: with deduplication enabled the planned size is an upper bound
+    Note: the relocation table (BlobBuilder::setRelocationTableEnabled) is not included
+*/
+class BlobSizePlanner
+{
+    size_t cursor = 0;
+
+  public:
+    BlobSizePlanner() = default;
+
+    ZMEYA_NODISCARD size_t getSize() const noexcept { return cursor; }
+
+    // returns the absolute offset of the allocation (the same offset as BlobBuilder would return)
+    size_t allocate(size_t numBytes, size_t alignment)
+    {
+        ZMEYA_ASSERT(isPowerOfTwo(alignment));
+        ZMEYA_ASSERT(alignment < ZMEYA_MAX_ALIGN);
+        size_t absoluteOffset = alignBlobOffset(cursor, alignment);
+        cursor = absoluteOffset + numBytes;
+        return absoluteOffset;
+    }
+
+    template <typename T> size_t allocate() { return allocate(sizeof(T), alignof(T)); }
+
+    size_t allocateBytes(size_t numBytes, size_t alignment = 1, size_t numZeroBytesAfter = 0)
+    {
+        return allocate(numBytes + numZeroBytesAfter, alignment);
+    }
+
+    // resizeArray / copyToArrayFast / SmallArray
+    template <typename T> size_t resizeArray(size_t numElements) { return allocate(sizeof(T) * numElements, alignof(T)); }
+
+    // copyTo string
+    size_t copyTo(const char*, size_t len) { return allocateBytes(len, 1, 1); }
+    size_t copyTo(const char* src) { return copyTo(src, std::strlen(src)); }
+    size_t copyTo(const std::string& src) { return copyTo(src.c_str(), src.size()); }
+
+    // copyTo array from std::vector
+    template <typename T, typename TAllocator> void copyTo(const std::vector<T, TAllocator>& src)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types allowed");
+        resizeArray<T>(src.size());
+    }
+
+    // copyTo array of strings from std::vector
+    template <typename TAllocator> void copyTo(const std::vector<std::string, TAllocator>& src)
+    {
+        resizeArray<String>(src.size());
+        for (const std::string& str : src)
+        {
+            copyTo(str);
+        }
+    }
+
+    template <typename TAllocator> void copyTo(const std::vector<const char*, TAllocator>& src)
+    {
+        resizeArray<String>(src.size());
+        for (const char* str : src)
+        {
+            copyTo(str);
+        }
+    }
+
+    // copyTo array of arrays from vector of vectors
+    template <typename T, typename TAllocator1, typename TAllocator2>
+    void copyTo(const std::vector<std::vector<T, TAllocator2>, TAllocator1>& src)
+    {
+        resizeArray<Array<T>>(src.size());
+        for (const std::vector<T, TAllocator2>& v : src)
+        {
+            copyTo(v);
+        }
+    }
+
+    // copyToHash (buckets + items, without the item payload)
+    template <typename Key> void copyToHashSet(size_t numItems)
+    {
+        resizeArray<typename HashSet<Key>::Bucket>(numItems * 2);
+        resizeArray<Key>(numItems);
+    }
+
+    template <typename Key, typename Value> void copyToHashMap(size_t numItems)
+    {
+        resizeArray<typename HashMap<Key, Value>::Bucket>(numItems * 2);
+        resizeArray<typename HashMap<Key, Value>::Item>(numItems);
+    }
+
+    // copyTo hash set from std::unordered_set
+    template <typename Key, typename Hasher, typename KeyEq, typename TAllocator>
+    void copyTo(const std::unordered_set<Key, Hasher, KeyEq, TAllocator>& src)
+    {
+        copyToHashSet<Key>(src.size());
+    }
+
+    template <typename Hasher, typename KeyEq, typename TAllocator>
+    void copyTo(const std::unordered_set<std::string, Hasher, KeyEq, TAllocator>& src)
+    {
+        copyToHashSet<String>(src.size());
+        for (const std::string& str : src)
+        {
+            copyTo(str);
+        }
+    }
+
+    // copyTo hash map from std::unordered_map
+    template <typename Key, typename Value, typename Hasher, typename KeyEq, typename TAllocator>
+    void copyTo(const std::unordered_map<Key, Value, Hasher, KeyEq, TAllocator>& src)
+    {
+        copyToHashMap<Key, Value>(src.size());
+    }
+
+    template <typename Value, typename Hasher, typename KeyEq, typename TAllocator>
+    void copyTo(const std::unordered_map<std::string, Value, Hasher, KeyEq, TAllocator>& src)
+    {
+        copyToHashMap<String, Value>(src.size());
+        for (const auto& item : src)
+        {
+            copyTo(item.first);
+        }
+    }
+
+    template <typename Key, typename Hasher, typename KeyEq, typename TAllocator>
+    void copyTo(const std::unordered_map<Key, std::string, Hasher, KeyEq, TAllocator>& src)
+    {
+        copyToHashMap<Key, String>(src.size());
+        for (const auto& item : src)
+        {
+            copyTo(item.second);
+        }
+    }
+
+    template <typename Hasher, typename KeyEq, typename TAllocator>
+    void copyTo(const std::unordered_map<std::string, std::string, Hasher, KeyEq, TAllocator>& src)
+    {
+        copyToHashMap<String, String>(src.size());
+        for (const auto& item : src)
+        {
+            copyTo(item.first);
+            copyTo(item.second);
+        }
+    }
+
+    // returns the final blob size (the same as BlobBuilder::finalize would return)
+    size_t finalize(size_t desiredSizeShouldBeMultipleOf = 4)
+    {
+        cursor = getBlobFooterOffset(cursor, desiredSizeShouldBeMultipleOf) + sizeof(BlobFooter);
+        return cursor;
+    }
+};
+
+/*
+    Blob storage type
+*/
+enum class BlobStorageType
+{
+    // std::vector based storage, data is reallocated (and copied) as the blob grows
+    Vector,
+    // reserved virtual address range, memory is committed on demand and the blob grows in place (stable addresses)
+    // the reserved size is a hard cap on the blob size
+    VirtualMemory,
+    // std::vector based storage that keeps only the working set in memory, completed bytes are written to a file
+    Streaming,
+    // fixed caller-provided buffer, falls back to Vector (and moves the data to the heap) if the blob doesn't fit
+    ExternalBuffer,
+    // shared file mapping (regular file, memfd or POSIX shm), the file grows using ftruncate (stable addresses)
+    FileMapping,
+};
+
+/*
+    BlobStorage - contiguous zero-initialized memory used by BlobBuilder
+*/
+class BlobStorage
+{
+    // commit granularity (multiple of the page size on all supported platforms)
+    static constexpr size_t kCommitGranularity = 64 * 1024;
+
+    std::vector<char, BlobBuilderAllocator<char, ZMEYA_MAX_ALIGN>> vec;
+    char* base = nullptr;
+    size_t numBytes = 0;
+    // virtual memory only
+    size_t reservedBytes = 0;
+    size_t committedBytes = 0;
+    // the high watermark, memory above it is known to be zeroed
+    size_t dirtyBytes = 0;
+    BlobStorageType type = BlobStorageType::Vector;
+
+    // external buffer only
+    size_t externalCapacity = 0;
+    bool overflowed = false;
+    // file mapping only
+    int fileDescriptor = -1;
+
+    // streaming only: bytes [0..flushedBytes) are already written to the file and released from memory
+    size_t flushedBytes = 0;
+    FILE* file = nullptr;
+    uint64_t fileBaseOffset = 0;
+    bool ioError = false;
+
+    // streaming only: late writes to the flushed bytes (applied by finishStreaming)
+    struct Patch
+    {
+        size_t absoluteOffset;
+        size_t bytesOffset;
+        size_t numBytes;
+    };
+    std::vector<Patch> patches;
+    std::vector<char> patchBytes;
+
+    static size_t alignUp(size_t v, size_t alignment) { return (v + alignment - 1) & ~(alignment - 1); }
+
+    static char* reserveAddressSpace(size_t sizeInBytes)
+    {
+#if defined(ZMEYA_VIRTUAL_MEMORY_WIN32)
+        return reinterpret_cast<char*>(VirtualAlloc(nullptr, sizeInBytes, MEM_RESERVE, PAGE_NOACCESS));
+#elif defined(ZMEYA_VIRTUAL_MEMORY_POSIX)
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+        flags |= MAP_NORESERVE;
+#endif
+        void* p = mmap(nullptr, sizeInBytes, PROT_NONE, flags, -1, 0);
+        return (p == MAP_FAILED) ? nullptr : reinterpret_cast<char*>(p);
+#else
+        (void)sizeInBytes;
+        return nullptr;
+#endif
+    }
+
+    static bool commit(char* p, size_t sizeInBytes)
+    {
+#if defined(ZMEYA_VIRTUAL_MEMORY_WIN32)
+        return VirtualAlloc(p, sizeInBytes, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#elif defined(ZMEYA_VIRTUAL_MEMORY_POSIX)
+        return mprotect(p, sizeInBytes, PROT_READ | PROT_WRITE) == 0;
+#else
+        (void)p;
+        (void)sizeInBytes;
+        return false;
+#endif
+    }
+
+    // map the file range over the reserved address space (the file is extended first)
+    static bool commitFileRange(char* p, int fd, size_t offset, size_t sizeInBytes)
+    {
+#if defined(ZMEYA_VIRTUAL_MEMORY_POSIX)
+        if (ftruncate(fd, off_t(offset + sizeInBytes)) != 0)
+        {
+            return false;
+        }
+        void* res = mmap(p + offset, sizeInBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, off_t(offset));
+        return res != MAP_FAILED;
+#else
+        (void)p;
+        (void)fd;
+        (void)offset;
+        (void)sizeInBytes;
+        return false;
+#endif
+    }
+
+    // replace the range of the reserved address space with private zeroed memory (whatever was mapped there before)
+    static bool commitAnonymous(char* p, size_t sizeInBytes)
+    {
+#if defined(ZMEYA_VIRTUAL_MEMORY_POSIX)
+        void* res = mmap(p, sizeInBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+        return res != MAP_FAILED;
+#else
+        (void)p;
+        (void)sizeInBytes;
+        return false;
+#endif
+    }
+
+    // file mapping: the file can't grow (e.g. ENOSPC, quota or read-only descriptor), report the error
+    // and keep building in private memory so the caller sees hasIoError() instead of a crash
+    bool commitFileRangeFallback(size_t offset, size_t sizeInBytes)
+    {
+        ioError = true;
+#if defined(ZMEYA_VIRTUAL_MEMORY_POSIX)
+        // the blob bytes above the offset are still mapped from the file (see truncateFile), keep them in a scratch mapping
+        // truncateFile keeps the committed size aligned, so the tail is always smaller than kCommitGranularity
+        size_t tailSize = (numBytes > offset) ? (numBytes - offset) : 0;
+        ZMEYA_ASSERT(tailSize < kCommitGranularity);
+        void* tail = nullptr;
+        if (tailSize > 0)
+        {
+            tail = mmap(nullptr, tailSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (tail == MAP_FAILED)
+            {
+                return false;
+            }
+            std::memcpy(tail, base + offset, tailSize);
+        }
+        bool res = commitAnonymous(base + offset, sizeInBytes);
+        if (tail != nullptr)
+        {
+            if (res)
+            {
+                std::memcpy(base + offset, tail, tailSize);
+            }
+            munmap(tail, tailSize);
+        }
+        return res;
+#else
+        (void)offset;
+        (void)sizeInBytes;
+        return false;
+#endif
+    }
+
+    static void releaseAddressSpace(char* p, size_t sizeInBytes)
+    {
+#if defined(ZMEYA_VIRTUAL_MEMORY_WIN32)
+        (void)sizeInBytes;
+        VirtualFree(p, 0, MEM_RELEASE);
+#elif defined(ZMEYA_VIRTUAL_MEMORY_POSIX)
+        munmap(p, sizeInBytes);
+#else
+        (void)p;
+        (void)sizeInBytes;
+#endif
+    }
+
+    void commitVirtualMemory(size_t newSize)
+    {
+        if (newSize <= committedBytes)
+        {
+            return;
+        }
+        // out of reserved address space: the reserved range is a hard cap and the storage can't move (stable addresses)
+        if (newSize > reservedBytes)
+        {
+            ZMEYA_ASSERT(false && "Out of reserved address space");
+            std::abort();
+        }
+        // grow geometrically to keep the number of commit calls low
+        size_t newCommittedBytes = std::max(newSize, committedBytes + committedBytes / 2);
+        newCommittedBytes = std::min(alignUp(newCommittedBytes, kCommitGranularity), reservedBytes);
+        size_t numBytesToCommit = newCommittedBytes - committedBytes;
+        bool res = false;
+        if (type == BlobStorageType::FileMapping)
+        {
+            // after the first failure the file is not extended anymore
+            res = (!ioError && commitFileRange(base, fileDescriptor, committedBytes, numBytesToCommit)) ||
+                  commitFileRangeFallback(committedBytes, numBytesToCommit);
+        }
+        else
+        {
+            res = commit(base + committedBytes, numBytesToCommit);
+        }
+        // out of memory (e.g. strict overcommit)
+        if (!res)
+        {
+            ZMEYA_ASSERT(false && "Failed to commit memory");
+            std::abort();
+        }
+        committedBytes = newCommittedBytes;
+    }
+
+    static bool seekFile(FILE* f, uint64_t offset)
+    {
+#ifdef _WIN32
+        return _fseeki64(f, int64_t(offset), SEEK_SET) == 0;
+#else
+        return fseeko(f, off_t(offset), SEEK_SET) == 0;
+#endif
+    }
+
+    static uint64_t tellFile(FILE* f)
+    {
+#ifdef _WIN32
+        int64_t offset = _ftelli64(f);
+#else
+        int64_t offset = int64_t(ftello(f));
+#endif
+        return (offset < 0) ? 0 : uint64_t(offset);
+    }
+
+    void writeFile(const void* src, size_t numBytesToWrite)
+    {
+        if (numBytesToWrite > 0 && std::fwrite(src, 1, numBytesToWrite, file) != numBytesToWrite)
+        {
+            ioError = true;
+        }
+    }
+
+    ZMEYA_NODISCARD bool isReserved() const noexcept
+    {
+        return type == BlobStorageType::VirtualMemory || type == BlobStorageType::FileMapping;
+    }
+
+    // external buffer overflow: move the data to the heap and continue as Vector
+    void switchToHeap(size_t sizeInBytes)
+    {
+        vec.reserve(std::max(sizeInBytes, externalCapacity * 2));
+        vec.assign(base, base + numBytes);
+        base = vec.data();
+        type = BlobStorageType::Vector;
+        overflowed = true;
+    }
+
+    void resizeVirtualMemory(size_t newSize)
+    {
+        commitVirtualMemory(newSize);
+
+        // freshly committed pages are zeroed by the OS, only previously used memory needs to be cleared
+        if (newSize > numBytes && numBytes < dirtyBytes)
+        {
+            std::memset(base + numBytes, 0, std::min(newSize, dirtyBytes) - numBytes);
+        }
+        numBytes = newSize;
+        dirtyBytes = std::max(dirtyBytes, newSize);
+    }
+
+  public:
+    static constexpr size_t kDefaultReserveSize = (sizeof(void*) >= 8) ? (size_t(64) << 30) : (size_t(512) << 20);
+
+    BlobStorage(BlobStorageType _type, size_t initialSizeInBytes, size_t reserveSizeInBytes)
+    {
+        if (_type == BlobStorageType::VirtualMemory)
+        {
+            size_t sizeToReserve = alignUp(std::max(reserveSizeInBytes, initialSizeInBytes), kCommitGranularity);
+            base = reserveAddressSpace(sizeToReserve);
+            if (base != nullptr)
+            {
+                type = BlobStorageType::VirtualMemory;
+                reservedBytes = sizeToReserve;
+                commitVirtualMemory(initialSizeInBytes);
+                return;
+            }
+            // failed to reserve address space - fall back to std::vector
+        }
+
+        if (_type == BlobStorageType::Streaming)
+        {
+            type = BlobStorageType::Streaming;
+        }
+        vec.reserve(initialSizeInBytes);
+        base = vec.data();
+    }
+
+    BlobStorage(const BlobStorage&) = delete;
+    BlobStorage& operator=(const BlobStorage&) = delete;
+
+    ~BlobStorage()
+    {
+        if (isReserved())
+        {
+            releaseAddressSpace(base, reservedBytes);
+        }
+    }
+
+    // first byte kept in memory (the same as at(getFlushedSize()))
+    ZMEYA_NODISCARD char* data() const noexcept { return base; }
+    ZMEYA_NODISCARD size_t size() const noexcept { return numBytes; }
+
+    // memory address of the byte at the given absolute offset
+    ZMEYA_NODISCARD char* at(size_t absoluteOffset) const noexcept
+    {
+        // the data is already flushed to the file
+        ZMEYA_ASSERT(absoluteOffset >= flushedBytes);
+        return base + (absoluteOffset - flushedBytes);
+    }
+    ZMEYA_NODISCARD bool empty() const noexcept { return numBytes == 0; }
+    ZMEYA_NODISCARD BlobStorageType getType() const noexcept { return type; }
+
+    // true if data() never changes (pointers to the blob memory are never invalidated)
+    // Note: external buffer is not stable, the data is moved to the heap if the blob doesn't fit
+    ZMEYA_NODISCARD bool hasStableAddresses() const noexcept { return isReserved(); }
+
+    // use the caller-provided buffer (storage must be empty)
+    void useExternalBuffer(void* buffer, size_t bufferSize)
+    {
+        ZMEYA_ASSERT(numBytes == 0 && type == BlobStorageType::Vector);
+        // buffer must be aligned the same way as the internal storage
+        ZMEYA_ASSERT(buffer != nullptr && (uintptr_t(buffer) & (ZMEYA_MAX_ALIGN - 1)) == 0);
+        vec = decltype(vec)();
+        base = reinterpret_cast<char*>(buffer);
+        externalCapacity = bufferSize;
+        type = BlobStorageType::ExternalBuffer;
+    }
+
+    // use the shared file mapping (storage must be empty), returns false if not supported by the platform
+    bool useFileMapping(int fd, size_t reserveSizeInBytes)
+    {
+        ZMEYA_ASSERT(numBytes == 0 && type == BlobStorageType::Vector);
+#if defined(ZMEYA_VIRTUAL_MEMORY_POSIX)
+        if (fd < 0 || ftruncate(fd, 0) != 0)
+        {
+            return false;
+        }
+        size_t sizeToReserve = alignUp(std::max(reserveSizeInBytes, kCommitGranularity), kCommitGranularity);
+        char* p = reserveAddressSpace(sizeToReserve);
+        if (p == nullptr)
+        {
+            return false;
+        }
+        vec = decltype(vec)();
+        base = p;
+        reservedBytes = sizeToReserve;
+        fileDescriptor = fd;
+        type = BlobStorageType::FileMapping;
+        return true;
+#else
+        (void)fd;
+        (void)reserveSizeInBytes;
+        return false;
+#endif
+    }
+
+    // file mapping: truncate the file to the blob size
+    void truncateFile()
+    {
+#if defined(ZMEYA_VIRTUAL_MEMORY_POSIX)
+        ZMEYA_ASSERT(type == BlobStorageType::FileMapping);
+        if (ftruncate(fileDescriptor, off_t(numBytes)) != 0)
+        {
+            ioError = true;
+        }
+        // the pages past the end of the file are no longer accessible, next growth maps them again
+        committedBytes = numBytes & ~(kCommitGranularity - 1);
+        dirtyBytes = numBytes;
+#endif
+    }
+
+    // external buffer: true if the blob didn't fit into the buffer and the data was moved to the heap
+    ZMEYA_NODISCARD bool hasOverflowed() const noexcept { return overflowed; }
+
+    // resize storage, new memory is filled with zeroes
+    void resize(size_t newSize)
+    {
+        if (isReserved())
+        {
+            resizeVirtualMemory(newSize);
+            return;
+        }
+        if (type == BlobStorageType::ExternalBuffer)
+        {
+            if (newSize <= externalCapacity)
+            {
+                // the caller-provided memory is not zeroed
+                if (newSize > numBytes)
+                {
+                    std::memset(base + numBytes, 0, newSize - numBytes);
+                }
+                numBytes = newSize;
+                return;
+            }
+            switchToHeap(newSize);
+        }
+        // can't shrink below the flushed bytes
+        ZMEYA_ASSERT(newSize >= flushedBytes);
+        vec.resize(newSize - flushedBytes, char(0));
+        base = vec.data();
+        numBytes = newSize;
+    }
+
+    // number of bytes available without reallocation (or without committing more memory)
+    ZMEYA_NODISCARD size_t capacity() const noexcept
+    {
+        if (type == BlobStorageType::ExternalBuffer)
+        {
+            return externalCapacity;
+        }
+        return isReserved() ? committedBytes : (flushedBytes + vec.capacity());
+    }
+
+    void reserve(size_t sizeInBytes)
+    {
+        if (isReserved())
+        {
+            commitVirtualMemory(std::min(sizeInBytes, reservedBytes));
+            return;
+        }
+        if (type == BlobStorageType::ExternalBuffer)
+        {
+            if (sizeInBytes <= externalCapacity)
+            {
+                return;
+            }
+            switchToHeap(sizeInBytes);
+        }
+        vec.reserve((sizeInBytes > flushedBytes) ? (sizeInBytes - flushedBytes) : 0);
+        base = vec.data();
+    }
+
+    // append bytes to the end of the storage
+    void append(const char* src, size_t numBytesToAppend)
+    {
+        if (numBytesToAppend == 0)
+        {
+            return;
+        }
+        if (type == BlobStorageType::ExternalBuffer)
+        {
+            if (numBytes + numBytesToAppend <= externalCapacity)
+            {
+                std::memcpy(base + numBytes, src, numBytesToAppend);
+                numBytes += numBytesToAppend;
+                return;
+            }
+            switchToHeap(numBytes + numBytesToAppend);
+        }
+        if (isReserved())
+        {
+            size_t offset = numBytes;
+            commitVirtualMemory(offset + numBytesToAppend);
+            std::memcpy(base + offset, src, numBytesToAppend);
+            numBytes = offset + numBytesToAppend;
+            dirtyBytes = std::max(dirtyBytes, numBytes);
+            return;
+        }
+        vec.insert(vec.end(), src, src + numBytesToAppend);
+        base = vec.data();
+        numBytes = flushedBytes + vec.size();
+    }
+
+    // streaming: start writing the blob to the file (at the current file position)
+    void startStreaming(FILE* _file)
+    {
+        ZMEYA_ASSERT(type == BlobStorageType::Streaming && _file != nullptr && file == nullptr);
+        file = _file;
+        fileBaseOffset = tellFile(file);
+    }
+
+    ZMEYA_NODISCARD size_t getFlushedSize() const noexcept { return flushedBytes; }
+    ZMEYA_NODISCARD bool hasIoError() const noexcept { return ioError; }
+
+    // streaming: write all the bytes below the watermark to the file and release them from memory
+    void flush(size_t watermark)
+    {
+        ZMEYA_ASSERT(type == BlobStorageType::Streaming && file != nullptr);
+        ZMEYA_ASSERT(watermark <= numBytes);
+        // keep the in-memory part aligned the same way as the whole blob
+        watermark &= ~size_t(ZMEYA_MAX_ALIGN - 1);
+        if (watermark <= flushedBytes)
+        {
+            return;
+        }
+        size_t numBytesToFlush = watermark - flushedBytes;
+        writeFile(vec.data(), numBytesToFlush);
+        vec.erase(vec.begin(), vec.begin() + numBytesToFlush);
+        base = vec.data();
+        flushedBytes = watermark;
+    }
+
+    // write bytes at the absolute offset, the flushed bytes are patched at the end of streaming
+    void write(size_t absoluteOffset, const void* src, size_t numBytesToWrite)
+    {
+        ZMEYA_ASSERT(absoluteOffset + numBytesToWrite <= numBytes);
+        const char* bytes = reinterpret_cast<const char*>(src);
+        if (absoluteOffset < flushedBytes)
+        {
+            size_t numBytesToPatch = std::min(numBytesToWrite, flushedBytes - absoluteOffset);
+            patches.push_back(Patch{absoluteOffset, patchBytes.size(), numBytesToPatch});
+            patchBytes.insert(patchBytes.end(), bytes, bytes + numBytesToPatch);
+            absoluteOffset += numBytesToPatch;
+            bytes += numBytesToPatch;
+            numBytesToWrite -= numBytesToPatch;
+        }
+        if (numBytesToWrite > 0)
+        {
+            std::memcpy(at(absoluteOffset), bytes, numBytesToWrite);
+        }
+    }
+
+    // streaming: flush the remaining bytes and apply the patches
+    void finishStreaming()
+    {
+        ZMEYA_ASSERT(type == BlobStorageType::Streaming && file != nullptr);
+        writeFile(vec.data(), numBytes - flushedBytes);
+        vec.clear();
+        base = vec.data();
+        flushedBytes = numBytes;
+        for (const Patch& patch : patches)
+        {
+            if (!seekFile(file, fileBaseOffset + patch.absoluteOffset))
+            {
+                ioError = true;
+                break;
+            }
+            writeFile(patchBytes.data() + patch.bytesOffset, patch.numBytes);
+        }
+        if (!patches.empty() && !seekFile(file, fileBaseOffset + numBytes))
+        {
+            ioError = true;
+        }
+        patches.clear();
+        patchBytes.clear();
+        if (std::fflush(file) != 0)
+        {
+            ioError = true;
+        }
+    }
+};
+
+template <typename T> std::weak_ptr<T> weak_from(T* p)
+{
+    std::shared_ptr<T> shared = p->shared_from_this();
+    return shared;
+}
+
+/*
+    Blob - a binary blob of data that is able to store POD types and special
+   "movable" data structures Note: Zmeya containers can be freely moved in
+   memory and deserialize from raw bytes without any extra work.
+*/
+/*
+    DeduplicationStats - BlobBuilder content-addressed deduplication counters
+*/
+struct DeduplicationStats
+{
+    // number of regions stored in the blob (and available for deduplication)
+    size_t numUniqueRegions = 0;
+    // number of copies replaced by a reference to an identical region
+    size_t numDeduplicatedRegions = 0;
+    // number of blob bytes saved (excluding alignment padding)
+    size_t numBytesSaved = 0;
+};
+
+class BlobBuilder : public std::enable_shared_from_this<BlobBuilder>
+{
+    BlobStorage data;
+    // incremented on every reset
+    uint32_t generation = 0;
+
+    // content-addressed deduplication (hash of the region bytes -> region)
+    struct DeduplicatedRegion
+    {
+        offset_t absoluteOffset;
+        size_t numBytes;
+    };
+    std::unordered_multimap<uint64_t, DeduplicatedRegion> deduplicatedRegions;
+    DeduplicationStats deduplicationStats;
+    bool deduplicationEnabled = false;
+
+    // pointer sites recorded for the relocation table
+    std::vector<BlobRelocation> relocations;
+    bool relocationTableEnabled = false;
+
+    // reserved pool capacities (pool offset -> capacity, see reservePool)
+    std::unordered_map<offset_t, size_t> poolCapacities;
+
+#ifdef ZMEYA_VALIDATE_BLOBPTR
+    uint64_t serial = 0;
+
+    // registry of alive builders (builder -> serial)
+    struct Registry
+    {
+        std::mutex mutex;
+        std::unordered_map<const BlobBuilder*, uint64_t> alive;
+        uint64_t nextSerial = 1;
+    };
+
+    static Registry& getRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    ZMEYA_NODISCARD static bool isAlive(const BlobBuilder* builder, uint64_t serial)
+    {
+        Registry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        auto it = registry.alive.find(builder);
+        return it != registry.alive.end() && it->second == serial;
+    }
+#endif
+
+  private:
+#ifdef ZMEYA_FAST_BLOBPTR
+    ZMEYA_NODISCARD BlobBuilderRef getRef() const { return BlobBuilderRef(this); }
+#else
+    ZMEYA_NODISCARD BlobBuilderRef getRef() const { return weak_from(this); }
+#endif
+
+    ZMEYA_NODISCARD const char* get(offset_t absoluteOffset) const
+    {
+        ZMEYA_ASSERT(absoluteOffset < data.size());
+        return data.at(absoluteOffset);
+    }
+
+    // region [absoluteOffset, size) has just been allocated at the tail of the blob (sizeBefore = blob size before the allocation)
+    // if an identical region already exists, the allocation is rolled back and the offset of the existing region is returned
+    offset_t deduplicateTail(size_t sizeBefore, offset_t absoluteOffset, size_t alignment)
+    {
+        size_t numBytes = data.size() - absoluteOffset;
+        if (!deduplicationEnabled || numBytes == 0)
+        {
+            return absoluteOffset;
+        }
+
+        const char* bytes = data.at(absoluteOffset);
+        uint32_t numBytesToHash = uint32_t(std::min(numBytes, size_t(std::numeric_limits<uint32_t>::max())));
+        uint64_t hash = murmur_hash_process64a(bytes, numBytesToHash, uint64_t(numBytes));
+        auto range = deduplicatedRegions.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            const DeduplicatedRegion& region = it->second;
+            // the existing region must be in memory and have the same alignment (internal padding depends on it)
+            if (region.numBytes != numBytes || region.absoluteOffset < data.getFlushedSize() ||
+                (size_t(diff(region.absoluteOffset, absoluteOffset)) & (alignment - 1)) != 0 ||
+                std::memcmp(data.at(region.absoluteOffset), bytes, numBytes) != 0)
+            {
+                continue;
+            }
+            deduplicationStats.numDeduplicatedRegions++;
+            deduplicationStats.numBytesSaved += numBytes;
+            data.resize(sizeBefore);
+            return region.absoluteOffset;
+        }
+
+        deduplicatedRegions.emplace(hash, DeduplicatedRegion{absoluteOffset, numBytes});
+        deduplicationStats.numUniqueRegions++;
+        return absoluteOffset;
+    }
+
+    // sort the recorded pointer sites (the last assignment of the site wins) and write the relocation table
+    // the table header is placed right in front of the footer
+    void writeRelocationTable(size_t desiredSizeShouldBeMultipleOf)
+    {
+        using uoffset_t = std::make_unsigned<roffset_t>::type;
+        std::stable_sort(relocations.begin(), relocations.end(),
+                         [](const BlobRelocation& a, const BlobRelocation& b) { return a.siteOffset < b.siteOffset; });
+        size_t numRelocations = 0;
+        for (size_t i = 0; i < relocations.size(); i++)
+        {
+            const BlobRelocation relocation = relocations[i];
+            if (i + 1 < relocations.size() && relocations[i + 1].siteOffset == relocation.siteOffset)
+            {
+                continue;
+            }
+            // the site was reset to the null pointer later (the flushed sites can't be checked)
+            offset_t targetOffset = 0;
+            bool isInMemory = relocation.siteOffset >= data.getFlushedSize();
+            if (isInMemory && !readBlobRelocationTarget(data.at(relocation.siteOffset), relocation, targetOffset))
+            {
+                continue;
+            }
+            relocations[numRelocations++] = relocation;
+        }
+        relocations.resize(numRelocations);
+
+        size_t tableOffset = alignBlobOffset(data.size(), alignof(uoffset_t));
+        size_t tableSize = numRelocations * (sizeof(uoffset_t) * 2 + sizeof(uint8_t));
+        size_t tableEnd = tableOffset + tableSize + sizeof(BlobRelocationTableHeader);
+        size_t headerOffset = getBlobFooterOffset(tableEnd, desiredSizeShouldBeMultipleOf) - sizeof(BlobRelocationTableHeader);
+        allocate(headerOffset + sizeof(BlobRelocationTableHeader) - data.size(), 1);
+
+        uoffset_t* siteOffsets = getDirectMemoryAccessUnsafe<uoffset_t>(tableOffset);
+        uoffset_t* targetOffsets = siteOffsets + numRelocations;
+        uint8_t* types = reinterpret_cast<uint8_t*>(targetOffsets + numRelocations);
+        for (size_t i = 0; i < numRelocations; i++)
+        {
+            const BlobRelocation& relocation = relocations[i];
+            siteOffsets[i] = uoffset_t(relocation.siteOffset);
+            targetOffsets[i] = uoffset_t(relocation.targetOffset);
+            types[i] = uint8_t(uint8_t(relocation.type) | (relocation.numTagBits << 4));
+        }
+        BlobRelocationTableHeader* header = getDirectMemoryAccessUnsafe<BlobRelocationTableHeader>(headerOffset);
+        header->tableOffset = uint64_t(tableOffset);
+        header->numRelocations = uint64_t(numRelocations);
+    }
+
+    // split [0..numItems) into contiguous ranges and call func(firstIndex, count) for each range from the worker threads
+    // numThreads = 0 - use all available hardware threads, the calling thread processes the first range
+    template <typename Func> static void parallelFor(size_t numItems, size_t numThreads, size_t minItemsPerThread, Func&& func)
+    {
+        if (numItems == 0)
+        {
+            return;
+        }
+        if (numThreads == 0)
+        {
+            numThreads = std::max(size_t(std::thread::hardware_concurrency()), size_t(1));
+        }
+        minItemsPerThread = std::max(minItemsPerThread, size_t(1));
+        numThreads = std::min(numThreads, (numItems + minItemsPerThread - 1) / minItemsPerThread);
+        numThreads = std::max(numThreads, size_t(1));
+
+        size_t itemsPerThread = (numItems + numThreads - 1) / numThreads;
+        std::vector<std::thread> threads;
+        threads.reserve(numThreads - 1);
+        for (size_t threadIndex = 1; threadIndex < numThreads; threadIndex++)
+        {
+            size_t firstIndex = threadIndex * itemsPerThread;
+            if (firstIndex >= numItems)
+            {
+                break;
+            }
+            size_t count = std::min(itemsPerThread, numItems - firstIndex);
+            threads.emplace_back([&func, firstIndex, count]() { func(firstIndex, count); });
+        }
+        func(size_t(0), std::min(itemsPerThread, numItems));
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    ZMEYA_NODISCARD static Span<const char> getStringSpan(const std::string& str) noexcept
+    {
+        return Span<const char>(str.c_str(), str.size());
+    }
+    ZMEYA_NODISCARD static Span<const char> getStringSpan(const char* str) noexcept { return Span<const char>(str, std::strlen(str)); }
+
+    struct PrivateToken
+    {
+    };
+
+    friend class BlobLinker;
+
+  public:
+    BlobBuilder() = delete;
+
+    BlobBuilder(size_t initialSizeInBytes, BlobStorageType storageType, size_t reserveSizeInBytes, PrivateToken)
+        : data(storageType, initialSizeInBytes, reserveSizeInBytes)
+    {
+        static_assert(std::is_trivially_copyable<Pointer<int>>::value, "Pointer is_trivially_copyable check failed");
+        static_assert(std::is_trivially_copyable<Array<int>>::value, "Array is_trivially_copyable check failed");
+        static_assert(std::is_trivially_copyable<HashSet<int>>::value, "HashSet is_trivially_copyable check failed");
+        static_assert(std::is_trivially_copyable<Pair<int, float>>::value, "Pair is_trivially_copyable check failed");
+        static_assert(std::is_trivially_copyable<HashMap<int, int>>::value, "HashMap is_trivially_copyable check failed");
+        static_assert(std::is_trivially_copyable<String>::value, "String is_trivially_copyable check failed");
+        static_assert(std::is_trivially_copyable<BitSet>::value, "BitSet is_trivially_copyable check failed");
+        static_assert(std::is_trivially_copyable<JaggedArray<int>>::value, "JaggedArray is_trivially_copyable check failed");
+        static_assert(std::is_trivially_copyable<Pointer16<int>>::value, "Pointer16 is_trivially_copyable check failed");
+        static_assert(std::is_trivially_copyable<SmallArray<int>>::value, "SmallArray is_trivially_copyable check failed");
+
+#ifdef ZMEYA_VALIDATE_BLOBPTR
+        Registry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        serial = registry.nextSerial++;
+        registry.alive[this] = serial;
+#endif
+    }
+
+#ifdef ZMEYA_VALIDATE_BLOBPTR
+    ~BlobBuilder()
+    {
+        Registry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.alive.erase(this);
+    }
+#else
+    ~BlobBuilder() = default;
+#endif
+
+    bool containsPointer(const void* p) const
+    {
+        return (!data.empty() && (p >= data.data() && p < data.data() + (data.size() - data.getFlushedSize())));
+    }
+
+    // get BlobPtr to the object located inside the blob
+    template <typename T> ZMEYA_NODISCARD BlobPtr<T> getBlobPtr(const T* p) const
+    {
+        ZMEYA_ASSERT(containsPointer(p));
+        offset_t absoluteOffset = offset_t(data.getFlushedSize()) + diffAddr(uintptr_t(p), uintptr_t(data.data()));
+        return BlobPtr<T>(getRef(), generation, absoluteOffset);
+    }
+
+    // rewind the builder to the empty state, but keep the allocated memory
+    // Note: all outstanding BlobPtrs and the spans returned by finalize() become invalid
+    void reset()
+    {
+        // the streaming builder can't be reused
+        ZMEYA_ASSERT(data.getType() != BlobStorageType::Streaming);
+        data.resize(0);
+        generation++;
+        deduplicatedRegions.clear();
+        deduplicationStats = DeduplicationStats();
+        relocations.clear();
+        poolCapacities.clear();
+    }
+
+    // content-addressed deduplication: identical strings, arrays copied with copyToArrayFast and hash containers of trivially
+    // copyable items are stored in the blob only once
+    // Note: deduplicated data is shared between the containers and must not be modified after the copy
+    void setDeduplicationEnabled(bool enabled) { deduplicationEnabled = enabled; }
+    ZMEYA_NODISCARD bool isDeduplicationEnabled() const noexcept { return deduplicationEnabled; }
+    ZMEYA_NODISCARD const DeduplicationStats& getDeduplicationStats() const noexcept { return deduplicationStats; }
+
+    // record every pointer site and write the relocation table in front of the footer (see getBlobRelocations)
+    void setRelocationTableEnabled(bool enabled) { relocationTableEnabled = enabled; }
+    ZMEYA_NODISCARD bool isRelocationTableEnabled() const noexcept { return relocationTableEnabled; }
+
+    // make sure that at least sizeInBytes bytes can be allocated without growing the storage
+    void reserve(size_t sizeInBytes) { data.reserve(sizeInBytes); }
+
+    ZMEYA_NODISCARD size_t getSize() const noexcept { return data.size(); }
+    ZMEYA_NODISCARD size_t getCapacity() const noexcept { return data.capacity(); }
+
+    // streaming: write all the bytes below the watermark to the file and release them from memory
+    // Note: the flushed data can't be accessed anymore, use patchPointer/patchArray for the late fix-ups
+    void flush(offset_t watermark)
+    {
+        data.flush(watermark);
+        for (auto it = deduplicatedRegions.begin(); it != deduplicatedRegions.end();)
+        {
+            it = (it->second.absoluteOffset < watermark) ? deduplicatedRegions.erase(it) : std::next(it);
+        }
+    }
+
+    // streaming: number of bytes already written to the file
+    ZMEYA_NODISCARD size_t getFlushedSize() const noexcept { return data.getFlushedSize(); }
+
+    // streaming / file mapping: true if writing to the file failed
+    ZMEYA_NODISCARD bool hasIoError() const noexcept { return data.hasIoError(); }
+
+    // external buffer: true if the blob didn't fit into the caller-provided buffer (the blob is built in the heap memory instead)
+    ZMEYA_NODISCARD bool hasOverflowed() const noexcept { return data.hasOverflowed(); }
+
+    // assign the pointer, the pointer can be already flushed (streaming)
+    template <typename T> void patchPointer(const BlobPtr<Pointer<T>>& dst, const BlobPtr<T>& target)
+    {
+        Pointer<T> value;
+        value.relativeOffset = toRelativeOffset(diff(target.getAbsoluteOffset(), dst.getAbsoluteOffset()));
+        ZMEYA_ASSERT(value.relativeOffset != 0);
+        data.write(dst.getAbsoluteOffset(), &value, sizeof(value));
+        addRelocation(dst.getAbsoluteOffset(), target.getAbsoluteOffset(), BlobRelocationType::Pointer);
+    }
+
+    // assign the array, the array can be already flushed (streaming)
+    template <typename T> void patchArray(const BlobPtr<Array<T>>& dst, const BlobPtr<T>& firstElement, size_t numElements)
+    {
+        ZMEYA_ASSERT(uint64_t(numElements) < uint64_t(std::numeric_limits<asize_t>::max()));
+        Array<T> value;
+        value.relativeOffset = toRelativeOffset(diff(firstElement.getAbsoluteOffset(), dst.getAbsoluteOffset()));
+        value.numElements = asize_t(numElements);
+        data.write(dst.getAbsoluteOffset(), &value, sizeof(value));
+        addRelocation(dst.getAbsoluteOffset(), firstElement.getAbsoluteOffset(), BlobRelocationType::Array);
+    }
+
+    // storage type (VirtualMemory can fall back to Vector if the address space reservation failed)
+    ZMEYA_NODISCARD BlobStorageType getStorageType() const noexcept { return data.getType(); }
+
+    // true if the blob memory is never relocated, so raw pointers into the blob remain valid while building
+    ZMEYA_NODISCARD bool hasStableAddresses() const noexcept { return data.hasStableAddresses(); }
+
+    BlobPtr<char> allocate(size_t numBytes, size_t alignment)
+    {
+        ZMEYA_ASSERT(isPowerOfTwo(alignment));
+        ZMEYA_ASSERT(alignment < ZMEYA_MAX_ALIGN);
+        //
+        size_t cursor = data.size();
+
+        // padding / alignment
+        size_t absoluteOffset = alignBlobOffset(cursor, alignment);
+        size_t numBytesToAllocate = numBytes + (absoluteOffset - cursor);
+
+        // Allocate more memory
+        // Note: new memory is filled with zeroes
+        // Zmeya containers rely on this behavior and we want to have all the padding zeroed as well
+        data.resize(data.size() + numBytesToAllocate);
+
+        // check alignment
+        ZMEYA_ASSERT((uintptr_t(data.at(absoluteOffset)) & (alignment - 1)) == 0);
+        ZMEYA_ASSERT(absoluteOffset < size_t(std::numeric_limits<offset_t>::max()));
+        return BlobPtr<char>(getRef(), generation, offset_t(absoluteOffset));
+    }
+
+    // allocate a byte range and copy the bytes into the blob (single resize + memcpy)
+    // numZeroBytesAfter - number of extra zero bytes after the copied bytes (null terminator, padding, etc)
+    BlobPtr<char> allocateBytes(Span<const char> bytes, size_t alignment = 1, size_t numZeroBytesAfter = 0)
+    {
+        ZMEYA_ASSERT(isPowerOfTwo(alignment));
+        ZMEYA_ASSERT(alignment < ZMEYA_MAX_ALIGN);
+
+        // zeroed padding / alignment
+        size_t absoluteOffset = alignBlobOffset(data.size(), alignment);
+        data.resize(absoluteOffset);
+        // copy bytes (without zero filling them first)
+        data.append(bytes.data, bytes.size);
+        if (numZeroBytesAfter > 0)
+        {
+            data.resize(data.size() + numZeroBytesAfter);
+        }
+
+        ZMEYA_ASSERT(absoluteOffset < size_t(std::numeric_limits<offset_t>::max()));
+        return BlobPtr<char>(getRef(), generation, offset_t(absoluteOffset));
+    }
+
+    // allocate a byte range and copy the bytes into the blob (single resize + memcpy)
+    BlobPtr<char> allocateBytes(const void* src, size_t numBytes, size_t alignment = 1)
+    {
+        return allocateBytes(Span<const char>(reinterpret_cast<const char*>(src), numBytes), alignment);
+    }
+
+    template <typename T, typename... _Valty> void placementCtor(void* ptr, _Valty&&... _Val)
+    {
+        ::new (const_cast<void*>(static_cast<const volatile void*>(ptr))) T(std::forward<_Valty>(_Val)...);
+    }
+
+    template <typename T, typename... _Valty> BlobPtr<T> allocate(_Valty&&... _Val)
+    {
+        // compile time checks
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types allowed");
+        constexpr size_t alignOfT = std::alignment_of<T>::value;
+        static_assert(isPowerOfTwo(alignOfT), "Non power of two alignment not supported");
+        static_assert(alignOfT < ZMEYA_MAX_ALIGN, "Unsupported alignment");
+        constexpr size_t sizeOfT = sizeof(T);
+
+        BlobPtr<char> ptr = allocate(sizeOfT, alignOfT);
+
+        placementCtor<T>(ptr.get(), std::forward<_Valty>(_Val)...);
+
+        return BlobPtr<T>(getRef(), generation, ptr.getAbsoluteOffset());
+    }
+
+    template <typename T> T* getDirectMemoryAccessUnsafe(offset_t absoluteOffset)
+    {
+        const char* p = get(absoluteOffset);
+        return const_cast<T*>(reinterpret_cast<const T*>(p));
+    }
+
+    template <typename T> void setArrayOffset(const BlobPtr<Array<T>>& dst, offset_t absoluteOffset)
+    {
+        dst->relativeOffset = toRelativeOffset(diff(absoluteOffset, dst.getAbsoluteOffset()));
+        addRelocation(dst.getAbsoluteOffset(), absoluteOffset, BlobRelocationType::Array);
+    }
+
+    void addRelocation(offset_t siteOffset, offset_t targetOffset, BlobRelocationType type, uint8_t numTagBits = 0)
+    {
+        if (relocationTableEnabled)
+        {
+            relocations.push_back(BlobRelocation{siteOffset, targetOffset, type, numTagBits});
+        }
+    }
+
+    template <typename T> offset_t resizeArrayWithoutInitialization(Array<T>& _dst, size_t numElements)
+    {
+        constexpr size_t alignOfT = std::alignment_of<T>::value;
+        constexpr size_t sizeOfT = sizeof(T);
+        static_assert((sizeOfT % alignOfT) == 0, "The size must be a multiple of the alignment");
+
+        BlobPtr<Array<T>> dst = getBlobPtr(&_dst);
+        // An array can be assigned/resized only once (non empty array detected)
+        ZMEYA_ASSERT(dst->relativeOffset == 0 && dst->numElements == 0);
+
+        BlobPtr<char> arrData = allocate(sizeOfT * numElements, alignOfT);
+        ZMEYA_ASSERT(uint64_t(numElements) < uint64_t(std::numeric_limits<asize_t>::max()));
+        dst->numElements = asize_t(numElements);
+        setArrayOffset(dst, arrData.getAbsoluteOffset());
+        return arrData.getAbsoluteOffset();
+    }
+
+    // get writeable pointer to array element
+    template <typename T> ZMEYA_NODISCARD BlobPtr<T> getArrayElement(Array<T>& arr, const size_t index) const noexcept
+    {
+        T* rawElementPtr = arr.getData() + index;
+        BlobPtr<T> element = getBlobPtr(rawElementPtr);
+        return element;
+    }
+
+    // resize array (using copy constructor)
+    template <typename T> offset_t resizeArray(Array<T>& _dst, size_t numElements, const T& emptyElement)
+    {
+        offset_t absoluteOffset = resizeArrayWithoutInitialization(_dst, numElements);
+        if (numElements == 0)
+        {
+            return absoluteOffset;
+        }
+        T* current = getDirectMemoryAccessUnsafe<T>(absoluteOffset);
+        for (size_t i = 0; i < numElements; i++)
+        {
+            // call copy ctor
+            placementCtor<T>(current, emptyElement);
+            current++;
+        }
+        return absoluteOffset;
+    }
+
+    // resize array (using default constructor)
+    template <typename T> offset_t resizeArray(Array<T>& _dst, size_t numElements)
+    {
+        offset_t absoluteOffset = resizeArrayWithoutInitialization(_dst, numElements);
+        if (numElements == 0)
+        {
+            return absoluteOffset;
+        }
+        T* current = getDirectMemoryAccessUnsafe<T>(absoluteOffset);
+        for (size_t i = 0; i < numElements; i++)
+        {
+            // default ctor
+            placementCtor<T>(current);
+            current++;
+        }
+        return absoluteOffset;
+    }
+
+    // copyTo array fast (without using convertor)
+    template <typename T> offset_t copyToArrayFast(BlobPtr<Array<T>> dst, const T* begin, size_t numElements)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types allowed");
+        // An array can be assigned/resized only once (non empty array detected)
+        ZMEYA_ASSERT(dst->relativeOffset == 0 && dst->numElements == 0);
+        ZMEYA_ASSERT(uint64_t(numElements) < uint64_t(std::numeric_limits<asize_t>::max()));
+
+        size_t sizeBefore = data.size();
+        BlobPtr<char> arrData = allocateBytes(begin, sizeof(T) * numElements, alignof(T));
+        offset_t absoluteOffset = deduplicateTail(sizeBefore, arrData.getAbsoluteOffset(), alignof(T));
+        dst->numElements = asize_t(numElements);
+        setArrayOffset(dst, absoluteOffset);
+        return absoluteOffset;
+    }
+
+    // copyTo array fast (without using convertor)
+    template <typename T> offset_t copyToArrayFast(Array<T>& _dst, const T* begin, size_t numElements)
+    {
+        BlobPtr<Array<T>> dst = getBlobPtr(&_dst);
+        return copyToArrayFast(dst, begin, numElements);
+    }
+
+    // copyTo array from range
+    template <typename T, typename Iter, typename ConvertorFunc>
+    offset_t copyToArray(BlobPtr<Array<T>> dst, const Iter begin, const Iter end, int64_t size, ConvertorFunc convertorFunc)
+    {
+        size_t numElements = (size >= 0) ? size_t(size) : std::distance(begin, end);
+        resizeArray(*dst, numElements);
+
+        BlobPtr<T> firstElement = getBlobPtr(dst->data());
+        offset_t absoluteOffset = firstElement.getAbsoluteOffset();
+        offset_t currentIndex = 0;
+        for (Iter cur = begin; cur != end; ++cur)
+        {
+            offset_t currentItemAbsoluteOffset = absoluteOffset + sizeof(T) * currentIndex;
+            convertorFunc(this, currentItemAbsoluteOffset, *cur);
+            currentIndex++;
+        }
+        return absoluteOffset;
+    }
+
+    // copyTo array from range
+    template <typename T, typename Iter, typename ConvertorFunc>
+    offset_t copyToArray(Array<T>& _dst, const Iter begin, const Iter end, int64_t size, ConvertorFunc convertorFunc)
+    {
+        BlobPtr<Array<T>> dst = getBlobPtr(&_dst);
+        return copyToArray(dst, begin, end, size, convertorFunc);
+    }
+
+    // copyTo hash container
+    template <typename ItemSrcAdapter, typename ItemDstAdapter, typename HashType, typename Iter, typename ConvertorFunc>
+    void copyToHash(HashType& _dst, Iter begin, Iter end, int64_t size, ConvertorFunc convertorFunc)
+    {
+        // Note: this bucketing method relies on the fact that the input data set is (already) unique
+        size_t numElements = (size >= 0) ? size_t(size) : std::distance(begin, end);
+        ZMEYA_ASSERT(numElements > 0);
+        size_t numBuckets = numElements * 2;
+        ZMEYA_ASSERT(numBuckets < size_t(std::numeric_limits<uint32_t>::max()));
+        size_t hashMod = numBuckets;
+
+        BlobPtr<HashType> dst = getBlobPtr(&_dst);
+        // allocate buckets & items
+        resizeArray(dst->buckets, numBuckets);
+
+        // 1-st pass count the number of elements per bucket (beginIndex / endIndex)
+        typename HashType::Bucket* buckets = dst->buckets.get_raw_ptr_unsafe_can_be_relocated();
+        for (Iter cur = begin; cur != end; ++cur)
+        {
+            const auto& current = *cur;
+            size_t hash = ItemSrcAdapter::hash(current);
+            size_t bucketIndex = hash % hashMod;
+            buckets[bucketIndex].beginIndex++; // temporary use beginIndex to store the number of items
+        }
+
+        size_t beginIndex = 0;
+        for (size_t bucketIndex = 0; bucketIndex < numBuckets; bucketIndex++)
+        {
+            typename HashType::Bucket& bucket = buckets[bucketIndex];
+            size_t numElementsInBucket = bucket.beginIndex;
+            bucket.beginIndex = asize_t(beginIndex);
             bucket.endIndex = bucket.beginIndex;
             beginIndex += numElementsInBucket;
         }
 
-        // note: at this point this pointer is no longer valid (resize array can move data)
-        buckets = nullptr;
+        // note: at this point this pointer is no longer valid (resize array can move data)
+        buckets = nullptr;
+
+        // 2-st pass copy items
+        offset_t absoluteOffset = resizeArrayWithoutInitialization(dst->items, numElements);
+        for (Iter cur = begin; cur != end; ++cur)
+        {
+            const auto& current = *cur;
+            size_t hash = ItemSrcAdapter::hash(current);
+            size_t bucketIndex = hash % hashMod;
+            typename HashType::Bucket* bucket = dst->buckets.get_element_ptr_unsafe_can_be_relocated(bucketIndex);
+            asize_t elementIndex = bucket->endIndex;
+            offset_t currentItemAbsoluteOffset = absoluteOffset + sizeof(typename ItemDstAdapter::ItemType) * offset_t(elementIndex);
+            convertorFunc(this, currentItemAbsoluteOffset, *cur);
+
+            // Note: convertorFunc can allocate additional memory -> reallocate storage
+            //    Hence, we need to reacquire the pointer
+            bucket = dst->buckets.get_element_ptr_unsafe_can_be_relocated(bucketIndex);
+#ifdef ZMEYA_VALIDATE_HASH_DUPLICATES
+            const typename ItemDstAdapter::ItemType* lastItem =
+                getDirectMemoryAccessUnsafe<typename ItemDstAdapter::ItemType>(currentItemAbsoluteOffset);
+            size_t newItemHash = ItemDstAdapter::hash(*lastItem);
+            // inconsistent hashing! hash(srcItem) != hash(dstItem)
+            ZMEYA_ASSERT(hash == newItemHash);
+            for (asize_t testElementIndex = bucket->beginIndex; testElementIndex < bucket->endIndex; testElementIndex++)
+            {
+                offset_t testItemAbsoluteOffset = absoluteOffset + sizeof(typename ItemDstAdapter::ItemType) * offset_t(testElementIndex);
+                const typename ItemDstAdapter::ItemType* testItem =
+                    getDirectMemoryAccessUnsafe<typename ItemDstAdapter::ItemType>(testItemAbsoluteOffset);
+                ZMEYA_ASSERT(!ItemDstAdapter::eq(*testItem, *lastItem));
+            }
+#endif
+            bucket->endIndex++;
+        }
+    }
+
+    // copyTo hash container with position independent items (buckets + items can be shared with an identical hash container)
+    template <typename ItemSrcAdapter, typename ItemDstAdapter, typename HashType, typename Iter, typename ConvertorFunc>
+    void copyToHashDeduplicated(HashType& _dst, Iter begin, Iter end, int64_t size, ConvertorFunc convertorFunc)
+    {
+        BlobPtr<HashType> dst = getBlobPtr(&_dst);
+        size_t sizeBefore = data.size();
+        copyToHash<ItemSrcAdapter, ItemDstAdapter>(_dst, begin, end, size, convertorFunc);
+        if (!deduplicationEnabled)
+        {
+            return;
+        }
+
+        // buckets and items are allocated back to back, deduplicate them as a single region
+        offset_t bucketsOffset = getBlobPtr(dst->buckets.data()).getAbsoluteOffset();
+        offset_t itemsOffset = getBlobPtr(dst->items.data()).getAbsoluteOffset();
+        constexpr size_t alignment = std::max(alignof(typename HashType::Bucket), alignof(typename ItemDstAdapter::ItemType));
+        offset_t absoluteOffset = deduplicateTail(sizeBefore, bucketsOffset, alignment);
+        if (absoluteOffset != bucketsOffset)
+        {
+            setArrayOffset(getBlobPtr(&dst->buckets), absoluteOffset);
+            setArrayOffset(getBlobPtr(&dst->items), absoluteOffset + (itemsOffset - bucketsOffset));
+        }
+    }
+
+    // assignTo pointer
+    template <typename T> static void assignTo(Pointer<T>& dst, std::nullptr_t) { dst.relativeOffset = 0; }
+
+    // assignTo pointer from absolute offset
+    template <typename T> void assignTo(Pointer<T>& _dst, offset_t targetAbsoluteOffset)
+    {
+        BlobPtr<Pointer<T>> dst = getBlobPtr(&_dst);
+        roffset_t relativeOffset = toRelativeOffset(diff(targetAbsoluteOffset, dst.getAbsoluteOffset()));
+        ZMEYA_ASSERT(relativeOffset != 0);
+        dst->relativeOffset = relativeOffset;
+        addRelocation(dst.getAbsoluteOffset(), targetAbsoluteOffset, BlobRelocationType::Pointer);
+    }
+
+    // copyTo pointer from BlobPtr
+    template <typename T> void assignTo(Pointer<T>& dst, const BlobPtr<T>& src)
+    {
+        ZMEYA_ASSERT(src.generation == generation);
+        assignTo(dst, src.getAbsoluteOffset());
+    }
+
+    // assignTo variant pointer
+    template <typename... Ts> static void assignTo(VariantPointer<Ts...>& dst, std::nullptr_t) { dst.relativeOffset = 0; }
+
+    // assignTo variant pointer from absolute offset of the object of type U
+    template <typename U, typename... Ts> void assignTo(VariantPointer<Ts...>& _dst, offset_t targetAbsoluteOffset)
+    {
+        constexpr roffset_t typeIndex = roffset_t(VariantTypeIndex<U, Ts...>::value);
+        BlobPtr<VariantPointer<Ts...>> dst = getBlobPtr(&_dst);
+        roffset_t relativeOffset = toRelativeOffset(diff(targetAbsoluteOffset, dst.getAbsoluteOffset()));
+        ZMEYA_ASSERT(relativeOffset != 0);
+        // misaligned target
+        ZMEYA_ASSERT((relativeOffset & VariantPointer<Ts...>::kTagMask) == 0);
+        dst->relativeOffset = relativeOffset | typeIndex;
+        addRelocation(dst.getAbsoluteOffset(), targetAbsoluteOffset, BlobRelocationType::VariantPointer,
+                      uint8_t(popCount64(uint64_t(VariantPointer<Ts...>::kTagMask))));
+    }
+
+    // assignTo variant pointer from BlobPtr
+    template <typename U, typename... Ts> void assignTo(VariantPointer<Ts...>& dst, const BlobPtr<U>& src)
+    {
+        ZMEYA_ASSERT(src.generation == generation);
+        assignTo<U>(dst, src.getAbsoluteOffset());
+    }
+
+    // assignTo variant pointer from reference
+    template <typename U, typename... Ts> void assignTo(VariantPointer<Ts...>& dst, const U& src) { assignTo(dst, getBlobPtr(&src)); }
+
+    // copyTo pointer from RawPointer
+    template <typename T> void assignTo(Pointer<T>& dst, const T* _src)
+    {
+        const BlobPtr<T> src = getBlobPtr(_src);
+        assignTo(dst, src);
+    }
+
+    // copyTo pointer from reference
+    template <typename T> void assignTo(Pointer<T>& dst, const T& src) { assignTo(dst, &src); }
+
+    // assignTo 16-bit pointer
+    template <typename T> static void assignTo(Pointer16<T>& dst, std::nullptr_t) { dst.relativeOffset = 0; }
+
+    // assignTo 16-bit pointer from absolute offset
+    template <typename T> void assignTo(Pointer16<T>& _dst, offset_t targetAbsoluteOffset)
+    {
+        BlobPtr<Pointer16<T>> dst = getBlobPtr(&_dst);
+        diff_t relativeOffset = diff(targetAbsoluteOffset, dst.getAbsoluteOffset());
+        // target is too far away for the 16-bit pointer
+        ZMEYA_ASSERT(relativeOffset >= diff_t(std::numeric_limits<int16_t>::min()));
+        ZMEYA_ASSERT(relativeOffset <= diff_t(std::numeric_limits<int16_t>::max()));
+        ZMEYA_ASSERT(relativeOffset != 0);
+        dst->relativeOffset = int16_t(relativeOffset);
+        addRelocation(dst.getAbsoluteOffset(), targetAbsoluteOffset, BlobRelocationType::Pointer16);
+    }
+
+    // assignTo 16-bit pointer from BlobPtr
+    template <typename T> void assignTo(Pointer16<T>& dst, const BlobPtr<T>& src)
+    {
+        ZMEYA_ASSERT(src.generation == generation);
+        assignTo(dst, src.getAbsoluteOffset());
+    }
+
+    // assignTo 16-bit pointer from RawPointer
+    template <typename T> void assignTo(Pointer16<T>& dst, const T* src) { assignTo(dst, getBlobPtr(src)); }
+
+    // assignTo 16-bit pointer from reference
+    template <typename T> void assignTo(Pointer16<T>& dst, const T& src) { assignTo(dst, &src); }
+
+    // resize small array (data is zero initialized)
+    template <typename T> void setSmallArrayData(const BlobPtr<SmallArray<T>>& dst, offset_t absoluteOffset, size_t numElements)
+    {
+        diff_t relativeOffset = diff(absoluteOffset, dst.getAbsoluteOffset());
+        // array data is too far away from the array header
+        ZMEYA_ASSERT(relativeOffset >= diff_t(std::numeric_limits<int16_t>::min()));
+        ZMEYA_ASSERT(relativeOffset <= diff_t(std::numeric_limits<int16_t>::max()));
+        dst->relativeOffset = int16_t(relativeOffset);
+        dst->numElements = uint16_t(numElements);
+        addRelocation(dst.getAbsoluteOffset(), absoluteOffset, BlobRelocationType::SmallArray);
+    }
+
+    template <typename T> offset_t resizeArrayWithoutInitialization(SmallArray<T>& _dst, size_t numElements)
+    {
+        BlobPtr<SmallArray<T>> dst = getBlobPtr(&_dst);
+        // An array can be assigned/resized only once (non empty array detected)
+        ZMEYA_ASSERT(dst->relativeOffset == 0 && dst->numElements == 0);
+        ZMEYA_ASSERT(numElements <= size_t(std::numeric_limits<uint16_t>::max()));
+
+        BlobPtr<char> arrData = allocate(sizeof(T) * numElements, alignof(T));
+        setSmallArrayData(dst, arrData.getAbsoluteOffset(), numElements);
+        return arrData.getAbsoluteOffset();
+    }
+
+    // resize small array (using default constructor)
+    template <typename T> offset_t resizeArray(SmallArray<T>& dst, size_t numElements)
+    {
+        offset_t absoluteOffset = resizeArrayWithoutInitialization(dst, numElements);
+        for (size_t i = 0; i < numElements; i++)
+        {
+            // default ctor
+            placementCtor<T>(getDirectMemoryAccessUnsafe<T>(absoluteOffset + sizeof(T) * i));
+        }
+        return absoluteOffset;
+    }
+
+    // get writeable pointer to small array element
+    template <typename T> ZMEYA_NODISCARD BlobPtr<T> getArrayElement(SmallArray<T>& arr, const size_t index) const noexcept
+    {
+        ZMEYA_ASSERT(index < arr.size());
+        return getBlobPtr(arr.getData() + index);
+    }
+
+    // copyTo small array (memcpy)
+    template <typename T> offset_t copyToArrayFast(SmallArray<T>& _dst, const T* begin, size_t numElements)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types allowed");
+        BlobPtr<SmallArray<T>> dst = getBlobPtr(&_dst);
+        // An array can be assigned/resized only once (non empty array detected)
+        ZMEYA_ASSERT(dst->relativeOffset == 0 && dst->numElements == 0);
+        ZMEYA_ASSERT(numElements <= size_t(std::numeric_limits<uint16_t>::max()));
+
+        BlobPtr<char> arrData = allocateBytes(begin, sizeof(T) * numElements, alignof(T));
+        setSmallArrayData(dst, arrData.getAbsoluteOffset(), numElements);
+        return arrData.getAbsoluteOffset();
+    }
+
+    // copyTo small array from std::vector
+    template <typename T, typename TAllocator> void copyTo(SmallArray<T>& dst, const std::vector<T, TAllocator>& src)
+    {
+        ZMEYA_ASSERT(src.size() > 0);
+        copyToArrayFast(dst, src.data(), src.size());
+    }
+
+    // copyTo small array from std::initializer_list
+    template <typename T> void copyTo(SmallArray<T>& dst, std::initializer_list<T> list)
+    {
+        ZMEYA_ASSERT(list.size() > 0);
+        copyToArrayFast(dst, list.begin(), list.size());
+    }
+
+    // copyTo array from std::vector
+    template <typename T, typename TAllocator> void copyTo(Array<T>& dst, const std::vector<T, TAllocator>& src)
+    {
+        ZMEYA_ASSERT(src.size() > 0);
+        copyToArrayFast(dst, src.data(), src.size());
+    }
+
+    // specialization for vector of vectors
+    template <typename T, typename TAllocator1, typename TAllocator2>
+    void copyTo(Array<Array<T>>& dst, const std::vector<std::vector<T, TAllocator2>, TAllocator1>& src)
+    {
+        ZMEYA_ASSERT(src.size() > 0);
+        copyToArray(dst, src.begin(), src.end(), src.size(),
+                    [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const std::vector<T>& src)
+                    {
+                        Array<T>* dst = blobBuilder->getDirectMemoryAccessUnsafe<Array<T>>(dstAbsoluteOffset);
+                        blobBuilder->copyTo(*dst, src);
+                    });
+    }
+
+    // specialization for vector of strings
+    template <typename T, typename TAllocator> void copyTo(Array<String>& dst, const std::vector<T, TAllocator>& src)
+    {
+        ZMEYA_ASSERT(src.size() > 0);
+        copyToArray(dst, src.begin(), src.end(), src.size(),
+                    [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const T& src)
+                    {
+                        String* dst = blobBuilder->getDirectMemoryAccessUnsafe<String>(dstAbsoluteOffset);
+                        blobBuilder->copyTo(*dst, src);
+                    });
+    }
+
+    // parallel version of copyTo(Array<Array<T>>&, vector<vector<T>>), the result is byte identical to the serial version
+    // the layout is computed up front, then the worker threads copy the inner arrays into their slots
+    // numThreads = 0 - use all available hardware threads
+    template <typename T, typename TAllocator1, typename TAllocator2>
+    void copyToParallel(Array<Array<T>>& _dst, const std::vector<std::vector<T, TAllocator2>, TAllocator1>& src, size_t numThreads = 0)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types allowed");
+        static_assert(alignof(T) < ZMEYA_MAX_ALIGN, "Unsupported alignment");
+        ZMEYA_ASSERT(src.size() > 0);
+        // deduplication depends on the allocation order
+        if (deduplicationEnabled)
+        {
+            copyTo(_dst, src);
+            return;
+        }
+
+        BlobPtr<Array<Array<T>>> dst = getBlobPtr(&_dst);
+        resizeArray(*dst, src.size());
+        offset_t arraysOffset = getBlobPtr(dst->data()).getAbsoluteOffset();
+
+        // prefix sum (the same sequence of allocations as copyToArrayFast does)
+        std::vector<offset_t> offsets(src.size());
+        size_t cursor = data.size();
+        for (size_t i = 0; i < src.size(); i++)
+        {
+            ZMEYA_ASSERT(src[i].size() > 0);
+            ZMEYA_ASSERT(uint64_t(src[i].size()) < uint64_t(std::numeric_limits<asize_t>::max()));
+            cursor = alignBlobOffset(cursor, alignof(T));
+            offsets[i] = offset_t(cursor);
+            cursor += sizeof(T) * src[i].size();
+        }
+        ZMEYA_ASSERT(cursor < size_t(std::numeric_limits<offset_t>::max()));
+        // note: no allocations are allowed from this point, so the raw pointers remain valid
+        allocate(cursor - data.size(), 1);
+        Array<T>* arrays = getDirectMemoryAccessUnsafe<Array<T>>(arraysOffset);
+
+        parallelFor(src.size(), numThreads, 1024,
+                    [&](size_t firstIndex, size_t count)
+                    {
+                        for (size_t i = firstIndex; i < firstIndex + count; i++)
+                        {
+                            const std::vector<T, TAllocator2>& items = src[i];
+                            std::memcpy(data.at(offsets[i]), items.data(), sizeof(T) * items.size());
+                            Array<T>& arr = arrays[i];
+                            arr.numElements = asize_t(items.size());
+                            arr.relativeOffset = toRelativeOffset(diff(offsets[i], offset_t(arraysOffset + sizeof(Array<T>) * i)));
+                        }
+                    });
+        for (size_t i = 0; relocationTableEnabled && i < src.size(); i++)
+        {
+            addRelocation(offset_t(arraysOffset + sizeof(Array<T>) * i), offsets[i], BlobRelocationType::Array);
+        }
+    }
+
+    // parallel version of copyTo(Array<String>&, vector<T>), the result is byte identical to the serial version
+    // the layout is computed up front, then the worker threads copy the strings into their slots
+    // numThreads = 0 - use all available hardware threads
+    template <typename T, typename TAllocator>
+    void copyToParallel(Array<String>& _dst, const std::vector<T, TAllocator>& src, size_t numThreads = 0)
+    {
+        ZMEYA_ASSERT(src.size() > 0);
+        // deduplication depends on the allocation order
+        if (deduplicationEnabled)
+        {
+            copyTo(_dst, src);
+            return;
+        }
+
+        BlobPtr<Array<String>> dst = getBlobPtr(&_dst);
+        resizeArray(*dst, src.size());
+        offset_t stringsOffset = getBlobPtr(dst->data()).getAbsoluteOffset();
+
+        // prefix sum (string data + null terminator)
+        std::vector<offset_t> offsets(src.size());
+        size_t cursor = data.size();
+        for (size_t i = 0; i < src.size(); i++)
+        {
+            size_t len = getStringSpan(src[i]).size;
+            ZMEYA_ASSERT(len > 0);
+            offsets[i] = offset_t(cursor);
+            cursor += len + 1;
+        }
+        ZMEYA_ASSERT(cursor < size_t(std::numeric_limits<offset_t>::max()));
+        // note: no allocations are allowed from this point, so the raw pointers remain valid
+        // the allocated memory is zero filled, so all the null terminators are already in place
+        allocate(cursor - data.size(), 1);
+        String* strings = getDirectMemoryAccessUnsafe<String>(stringsOffset);
+
+        parallelFor(src.size(), numThreads, 4096,
+                    [&](size_t firstIndex, size_t count)
+                    {
+                        for (size_t i = firstIndex; i < firstIndex + count; i++)
+                        {
+                            Span<const char> str = getStringSpan(src[i]);
+                            std::memcpy(data.at(offsets[i]), str.data, str.size);
+                            offset_t stringAbsoluteOffset = offset_t(stringsOffset + sizeof(String) * i);
+                            strings[i].data.relativeOffset = toRelativeOffset(diff(offsets[i], stringAbsoluteOffset));
+                        }
+                    });
+        for (size_t i = 0; relocationTableEnabled && i < src.size(); i++)
+        {
+            addRelocation(offset_t(stringsOffset + sizeof(String) * i), offsets[i], BlobRelocationType::Pointer);
+        }
+    }
+
+    // copyTo array from std::initializer_list
+    template <typename T> void copyTo(Array<T>& dst, std::initializer_list<T> list)
+    {
+        ZMEYA_ASSERT(list.size() > 0);
+        copyToArrayFast(dst, list.begin(), list.size());
+    }
+
+    // copyTo array from std::initializer_list
+    template <typename T> void copyTo(BlobPtr<Array<T>> dst, std::initializer_list<T> list)
+    {
+        ZMEYA_ASSERT(list.size() > 0);
+        copyToArrayFast(dst, list.begin(), list.size());
+    }
+
+    // specialization for std::initializer_list<std::string>
+    void copyTo(Array<String>& dst, std::initializer_list<const char*> list)
+    {
+        ZMEYA_ASSERT(list.size() > 0);
+        copyToArray(dst, list.begin(), list.end(), list.size(),
+                    [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const char* const& src)
+                    {
+                        String* dst = blobBuilder->getDirectMemoryAccessUnsafe<String>(dstAbsoluteOffset);
+                        blobBuilder->copyTo(*dst, src);
+                    });
+    }
+
+    // specialization for std::initializer_list<std::string>
+    void copyTo(BlobPtr<Array<String>> dst, std::initializer_list<const char*> list)
+    {
+        ZMEYA_ASSERT(list.size() > 0);
+        copyToArray(dst, list.begin(), list.end(), list.size(),
+                    [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const char* const& src)
+                    {
+                        String* dst = blobBuilder->getDirectMemoryAccessUnsafe<String>(dstAbsoluteOffset);
+                        blobBuilder->copyTo(*dst, src);
+                    });
+    }
+
+    // copyTo array from std::array
+    template <typename T, size_t NumElements> void copyTo(Array<T>& dst, const std::array<T, NumElements>& src)
+    {
+        ZMEYA_ASSERT(src.size() > 0);
+        copyToArrayFast(dst, src.data(), src.size());
+    }
+
+    // specialization for array of strings
+    template <typename T, size_t NumElements> void copyTo(Array<String>& dst, const std::array<T, NumElements>& src)
+    {
+        ZMEYA_ASSERT(src.size() > 0);
+        copyToArray(dst, src.begin(), src.end(), src.size(),
+                    [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const T& src)
+                    {
+                        String* dst = blobBuilder->getDirectMemoryAccessUnsafe<String>(dstAbsoluteOffset);
+                        blobBuilder->copyTo(*dst, src);
+                    });
+    }
+
+    // copyTo hash set from std::unordered_set
+    template <typename Key, typename Hasher, typename KeyEq, typename TAllocator>
+    void copyTo(HashSet<Key>& dst, const std::unordered_set<Key, Hasher, KeyEq, TAllocator>& src)
+    {
+        typedef HashKeyAdapterGeneric<Key> DstItemAdapter;
+        typedef HashKeyAdapterGeneric<Key> SrcItemAdapter;
+
+        copyToHashDeduplicated<SrcItemAdapter, DstItemAdapter>(
+            dst, src.begin(), src.end(), src.size(),
+            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
+            {
+                typename DstItemAdapter::ItemType* dstElem =
+                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
+                *dstElem = srcElem;
+            });
+    }
+
+    // copyTo hash set from std::unordered_set (specialization for string key)
+    template <typename Hasher, typename KeyEq, typename TAllocator>
+    void copyTo(HashSet<String>& dst, const std::unordered_set<std::string, Hasher, KeyEq, TAllocator>& src)
+    {
+        typedef HashKeyAdapterStdString SrcItemAdapter;
+        typedef HashKeyAdapterGeneric<String> DstItemAdapter;
+
+        copyToHash<SrcItemAdapter, DstItemAdapter>(
+            dst, src.begin(), src.end(), src.size(),
+            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
+            {
+                typename DstItemAdapter::ItemType* dstElem =
+                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
+                blobBuilder->copyTo(*dstElem, srcElem);
+            });
+    }
+
+    // copyTo hash set from std::initializer_list
+    template <typename Key> void copyTo(HashSet<Key>& dst, std::initializer_list<Key> list)
+    {
+        typedef HashKeyAdapterGeneric<Key> SrcItemAdapter;
+        typedef HashKeyAdapterGeneric<Key> DstItemAdapter;
+
+        copyToHashDeduplicated<SrcItemAdapter, DstItemAdapter>(
+            dst, list.begin(), list.end(), list.size(),
+            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
+            {
+                typename DstItemAdapter::ItemType* dstElem =
+                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
+                *dstElem = srcElem;
+            });
+    }
+
+    // copyTo hash set from std::initializer_list (specialization for string key)
+    void copyTo(HashSet<String>& dst, std::initializer_list<std::string> list)
+    {
+        typedef HashKeyAdapterStdString SrcItemAdapter;
+        typedef HashKeyAdapterGeneric<String> DstItemAdapter;
+
+        copyToHash<SrcItemAdapter, DstItemAdapter>(
+            dst, list.begin(), list.end(), list.size(),
+            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
+            {
+                typename DstItemAdapter::ItemType* dstElem =
+                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
+                blobBuilder->copyTo(*dstElem, srcElem);
+            });
+    }
+
+    // copyTo hash map from std::unordered_map
+    template <typename Key, typename Value, typename Hasher, typename KeyEq, typename TAllocator>
+    void copyTo(HashMap<Key, Value>& dst, const std::unordered_map<Key, Value, Hasher, KeyEq, TAllocator>& src)
+    {
+        typedef HashKeyValueAdapterGeneric<std::pair<const Key, Value>> SrcItemAdapter;
+        typedef HashKeyValueAdapterGeneric<Pair<Key, Value>> DstItemAdapter;
+
+        copyToHashDeduplicated<SrcItemAdapter, DstItemAdapter>(
+            dst, src.begin(), src.end(), src.size(),
+            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
+            {
+                typename DstItemAdapter::ItemType* dstElem =
+                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
+                dstElem->first = srcElem.first;
+                dstElem->second = srcElem.second;
+            });
+    }
+
+    // copyTo hash set from std::unordered_map (specialization for string key)
+    template <typename Value, typename Hasher, typename KeyEq, typename TAllocator>
+    void copyTo(HashMap<String, Value>& dst, const std::unordered_map<std::string, Value, Hasher, KeyEq, TAllocator>& src)
+    {
+        typedef HashKeyValueAdapterStdString<Value> SrcItemAdapter;
+        typedef HashKeyValueAdapterGeneric<Pair<String, Value>> DstItemAdapter;
+
+        copyToHash<SrcItemAdapter, DstItemAdapter>(
+            dst, src.begin(), src.end(), src.size(),
+            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
+            {
+                typename DstItemAdapter::ItemType* dstElem =
+                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
+                dstElem->second = srcElem.second;
+                blobBuilder->copyTo(dstElem->first, srcElem.first);
+            });
+    }
+
+    // copyTo hash set from std::unordered_map (specialization for string value)
+    template <typename Key, typename Hasher, typename KeyEq, typename TAllocator>
+    void copyTo(HashMap<Key, String>& dst, const std::unordered_map<Key, std::string, Hasher, KeyEq, TAllocator>& src)
+    {
+        typedef HashKeyValueAdapterGeneric<std::pair<const Key, std::string>> SrcItemAdapter;
+        typedef HashKeyValueAdapterGeneric<Pair<Key, String>> DstItemAdapter;
+
+        copyToHash<SrcItemAdapter, DstItemAdapter>(
+            dst, src.begin(), src.end(), src.size(),
+            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
+            {
+                typename DstItemAdapter::ItemType* dstElem =
+                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
+                dstElem->first = srcElem.first;
+                blobBuilder->copyTo(dstElem->second, srcElem.second);
+            });
+    }
+
+    // copyTo hash set from std::unordered_map (specialization for string key/value)
+    template <typename Hasher, typename KeyEq, typename TAllocator>
+    void copyTo(HashMap<String, String>& dst, const std::unordered_map<std::string, std::string, Hasher, KeyEq, TAllocator>& src)
+    {
+        typedef HashKeyValueAdapterStdString<std::string> SrcItemAdapter;
+        typedef HashKeyValueAdapterGeneric<Pair<String, String>> DstItemAdapter;
+
+        copyToHash<SrcItemAdapter, DstItemAdapter>(
+            dst, src.begin(), src.end(), src.size(),
+            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
+            {
+                typename DstItemAdapter::ItemType* dstElem =
+                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
+                blobBuilder->copyTo(dstElem->first, srcElem.first);
+
+                dstElem = blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
+                blobBuilder->copyTo(dstElem->second, srcElem.second);
+            });
+    }
+
+    // copyTo hash map from std::initializer_list
+    template <typename Key, typename Value> void copyTo(HashMap<Key, Value>& dst, std::initializer_list<std::pair<const Key, Value>> list)
+    {
+        typedef HashKeyValueAdapterGeneric<std::pair<const Key, Value>> SrcItemAdapter;
+        typedef HashKeyValueAdapterGeneric<Pair<Key, Value>> DstItemAdapter;
+
+        copyToHashDeduplicated<SrcItemAdapter, DstItemAdapter>(
+            dst, list.begin(), list.end(), list.size(),
+            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
+            {
+                typename DstItemAdapter::ItemType* dstElem =
+                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
+                dstElem->first = srcElem.first;
+                dstElem->second = srcElem.second;
+            });
+    }
+
+    // copyTo hash map from std::initializer_list (specialization for string key)
+    template <typename Value> void copyTo(HashMap<String, Value>& dst, std::initializer_list<std::pair<const std::string, Value>> list)
+    {
+        typedef HashKeyValueAdapterStdString<Value> SrcItemAdapter;
+        typedef HashKeyValueAdapterGeneric<Pair<String, Value>> DstItemAdapter;
+
+        copyToHash<SrcItemAdapter, DstItemAdapter>(
+            dst, list.begin(), list.end(), list.size(),
+            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
+            {
+                typename DstItemAdapter::ItemType* dstElem =
+                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
+                dstElem->second = srcElem.second;
+                blobBuilder->copyTo(dstElem->first, srcElem.first);
+            });
+    }
+
+    // copyTo hash map from std::initializer_list (specialization for string value)
+    template <typename Key> void copyTo(HashMap<Key, String>& dst, std::initializer_list<std::pair<const Key, std::string>> list)
+    {
+        typedef HashKeyValueAdapterGeneric<std::pair<const Key, std::string>> SrcItemAdapter;
+        typedef HashKeyValueAdapterGeneric<Pair<Key, String>> DstItemAdapter;
+
+        copyToHash<SrcItemAdapter, DstItemAdapter>(
+            dst, list.begin(), list.end(), list.size(),
+            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
+            {
+                typename DstItemAdapter::ItemType* dstElem =
+                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
+                dstElem->first = srcElem.first;
+                blobBuilder->copyTo(dstElem->second, srcElem.second);
+            });
+    }
+
+    // copyTo hash map from std::initializer_list (specialization for string key)
+    void copyTo(HashMap<String, String>& dst, std::initializer_list<std::pair<const std::string, std::string>> list)
+    {
+        typedef HashKeyValueAdapterStdString<std::string> SrcItemAdapter;
+        typedef HashKeyValueAdapterGeneric<Pair<String, String>> DstItemAdapter;
+
+        copyToHash<SrcItemAdapter, DstItemAdapter>(
+            dst, list.begin(), list.end(), list.size(),
+            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
+            {
+                typename DstItemAdapter::ItemType* dstElem =
+                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
+                blobBuilder->copyTo(dstElem->first, srcElem.first);
+
+                dstElem = blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
+                blobBuilder->copyTo(dstElem->second, srcElem.second);
+            });
+    }
+
+    // copyTo string from const char* and size
+    void copyTo(BlobPtr<String> dst, const char* src, size_t len)
+    {
+        ZMEYA_ASSERT(src != nullptr && len > 0);
+        // string data + null terminator
+        size_t sizeBefore = data.size();
+        BlobPtr<char> stringData = allocateBytes(Span<const char>(src, len), 1, 1);
+        assignTo(dst->data, deduplicateTail(sizeBefore, stringData.getAbsoluteOffset(), 1));
+    }
+
+    void copyTo(String& _dst, const char* src, size_t len)
+    {
+        BlobPtr<String> dst(getBlobPtr(&_dst));
+        copyTo(dst, src, len);
+    }
+
+    // copyTo string from std::string
+    void copyTo(String& dst, const std::string& src) { copyTo(dst, src.c_str(), src.size()); }
+
+    // copyTo string from null teminated c-string
+    void copyTo(String& _dst, const char* src)
+    {
+        ZMEYA_ASSERT(src != nullptr);
+        size_t len = std::strlen(src);
+        copyTo(_dst, src, len);
+    }
+
+    void referTo(BlobPtr<String> dst, const String& src)
+    {
+        BlobPtr<char> stringData = getBlobPtr(src.c_str());
+        assignTo(dst->data, stringData);
+    }
+
+    // referTo another String (it is not a copy, the destination string will refer to the same data)
+    void referTo(String& dst, const String& src)
+    {
+        BlobPtr<char> stringData = getBlobPtr(src.c_str());
+        assignTo(dst.data, stringData);
+    }
+
+    // referTo string data at the given absolute offset
+    void referTo(String& dst, offset_t absoluteOffset) { assignTo(dst.data, absoluteOffset); }
+
+    // referTo another Array (it is not a copy, the destination string will refer to the same data)
+    template <typename T> void referTo(Array<T>& _dst, const Array<T>& src)
+    {
+        BlobPtr<Array<T>> dst = getBlobPtr(&_dst);
+        BlobPtr<T> arrData = getBlobPtr(src.data());
+        dst->numElements = asize_t(src.size());
+        setArrayOffset(dst, arrData.getAbsoluteOffset());
+    }
+
+    // referTo array data at the given absolute offset
+    template <typename T> void referTo(Array<T>& _dst, offset_t absoluteOffset, size_t numElements)
+    {
+        BlobPtr<Array<T>> dst = getBlobPtr(&_dst);
+        ZMEYA_ASSERT(uint64_t(numElements) < uint64_t(std::numeric_limits<asize_t>::max()));
+        dst->numElements = asize_t(numElements);
+        setArrayOffset(dst, absoluteOffset);
+    }
+
+    // referTo another HashSet (it is not a copy, the destination string will refer to the same data)
+    template <typename Key> void referTo(HashSet<Key>& dst, const HashSet<Key>& src)
+    {
+        referTo(dst.buckets, src.buckets);
+        referTo(dst.items, src.items);
+    }
+
+    // referTo another HashMap (it is not a copy, the destination string will refer to the same data)
+    template <typename Key, typename Value> void referTo(HashMap<Key, Value>& dst, const HashMap<Key, Value>& src)
+    {
+        referTo(dst.buckets, src.buckets);
+        referTo(dst.items, src.items);
+    }
+
+    // copyTo bit set from pre-packed words (unused bits of the last word must be zero)
+    void copyTo(BitSet& _dst, const uint64_t* words, size_t numWords, size_t numBits)
+    {
+        ZMEYA_ASSERT(numWords == (numBits + BitSet::kBitsPerWord - 1) / BitSet::kBitsPerWord);
+        ZMEYA_ASSERT(numBits < size_t(std::numeric_limits<uint32_t>::max()));
+        BlobPtr<BitSet> dst = getBlobPtr(&_dst);
+        // A bit set can be assigned only once (non empty bit set detected)
+        ZMEYA_ASSERT(dst->numBits == 0);
+
+        size_t numBlocks = (numWords + BitSet::kWordsPerBlock - 1) / BitSet::kWordsPerBlock;
+        std::vector<uint32_t> ranks(numBlocks);
+        size_t numSetBits = 0;
+        for (size_t i = 0; i < numWords; i++)
+        {
+            if ((i % BitSet::kWordsPerBlock) == 0)
+            {
+                ranks[i / BitSet::kWordsPerBlock] = uint32_t(numSetBits);
+            }
+            numSetBits += popCount64(words[i]);
+        }
+
+        if (numWords > 0)
+        {
+            copyToArrayFast(dst->words, words, numWords);
+            copyToArrayFast(dst->ranks, ranks.data(), ranks.size());
+        }
+        dst->numBits = uint32_t(numBits);
+        dst->numSetBits = uint32_t(numSetBits);
+    }
 
-        // 2-st pass copy items
-        offset_t absoluteOffset = resizeArrayWithoutInitialization(dst->items, numElements);
+    // copyTo bit set from std::vector<bool>
+    template <typename TAllocator> void copyTo(BitSet& dst, const std::vector<bool, TAllocator>& src)
+    {
+        std::vector<uint64_t> words((src.size() + BitSet::kBitsPerWord - 1) / BitSet::kBitsPerWord, uint64_t(0));
+        for (size_t i = 0; i < src.size(); i++)
+        {
+            if (src[i])
+            {
+                words[i / BitSet::kBitsPerWord] |= uint64_t(1) << (i % BitSet::kBitsPerWord);
+            }
+        }
+        copyTo(dst, words.data(), words.size(), src.size());
+    }
+
+    // copyTo bit set from the list of set bit indices
+    template <typename Iter> void copyToBitSet(BitSet& dst, Iter begin, Iter end, size_t numBits)
+    {
+        std::vector<uint64_t> words((numBits + BitSet::kBitsPerWord - 1) / BitSet::kBitsPerWord, uint64_t(0));
         for (Iter cur = begin; cur != end; ++cur)
         {
-            const auto& current = *cur;
-            size_t hash = ItemSrcAdapter::hash(current);
-            size_t bucketIndex = hash % hashMod;
-            typename HashType::Bucket* bucket = dst->buckets.get_element_ptr_unsafe_can_be_relocated(bucketIndex);
-            uint32_t elementIndex = bucket->endIndex;
-            offset_t currentItemAbsoluteOffset = absoluteOffset + sizeof(typename ItemDstAdapter::ItemType) * offset_t(elementIndex);
-            convertorFunc(this, currentItemAbsoluteOffset, *cur);
+            size_t index = size_t(*cur);
+            ZMEYA_ASSERT(index < numBits);
+            words[index / BitSet::kBitsPerWord] |= uint64_t(1) << (index % BitSet::kBitsPerWord);
+        }
+        copyTo(dst, words.data(), words.size(), numBits);
+    }
+
+    // copyTo bit set from std::vector of set bit indices
+    template <typename T, typename TAllocator> void copyTo(BitSet& dst, const std::vector<T, TAllocator>& indices, size_t numBits)
+    {
+        copyToBitSet(dst, indices.begin(), indices.end(), numBits);
+    }
+
+    // copyTo bit set from std::initializer_list of set bit indices
+    template <typename T> void copyTo(BitSet& dst, std::initializer_list<T> indices, size_t numBits)
+    {
+        copyToBitSet(dst, indices.begin(), indices.end(), numBits);
+    }
+
+    // copyTo jagged array from range of rows (every row must provide begin()/end())
+    template <typename T, typename Iter> void copyToJaggedArray(JaggedArray<T>& _dst, Iter begin, Iter end)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types allowed");
+        BlobPtr<JaggedArray<T>> dst = getBlobPtr(&_dst);
+
+        // 1-st pass compute row offsets
+        std::vector<uint32_t> offsets;
+        offsets.reserve(size_t(std::distance(begin, end)) + 1);
+        size_t numValues = 0;
+        offsets.push_back(0);
+        for (Iter cur = begin; cur != end; ++cur)
+        {
+            numValues += size_t(std::distance(std::begin(*cur), std::end(*cur)));
+            ZMEYA_ASSERT(numValues < size_t(std::numeric_limits<uint32_t>::max()));
+            offsets.push_back(uint32_t(numValues));
+        }
+        copyToArrayFast(dst->offsets, offsets.data(), offsets.size());
+
+        // 2-nd pass copy values
+        if (numValues == 0)
+        {
+            return;
+        }
+        offset_t absoluteOffset = resizeArrayWithoutInitialization(dst->values, numValues);
+        T* values = getDirectMemoryAccessUnsafe<T>(absoluteOffset);
+        for (Iter cur = begin; cur != end; ++cur)
+        {
+            for (const T& v : *cur)
+            {
+                *values = v;
+                values++;
+            }
+        }
+    }
+
+    // copyTo jagged array from vector of vectors
+    template <typename T, typename TAllocator1, typename TAllocator2>
+    void copyTo(JaggedArray<T>& dst, const std::vector<std::vector<T, TAllocator2>, TAllocator1>& src)
+    {
+        copyToJaggedArray(dst, src.begin(), src.end());
+    }
+
+    // compute new node order (new index -> source index)
+    static std::vector<uint32_t> computeGraphNodeOrder(size_t numNodes, const std::vector<uint32_t>& offsets,
+                                                       const std::vector<uint32_t>& targets, GraphNodeOrder order)
+    {
+        // undirected adjacency (bandwidth does not depend on the edge direction)
+        std::vector<uint32_t> undirectedOffsets(numNodes + 1, 0);
+        for (size_t i = 0; i < numNodes; i++)
+        {
+            for (uint32_t e = offsets[i]; e < offsets[i + 1]; e++)
+            {
+                undirectedOffsets[i + 1]++;
+                undirectedOffsets[size_t(targets[e]) + 1]++;
+            }
+        }
+        for (size_t i = 0; i < numNodes; i++)
+        {
+            undirectedOffsets[i + 1] += undirectedOffsets[i];
+        }
+        std::vector<uint32_t> undirectedTargets(undirectedOffsets[numNodes]);
+        std::vector<uint32_t> cursor(undirectedOffsets.begin(), undirectedOffsets.end() - 1);
+        for (size_t i = 0; i < numNodes; i++)
+        {
+            for (uint32_t e = offsets[i]; e < offsets[i + 1]; e++)
+            {
+                uint32_t target = targets[e];
+                undirectedTargets[cursor[i]++] = target;
+                undirectedTargets[cursor[target]++] = uint32_t(i);
+            }
+        }
+
+        auto degree = [&undirectedOffsets](uint32_t index) { return undirectedOffsets[index + 1] - undirectedOffsets[index]; };
+
+        // Cuthill-McKee starts every connected component from the lowest degree node
+        std::vector<uint32_t> roots(numNodes);
+        for (size_t i = 0; i < numNodes; i++)
+        {
+            roots[i] = uint32_t(i);
+        }
+        const bool isCuthillMcKee = (order == GraphNodeOrder::ReverseCuthillMcKee);
+        if (isCuthillMcKee)
+        {
+            std::stable_sort(roots.begin(), roots.end(), [&degree](uint32_t a, uint32_t b) { return degree(a) < degree(b); });
+        }
+
+        std::vector<uint32_t> res;
+        res.reserve(numNodes);
+        std::vector<uint8_t> visited(numNodes, uint8_t(0));
+        std::vector<uint32_t> adj;
+        for (uint32_t root : roots)
+        {
+            if (visited[root] != 0)
+            {
+                continue;
+            }
+            visited[root] = 1;
+            res.push_back(root);
+            for (size_t head = res.size() - 1; head < res.size(); head++)
+            {
+                uint32_t index = res[head];
+                adj.assign(undirectedTargets.begin() + undirectedOffsets[index], undirectedTargets.begin() + undirectedOffsets[index + 1]);
+                if (isCuthillMcKee)
+                {
+                    std::stable_sort(adj.begin(), adj.end(), [&degree](uint32_t a, uint32_t b) { return degree(a) < degree(b); });
+                }
+                for (uint32_t next : adj)
+                {
+                    if (visited[next] == 0)
+                    {
+                        visited[next] = 1;
+                        res.push_back(next);
+                    }
+                }
+            }
+        }
+
+        if (isCuthillMcKee)
+        {
+            std::reverse(res.begin(), res.end());
+        }
+        return res;
+    }
+
+    // copyTo graph from CSR arrays (in source order), edgeData can be nullptr for graphs without edge data
+    template <typename NodeData, typename EdgeData>
+    void copyToGraph(Graph<NodeData, EdgeData>& _dst, const NodeData* nodes, size_t numNodes, const std::vector<uint32_t>& offsets,
+                     const std::vector<uint32_t>& targets, const EdgeData* edgeData, GraphNodeOrder order, std::vector<uint32_t>* remap)
+    {
+        static_assert(std::is_trivially_copyable<NodeData>::value, "Only trivially copyable types allowed");
+        static_assert(std::is_trivially_copyable<EdgeData>::value, "Only trivially copyable types allowed");
+        constexpr bool hasEdgeData = !std::is_empty<EdgeData>::value;
+        ZMEYA_ASSERT(numNodes > 0 && numNodes < size_t(std::numeric_limits<uint32_t>::max()));
+        ZMEYA_ASSERT(offsets.size() == numNodes + 1);
+        ZMEYA_ASSERT(!hasEdgeData || edgeData != nullptr || targets.empty());
+
+        BlobPtr<Graph<NodeData, EdgeData>> dst = getBlobPtr(&_dst);
+        const size_t numEdges = targets.size();
+        if (order == GraphNodeOrder::Original)
+        {
+            copyToArrayFast(dst->nodes, nodes, numNodes);
+            copyToArrayFast(dst->edgeOffsets, offsets.data(), offsets.size());
+            if (numEdges > 0)
+            {
+                copyToArrayFast(dst->edgeTargets, targets.data(), numEdges);
+                if (hasEdgeData)
+                {
+                    copyToArrayFast(dst->edges, edgeData, numEdges);
+                }
+            }
+            if (remap)
+            {
+                remap->resize(numNodes);
+                for (size_t i = 0; i < numNodes; i++)
+                {
+                    (*remap)[i] = uint32_t(i);
+                }
+            }
+            return;
+        }
+
+        std::vector<uint32_t> newToOld = computeGraphNodeOrder(numNodes, offsets, targets, order);
+        ZMEYA_ASSERT(newToOld.size() == numNodes);
+        std::vector<uint32_t> oldToNew(numNodes);
+        for (size_t i = 0; i < numNodes; i++)
+        {
+            oldToNew[newToOld[i]] = uint32_t(i);
+        }
+
+        std::vector<NodeData> newNodes(numNodes);
+        std::vector<uint32_t> newOffsets;
+        std::vector<uint32_t> newTargets;
+        std::vector<EdgeData> newEdges;
+        newOffsets.reserve(numNodes + 1);
+        newTargets.reserve(numEdges);
+        newEdges.reserve(hasEdgeData ? numEdges : 0);
+        newOffsets.push_back(0);
+        for (size_t i = 0; i < numNodes; i++)
+        {
+            uint32_t oldIndex = newToOld[i];
+            newNodes[i] = nodes[oldIndex];
+            for (uint32_t e = offsets[oldIndex]; e < offsets[size_t(oldIndex) + 1]; e++)
+            {
+                newTargets.push_back(oldToNew[targets[e]]);
+                if (hasEdgeData)
+                {
+                    newEdges.push_back(edgeData[e]);
+                }
+            }
+            newOffsets.push_back(uint32_t(newTargets.size()));
+        }
+
+        copyToArrayFast(dst->nodes, newNodes.data(), numNodes);
+        copyToArrayFast(dst->edgeOffsets, newOffsets.data(), newOffsets.size());
+        if (numEdges > 0)
+        {
+            copyToArrayFast(dst->edgeTargets, newTargets.data(), numEdges);
+            if (hasEdgeData)
+            {
+                copyToArrayFast(dst->edges, newEdges.data(), numEdges);
+            }
+        }
+        copyToArrayFast(dst->originalIndices, newToOld.data(), numNodes);
+        if (remap)
+        {
+            *remap = std::move(oldToNew);
+        }
+    }
+
+    // copyTo graph from node data and adjacency list (list of target node indices per node)
+    // remap (optional) receives the new node index for every source node
+    template <typename NodeData, typename TAllocator1, typename TAllocator2, typename TAllocator3>
+    void copyTo(Graph<NodeData>& dst, const std::vector<NodeData, TAllocator1>& nodes,
+                const std::vector<std::vector<uint32_t, TAllocator3>, TAllocator2>& adjacency,
+                GraphNodeOrder order = GraphNodeOrder::Original, std::vector<uint32_t>* remap = nullptr)
+    {
+        ZMEYA_ASSERT(nodes.size() == adjacency.size());
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> targets;
+        offsets.reserve(adjacency.size() + 1);
+        offsets.push_back(0);
+        for (const auto& edges : adjacency)
+        {
+            for (uint32_t target : edges)
+            {
+                ZMEYA_ASSERT(target < nodes.size());
+                targets.push_back(target);
+            }
+            offsets.push_back(uint32_t(targets.size()));
+        }
+        copyToGraph<NodeData, GraphNoEdgeData>(dst, nodes.data(), nodes.size(), offsets, targets, nullptr, order, remap);
+    }
+
+    // copyTo graph from node data and adjacency list (list of target node index + edge data pairs per node)
+    // remap (optional) receives the new node index for every source node
+    template <typename NodeData, typename EdgeData, typename TAllocator1, typename TAllocator2, typename TAllocator3>
+    void copyTo(Graph<NodeData, EdgeData>& dst, const std::vector<NodeData, TAllocator1>& nodes,
+                const std::vector<std::vector<std::pair<uint32_t, EdgeData>, TAllocator3>, TAllocator2>& adjacency,
+                GraphNodeOrder order = GraphNodeOrder::Original, std::vector<uint32_t>* remap = nullptr)
+    {
+        ZMEYA_ASSERT(nodes.size() == adjacency.size());
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> targets;
+        std::vector<EdgeData> edgeData;
+        offsets.reserve(adjacency.size() + 1);
+        offsets.push_back(0);
+        for (const auto& edges : adjacency)
+        {
+            for (const std::pair<uint32_t, EdgeData>& edge : edges)
+            {
+                ZMEYA_ASSERT(edge.first < nodes.size());
+                targets.push_back(edge.first);
+                edgeData.push_back(edge.second);
+            }
+            offsets.push_back(uint32_t(targets.size()));
+        }
+        copyToGraph(dst, nodes.data(), nodes.size(), offsets, targets, edgeData.data(), order, remap);
+    }
+
+    struct BvhBuildContext
+    {
+        std::vector<Aabb> itemBounds;
+        std::vector<float> centroids;
+        std::vector<uint32_t> indices;
+        std::vector<BvhNode> nodes;
+        size_t maxLeafSize;
+    };
+
+    static void buildBvhNode(BvhBuildContext& ctx, size_t first, size_t count, size_t depth)
+    {
+        static const size_t kNumBins = 16;
+        // traversal cost relative to the item test cost
+        static const float kTraversalCost = 1.0f;
+
+        size_t nodeIndex = ctx.nodes.size();
+        ctx.nodes.emplace_back();
+        Aabb bounds = Aabb::invalid();
+        Aabb centroidBounds = Aabb::invalid();
+        for (size_t i = first; i < first + count; i++)
+        {
+            uint32_t item = ctx.indices[i];
+            bounds.grow(ctx.itemBounds[item]);
+            centroidBounds.grow(&ctx.centroids[item * 3]);
+        }
+        ctx.nodes[nodeIndex].bounds = bounds;
+
+        // note: (depth + 3) guarantees that the traversal stacks never exceed BVH<T>::kMaxDepth
+        bool forceLeaf = (count <= 1) || (depth + 3 >= BVH<int>::kMaxDepth);
+
+        // binned SAH
+        int bestAxis = -1;
+        size_t bestSplit = 0;
+        float bestCost = std::numeric_limits<float>::max();
+        for (int axis = 0; axis < 3 && !forceLeaf; axis++)
+        {
+            float cmin = centroidBounds.min[axis];
+            float extent = centroidBounds.max[axis] - cmin;
+            if (!(extent > 0.0f))
+            {
+                continue;
+            }
+            float scale = float(kNumBins) / extent;
+
+            Aabb binBounds[kNumBins];
+            size_t binCount[kNumBins];
+            for (size_t b = 0; b < kNumBins; b++)
+            {
+                binBounds[b] = Aabb::invalid();
+                binCount[b] = 0;
+            }
+            for (size_t i = first; i < first + count; i++)
+            {
+                uint32_t item = ctx.indices[i];
+                size_t b = std::min(kNumBins - 1, size_t((ctx.centroids[item * 3 + axis] - cmin) * scale));
+                binBounds[b].grow(ctx.itemBounds[item]);
+                binCount[b]++;
+            }
+
+            // sweep from the right to collect suffix areas
+            float rightArea[kNumBins];
+            size_t rightCount[kNumBins];
+            Aabb acc = Aabb::invalid();
+            size_t accCount = 0;
+            for (size_t b = kNumBins - 1; b > 0; b--)
+            {
+                acc.grow(binBounds[b]);
+                accCount += binCount[b];
+                rightArea[b] = acc.surfaceArea();
+                rightCount[b] = accCount;
+            }
+
+            acc = Aabb::invalid();
+            accCount = 0;
+            for (size_t b = 0; b < kNumBins - 1; b++)
+            {
+                acc.grow(binBounds[b]);
+                accCount += binCount[b];
+                if (accCount == 0 || rightCount[b + 1] == 0)
+                {
+                    continue;
+                }
+                float cost = acc.surfaceArea() * float(accCount) + rightArea[b + 1] * float(rightCount[b + 1]);
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = b + 1;
+                }
+            }
+        }
+
+        size_t numLeft = 0;
+        if (bestAxis >= 0)
+        {
+            float parentArea = bounds.surfaceArea();
+            float splitCost = kTraversalCost + ((parentArea > 0.0f) ? (bestCost / parentArea) : 0.0f);
+            if (count <= ctx.maxLeafSize && splitCost >= float(count))
+            {
+                forceLeaf = true;
+            }
+            else
+            {
+                float cmin = centroidBounds.min[bestAxis];
+                float scale = float(kNumBins) / (centroidBounds.max[bestAxis] - cmin);
+                auto mid = std::partition(ctx.indices.begin() + first, ctx.indices.begin() + first + count,
+                                          [&](uint32_t item)
+                                          {
+                                              float centroid = ctx.centroids[item * 3 + bestAxis];
+                                              size_t b = std::min(kNumBins - 1, size_t((centroid - cmin) * scale));
+                                              return b < bestSplit;
+                                          });
+                numLeft = size_t(mid - (ctx.indices.begin() + first));
+            }
+        }
+        else if (!forceLeaf)
+        {
+            // all centroids are the same, split in the middle
+            if (count <= ctx.maxLeafSize)
+            {
+                forceLeaf = true;
+            }
+            else
+            {
+                numLeft = count / 2;
+            }
+        }
+
+        if (forceLeaf || numLeft == 0 || numLeft == count)
+        {
+            ctx.nodes[nodeIndex].index = uint32_t(first);
+            ctx.nodes[nodeIndex].count = uint32_t(count);
+            return;
+        }
+
+        // left child is always next to the parent
+        buildBvhNode(ctx, first, numLeft, depth + 1);
+        uint32_t rightIndex = uint32_t(ctx.nodes.size());
+        buildBvhNode(ctx, first + numLeft, count - numLeft, depth + 1);
+        ctx.nodes[nodeIndex].index = rightIndex;
+        ctx.nodes[nodeIndex].count = 0;
+    }
+
+    // copyTo bounding volume hierarchy from items, boundsFunc(item) should return item's Aabb
+    template <typename T, typename BoundsFunc>
+    void copyTo(BVH<T>& _dst, const T* items, size_t numItems, BoundsFunc boundsFunc, size_t maxLeafSize = 4)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types allowed");
+        ZMEYA_ASSERT(numItems > 0 && numItems < size_t(std::numeric_limits<uint32_t>::max()));
+        ZMEYA_ASSERT(maxLeafSize > 0);
+        BlobPtr<BVH<T>> dst = getBlobPtr(&_dst);
+
+        BvhBuildContext ctx;
+        ctx.maxLeafSize = maxLeafSize;
+        ctx.itemBounds.resize(numItems);
+        ctx.centroids.resize(numItems * 3);
+        ctx.indices.resize(numItems);
+        for (size_t i = 0; i < numItems; i++)
+        {
+            const Aabb box = boundsFunc(items[i]);
+            ctx.itemBounds[i] = box;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                ctx.centroids[i * 3 + axis] = (box.min[axis] + box.max[axis]) * 0.5f;
+            }
+            ctx.indices[i] = uint32_t(i);
+        }
+        ctx.nodes.reserve(numItems * 2);
+        buildBvhNode(ctx, 0, numItems, 0);
+
+        copyToArrayFast(dst->nodes, ctx.nodes.data(), ctx.nodes.size());
+        offset_t absoluteOffset = resizeArrayWithoutInitialization(dst->itemBounds, numItems);
+        Aabb* dstBounds = getDirectMemoryAccessUnsafe<Aabb>(absoluteOffset);
+        for (size_t i = 0; i < numItems; i++)
+        {
+            dstBounds[i] = ctx.itemBounds[ctx.indices[i]];
+        }
+        absoluteOffset = resizeArrayWithoutInitialization(dst->items, numItems);
+        T* dstItems = getDirectMemoryAccessUnsafe<T>(absoluteOffset);
+        for (size_t i = 0; i < numItems; i++)
+        {
+            dstItems[i] = items[ctx.indices[i]];
+        }
+    }
+
+    // copyTo bounding volume hierarchy from std::vector
+    template <typename T, typename TAllocator, typename BoundsFunc>
+    void copyTo(BVH<T>& dst, const std::vector<T, TAllocator>& items, BoundsFunc boundsFunc, size_t maxLeafSize = 4)
+    {
+        copyTo(dst, items.data(), items.size(), boundsFunc, maxLeafSize);
+    }
+
+    // copyTo interval index from unsorted intervals
+    template <typename K, typename V> void copyTo(IntervalIndex<K, V>& _dst, const Interval<K, V>* intervals, size_t numIntervals)
+    {
+        static_assert(std::is_trivially_copyable<K>::value, "Only trivially copyable types allowed");
+        static_assert(std::is_trivially_copyable<V>::value, "Only trivially copyable types allowed");
+        typedef typename IntervalIndex<K, V>::Node Node;
+        ZMEYA_ASSERT(numIntervals > 0 && numIntervals < size_t(std::numeric_limits<uint32_t>::max()));
+        BlobPtr<IntervalIndex<K, V>> dst = getBlobPtr(&_dst);
+
+        std::vector<Interval<K, V>> sorted(intervals, intervals + numIntervals);
+        for (size_t i = 0; i < numIntervals; i++)
+        {
+            ZMEYA_ASSERT(!(intervals[i].end < intervals[i].start));
+        }
+        std::stable_sort(sorted.begin(), sorted.end(), [](const Interval<K, V>& a, const Interval<K, V>& b) { return a.start < b.start; });
+
+        // centered interval tree, the center is the median of the endpoints
+        // so every child gets at most half of the parent intervals and the depth is O(log n)
+        std::vector<uint32_t> ids(numIntervals);
+        for (size_t i = 0; i < numIntervals; i++)
+        {
+            ids[i] = uint32_t(i);
+        }
+        std::vector<Node> nodes;
+        std::vector<uint32_t> byStart;
+        std::vector<uint32_t> byEnd;
+        byStart.reserve(numIntervals);
+        byEnd.reserve(numIntervals);
+        std::vector<K> endpoints;
+
+        struct Task
+        {
+            uint32_t node;
+            size_t lo;
+            size_t hi;
+        };
+        std::vector<Task> stack;
+        nodes.emplace_back();
+        stack.push_back(Task{0, 0, numIntervals});
+        while (!stack.empty())
+        {
+            Task task = stack.back();
+            stack.pop_back();
+
+            endpoints.clear();
+            for (size_t i = task.lo; i < task.hi; i++)
+            {
+                endpoints.push_back(sorted[ids[i]].start);
+                endpoints.push_back(sorted[ids[i]].end);
+            }
+            auto median = endpoints.begin() + endpoints.size() / 2;
+            std::nth_element(endpoints.begin(), median, endpoints.end());
+            K center = *median;
+
+            // [lo, midBegin) - left, [midBegin, midEnd) - contain the center, [midEnd, hi) - right
+            // Note: the center is an endpoint of one of the intervals, so the node is never empty
+            auto midBegin = std::partition(ids.begin() + task.lo, ids.begin() + task.hi,
+                                           [&sorted, &center](uint32_t id) { return sorted[id].end < center; });
+            auto midEnd = std::partition(midBegin, ids.begin() + task.hi,
+                                         [&sorted, &center](uint32_t id) { return !(center < sorted[id].start); });
+            ZMEYA_ASSERT(midBegin != midEnd);
+
+            // ids are indices in the start-sorted array
+            std::sort(midBegin, midEnd);
+            Node node;
+            node.center = center;
+            node.first = uint32_t(byStart.size());
+            node.count = uint32_t(midEnd - midBegin);
+            node.left = 0;
+            node.right = 0;
+            byStart.insert(byStart.end(), midBegin, midEnd);
+            size_t byEndFirst = byEnd.size();
+            byEnd.insert(byEnd.end(), midBegin, midEnd);
+            std::stable_sort(byEnd.begin() + byEndFirst, byEnd.end(),
+                             [&sorted](uint32_t a, uint32_t b) { return sorted[b].end < sorted[a].end; });
+
+            size_t midBeginIndex = size_t(midBegin - ids.begin());
+            size_t midEndIndex = size_t(midEnd - ids.begin());
+            if (task.lo < midBeginIndex)
+            {
+                node.left = uint32_t(nodes.size());
+                nodes.emplace_back();
+                stack.push_back(Task{node.left, task.lo, midBeginIndex});
+            }
+            if (midEndIndex < task.hi)
+            {
+                node.right = uint32_t(nodes.size());
+                nodes.emplace_back();
+                stack.push_back(Task{node.right, midEndIndex, task.hi});
+            }
+            nodes[task.node] = node;
+        }
+
+        copyToArrayFast(dst->intervals, sorted.data(), sorted.size());
+        copyToArrayFast(dst->nodes, nodes.data(), nodes.size());
+        copyToArrayFast(dst->byStart, byStart.data(), byStart.size());
+        copyToArrayFast(dst->byEnd, byEnd.data(), byEnd.size());
+    }
+
+    // copyTo interval index from std::vector
+    template <typename K, typename V, typename TAllocator>
+    void copyTo(IntervalIndex<K, V>& dst, const std::vector<Interval<K, V>, TAllocator>& src)
+    {
+        copyTo(dst, src.data(), src.size());
+    }
+
+    // copyTo interval index from std::initializer_list
+    template <typename K, typename V> void copyTo(IntervalIndex<K, V>& dst, std::initializer_list<Interval<K, V>> list)
+    {
+        copyTo(dst, list.begin(), list.size());
+    }
+
+    // copyTo inverted index from term -> ids map (ids can be unsorted and can contain duplicates)
+    template <typename Hasher, typename KeyEq, typename TAllocator1, typename TAllocator2>
+    void copyTo(InvertedIndex& _dst,
+                const std::unordered_map<std::string, std::vector<uint32_t, TAllocator2>, Hasher, KeyEq, TAllocator1>& src)
+    {
+        typedef InvertedIndex::Block Block;
+        typedef InvertedIndex::PostingList PostingList;
+        ZMEYA_ASSERT(src.size() > 0);
+        BlobPtr<InvertedIndex> dst = getBlobPtr(&_dst);
+
+        std::unordered_map<std::string, uint32_t> terms;
+        std::vector<PostingList> lists;
+        std::vector<Block> blocks;
+        std::vector<uint32_t> packed;
+        std::vector<uint32_t> ids;
+        for (const auto& item : src)
+        {
+            ids.assign(item.second.begin(), item.second.end());
+            std::sort(ids.begin(), ids.end());
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+            PostingList list;
+            list.firstBlock = uint32_t(blocks.size());
+            list.numIds = uint32_t(ids.size());
+            for (size_t first = 0; first < ids.size(); first += InvertedIndex::kBlockSize)
+            {
+                size_t count = std::min(InvertedIndex::kBlockSize, ids.size() - first);
+                uint32_t maxDelta = 0;
+                for (size_t i = first + 1; i < first + count; i++)
+                {
+                    maxDelta = std::max(maxDelta, ids[i] - ids[i - 1] - 1);
+                }
+                uint8_t bitWidth = 0;
+                while (bitWidth < 32 && (uint64_t(maxDelta) >> bitWidth) != 0)
+                {
+                    bitWidth++;
+                }
+
+                Block block;
+                block.firstId = ids[first];
+                block.lastId = ids[first + count - 1];
+                block.dataOffset = uint32_t(packed.size());
+                block.count = uint16_t(count);
+                block.bitWidth = bitWidth;
+                block.reserved = 0;
+                blocks.push_back(block);
+
+                // bit-pack (delta - 1) values
+                uint64_t acc = 0;
+                uint32_t accBits = 0;
+                for (size_t i = first + 1; i < first + count && bitWidth > 0; i++)
+                {
+                    acc |= uint64_t(ids[i] - ids[i - 1] - 1) << accBits;
+                    accBits += bitWidth;
+                    if (accBits >= 32)
+                    {
+                        packed.push_back(uint32_t(acc));
+                        acc >>= 32;
+                        accBits -= 32;
+                    }
+                }
+                if (accBits > 0)
+                {
+                    packed.push_back(uint32_t(acc));
+                }
+            }
+            list.numBlocks = uint32_t(blocks.size()) - list.firstBlock;
+            terms[item.first] = uint32_t(lists.size());
+            lists.push_back(list);
+        }
+        // extra word for the decoder look-ahead
+        packed.push_back(0);
+
+        copyToArrayFast(dst->lists, lists.data(), lists.size());
+        if (!blocks.empty())
+        {
+            copyToArrayFast(dst->blocks, blocks.data(), blocks.size());
+        }
+        copyToArrayFast(dst->packed, packed.data(), packed.size());
+        copyTo(dst->terms, terms);
+    }
 
-            // Note: convertorFunc can allocate additional memory -> reallocate storage
-            //    Hence, we need to reacquire the pointer
-            bucket = dst->buckets.get_element_ptr_unsafe_can_be_relocated(bucketIndex);
-#ifdef ZMEYA_VALIDATE_HASH_DUPLICATES
-            const typename ItemDstAdapter::ItemType* lastItem =
-                getDirectMemoryAccessUnsafe<typename ItemDstAdapter::ItemType>(currentItemAbsoluteOffset);
-            size_t newItemHash = ItemDstAdapter::hash(*lastItem);
-            // inconsistent hashing! hash(srcItem) != hash(dstItem)
-            ZMEYA_ASSERT(hash == newItemHash);
-            for (uint32_t testElementIndex = bucket->beginIndex; testElementIndex < bucket->endIndex; testElementIndex++)
+    // copyTo tiled grid from row-major source, padding cells are filled with padValue
+    template <typename T, uint32_t TileSize>
+    void copyTo(Grid2D<T, TileSize>& _dst, const T* rowMajor, size_t width, size_t height, const T& padValue = T())
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types allowed");
+        ZMEYA_ASSERT(width > 0 && height > 0);
+        ZMEYA_ASSERT(width < size_t(std::numeric_limits<uint32_t>::max()) && height < size_t(std::numeric_limits<uint32_t>::max()));
+        BlobPtr<Grid2D<T, TileSize>> dst = getBlobPtr(&_dst);
+
+        size_t tilesX = (width + TileSize - 1) / TileSize;
+        size_t tilesY = (height + TileSize - 1) / TileSize;
+        offset_t absoluteOffset = resizeArray(dst->cells, tilesX * tilesY * Grid2D<T, TileSize>::kCellsPerTile, padValue);
+        T* cells = getDirectMemoryAccessUnsafe<T>(absoluteOffset);
+        for (size_t y = 0; y < height; y++)
+        {
+            for (size_t x = 0; x < width; x++)
             {
-                offset_t testItemAbsoluteOffset = absoluteOffset + sizeof(typename ItemDstAdapter::ItemType) * offset_t(testElementIndex);
-                const typename ItemDstAdapter::ItemType* testItem =
-                    getDirectMemoryAccessUnsafe<typename ItemDstAdapter::ItemType>(testItemAbsoluteOffset);
-                ZMEYA_ASSERT(!ItemDstAdapter::eq(*testItem, *lastItem));
+                cells[Grid2D<T, TileSize>::cellIndex(x, y, tilesX)] = rowMajor[y * width + x];
             }
-#endif
-            bucket->endIndex++;
         }
+        dst->gridWidth = uint32_t(width);
+        dst->gridHeight = uint32_t(height);
+        dst->tilesX = uint32_t(tilesX);
+        dst->tilesY = uint32_t(tilesY);
     }
 
-    // assignTo pointer
-    template <typename T> static void assignTo(Pointer<T>& dst, std::nullptr_t) { dst.relativeOffset = 0; }
+    // copyTo tiled grid from row-major std::vector
+    template <typename T, uint32_t TileSize, typename TAllocator>
+    void copyTo(Grid2D<T, TileSize>& dst, const std::vector<T, TAllocator>& rowMajor, size_t width, size_t height, const T& padValue = T())
+    {
+        ZMEYA_ASSERT(rowMajor.size() == width * height);
+        copyTo(dst, rowMajor.data(), width, height, padValue);
+    }
 
-    // assignTo pointer from absolute offset
-    template <typename T> void assignTo(Pointer<T>& _dst, offset_t targetAbsoluteOffset)
+    // build array in place: fill(T* data, size_t numElements) writes elements directly into the (zero initialized) blob memory
+    // Note: fill must not allocate from this builder, the data pointer can be relocated by any allocation
+    template <typename T, typename FillFunc> offset_t buildArray(Array<T>& dst, size_t numElements, FillFunc&& fill)
     {
-        BlobPtr<Pointer<T>> dst = getBlobPtr(&_dst);
-        roffset_t relativeOffset = toRelativeOffset(diff(targetAbsoluteOffset, dst.getAbsoluteOffset()));
-        ZMEYA_ASSERT(relativeOffset != 0);
-        dst->relativeOffset = relativeOffset;
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types allowed");
+        offset_t absoluteOffset = resizeArrayWithoutInitialization(dst, numElements);
+        if (numElements > 0)
+        {
+            fill(getDirectMemoryAccessUnsafe<T>(absoluteOffset), numElements);
+        }
+        return absoluteOffset;
     }
 
-    // copyTo pointer from BlobPtr
-    template <typename T> void assignTo(Pointer<T>& dst, const BlobPtr<T>& src) { assignTo(dst, src.getAbsoluteOffset()); }
+    // build array in place using multiple threads: fill(T* data, size_t firstIndex, size_t count) is called concurrently
+    // for the disjoint ranges of the array, data points to the element at firstIndex
+    // numThreads = 0 - use all available hardware threads
+    template <typename T, typename FillFunc>
+    offset_t buildArrayParallel(Array<T>& dst, size_t numElements, FillFunc&& fill, size_t numThreads = 0)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types allowed");
+        // do not spawn threads for the small ranges
+        constexpr size_t kMinBytesPerThread = 64 * 1024;
 
-    // copyTo pointer from RawPointer
-    template <typename T> void assignTo(Pointer<T>& dst, const T* _src)
+        offset_t absoluteOffset = resizeArrayWithoutInitialization(dst, numElements);
+        if (numElements == 0)
+        {
+            return absoluteOffset;
+        }
+        T* data = getDirectMemoryAccessUnsafe<T>(absoluteOffset);
+        parallelFor(numElements, numThreads, kMinBytesPerThread / sizeof(T),
+                    [&fill, data](size_t firstIndex, size_t count) { fill(data + firstIndex, firstIndex, count); });
+        return absoluteOffset;
+    }
+
+    // start writing the array of the unknown size at the tail of the blob (see ArrayWriter)
+    template <typename T> ZMEYA_NODISCARD ArrayWriter<T> writeArray(Array<T>& dst);
+
+    // resize pool (using default constructor), objects are accessible using Handle(0) .. Handle(numElements - 1)
+    template <typename T> offset_t resizePool(Pool<T>& pool, size_t numElements) { return resizeArray(pool.items, numElements); }
+
+    // reserve the pool storage for up to 'capacity' objects, the pool stays empty until objects are added (see addToPool)
+    // Note: the unused capacity stays in the blob
+    template <typename T> offset_t reservePool(Pool<T>& _pool, size_t capacity)
     {
-        const BlobPtr<T> src = getBlobPtr(_src);
-        assignTo(dst, src);
+        BlobPtr<Pool<T>> pool = getBlobPtr(&_pool);
+        offset_t absoluteOffset = resizeArray(pool->items, capacity);
+        pool->items.numElements = 0;
+        poolCapacities[pool.getAbsoluteOffset()] = capacity;
+        return absoluteOffset;
     }
 
-    // copyTo pointer from reference
-    template <typename T> void assignTo(Pointer<T>& dst, const T& src) { assignTo(dst, &src); }
+    // add a default constructed object to the reserved pool and return its handle (see getPoolElement)
+    template <size_t Bits = 32, typename T> Handle<T, Bits> addToPool(Pool<T>& pool)
+    {
+        auto it = poolCapacities.find(getBlobPtr(&pool).getAbsoluteOffset());
+        // pool storage must be reserved first (see reservePool) and the capacity must not be exceeded
+        ZMEYA_ASSERT(it != poolCapacities.end() && size_t(pool.items.numElements) < it->second);
+        (void)it;
+        size_t index = size_t(pool.items.numElements);
+        pool.items.numElements++;
+        return Handle<T, Bits>(index);
+    }
 
-    // copyTo array from std::vector
-    template <typename T, typename TAllocator> void copyTo(Array<T>& dst, const std::vector<T, TAllocator>& src)
+    // add a copy of the object to the reserved pool and return its handle
+    template <size_t Bits = 32, typename T> Handle<T, Bits> addToPool(Pool<T>& pool, const T& value)
     {
-        ZMEYA_ASSERT(src.size() > 0);
-        copyToArrayFast(dst, src.data(), src.size());
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types allowed");
+        Handle<T, Bits> handle = addToPool<Bits>(pool);
+        std::memcpy(getArrayElement(pool.items, size_t(handle.index())).get(), &value, sizeof(T));
+        return handle;
     }
 
-    // specialization for vector of vectors
-    template <typename T, typename TAllocator1, typename TAllocator2>
-    void copyTo(Array<Array<T>>& dst, const std::vector<std::vector<T, TAllocator2>, TAllocator1>& src)
+    // get writeable pointer to pool element
+    template <typename T, size_t Bits>
+    ZMEYA_NODISCARD BlobPtr<T> getPoolElement(Pool<T>& pool, const Handle<T, Bits>& handle) const noexcept
     {
-        ZMEYA_ASSERT(src.size() > 0);
-        copyToArray(dst, src.begin(), src.end(), src.size(),
-                    [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const std::vector<T>& src)
-                    {
-                        Array<T>* dst = blobBuilder->getDirectMemoryAccessUnsafe<Array<T>>(dstAbsoluteOffset);
-                        blobBuilder->copyTo(*dst, src);
-                    });
+        ZMEYA_ASSERT(handle.isValid() && handle.index() < pool.size());
+        return getArrayElement(pool.items, size_t(handle.index()));
     }
 
-    // specialization for vector of strings
-    template <typename T, typename TAllocator> void copyTo(Array<String>& dst, const std::vector<T, TAllocator>& src)
+    // copyTo pool from std::vector (handle index = vector index)
+    template <typename T, typename TAllocator> void copyTo(Pool<T>& dst, const std::vector<T, TAllocator>& src)
     {
-        ZMEYA_ASSERT(src.size() > 0);
-        copyToArray(dst, src.begin(), src.end(), src.size(),
-                    [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const T& src)
-                    {
-                        String* dst = blobBuilder->getDirectMemoryAccessUnsafe<String>(dstAbsoluteOffset);
-                        blobBuilder->copyTo(*dst, src);
-                    });
+        if (src.empty())
+        {
+            return;
+        }
+        copyToArrayFast(dst.items, src.data(), src.size());
     }
 
-    // copyTo array from std::initializer_list
-    template <typename T> void copyTo(Array<T>& dst, std::initializer_list<T> list)
+    Span<char> finalize(size_t desiredSizeShouldBeMultipleOf = 4)
     {
-        ZMEYA_ASSERT(list.size() > 0);
-        copyToArrayFast(dst, list.begin(), list.size());
+        ZMEYA_ASSERT(desiredSizeShouldBeMultipleOf > 0);
+
+        if (relocationTableEnabled)
+        {
+            writeRelocationTable(desiredSizeShouldBeMultipleOf);
+        }
+
+        // footer is always the last thing in the blob
+        size_t footerOffset = getBlobFooterOffset(data.size(), desiredSizeShouldBeMultipleOf);
+        allocate(footerOffset - data.size(), 1);
+
+        BlobPtr<char> footerData = allocate(sizeof(BlobFooter), alignof(BlobFooter));
+        ZMEYA_ASSERT(footerData.getAbsoluteOffset() == footerOffset);
+        BlobFooter* footer = getDirectMemoryAccessUnsafe<BlobFooter>(footerData.getAbsoluteOffset());
+        footer->dataSize = uint64_t(footerOffset);
+        footer->version = BlobFooter::kVersion;
+        footer->roffsetBits = uint8_t(ZMEYA_ROFFSET_BITS);
+        footer->flags = relocationTableEnabled ? BlobFooter::kFlagRelocationTable : 0;
+        footer->magic = BlobFooter::kMagic;
+
+        ZMEYA_ASSERT((data.size() % desiredSizeShouldBeMultipleOf) == 0);
+        if (data.getType() == BlobStorageType::Streaming)
+        {
+            // the whole blob is in the file
+            data.finishStreaming();
+            return Span<char>();
+        }
+        if (data.getType() == BlobStorageType::FileMapping)
+        {
+            data.truncateFile();
+        }
+        return Span<char>(data.data(), data.size());
     }
 
-    // copyTo array from std::initializer_list
-    template <typename T> void copyTo(BlobPtr<Array<T>> dst, std::initializer_list<T> list)
+    ZMEYA_NODISCARD static std::shared_ptr<BlobBuilder> create(size_t initialSizeInBytes = 2048)
     {
-        ZMEYA_ASSERT(list.size() > 0);
-        copyToArrayFast(dst, list.begin(), list.size());
+        BlobBuilderAllocator<BlobBuilder, ZMEYA_MAX_ALIGN> allocator;
+        return std::allocate_shared<BlobBuilder>(allocator, initialSizeInBytes, BlobStorageType::Vector, size_t(0), PrivateToken{});
     }
 
-    // specialization for std::initializer_list<std::string>
-    void copyTo(Array<String>& dst, std::initializer_list<const char*> list)
+    // create blob builder with the specified storage type
+    // reserveSizeInBytes - maximum blob size (the size of the reserved virtual address range)
+    // Note: for the VirtualMemory storage reserveSizeInBytes is a hard cap, growing past it (or running out of memory to commit)
+    // calls std::abort() since the blob can't be moved without breaking the stable addresses
+    ZMEYA_NODISCARD static std::shared_ptr<BlobBuilder> create(size_t initialSizeInBytes, BlobStorageType storageType,
+                                                               size_t reserveSizeInBytes = BlobStorage::kDefaultReserveSize)
     {
-        ZMEYA_ASSERT(list.size() > 0);
-        copyToArray(dst, list.begin(), list.end(), list.size(),
-                    [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const char* const& src)
-                    {
-                        String* dst = blobBuilder->getDirectMemoryAccessUnsafe<String>(dstAbsoluteOffset);
-                        blobBuilder->copyTo(*dst, src);
-                    });
+        BlobBuilderAllocator<BlobBuilder, ZMEYA_MAX_ALIGN> allocator;
+        return std::allocate_shared<BlobBuilder>(allocator, initialSizeInBytes, storageType, reserveSizeInBytes, PrivateToken{});
     }
 
-    // specialization for std::initializer_list<std::string>
-    void copyTo(BlobPtr<Array<String>> dst, std::initializer_list<const char*> list)
+    // build the blob directly into the caller-provided buffer (aligned to ZMEYA_MAX_ALIGN), finalize() returns the span of this buffer
+    // if the blob doesn't fit, the builder falls back to the heap memory and reports the overflow (see hasOverflowed)
+    ZMEYA_NODISCARD static std::shared_ptr<BlobBuilder> createInBuffer(void* buffer, size_t bufferSize)
     {
-        ZMEYA_ASSERT(list.size() > 0);
-        copyToArray(dst, list.begin(), list.end(), list.size(),
-                    [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const char* const& src)
-                    {
-                        String* dst = blobBuilder->getDirectMemoryAccessUnsafe<String>(dstAbsoluteOffset);
-                        blobBuilder->copyTo(*dst, src);
-                    });
+        std::shared_ptr<BlobBuilder> blobBuilder = create(0, BlobStorageType::Vector, size_t(0));
+        blobBuilder->data.useExternalBuffer(buffer, bufferSize);
+        return blobBuilder;
     }
 
-    // copyTo array from std::array
-    template <typename T, size_t NumElements> void copyTo(Array<T>& dst, const std::array<T, NumElements>& src)
+    // build the blob directly into the shared file mapping (MAP_SHARED) of the file descriptor (regular file, memfd or POSIX shm)
+    // the file is truncated and then grows using ftruncate, finalize() truncates the file to the blob size
+    // if the file fails to grow, the blob is completed in private memory and hasIoError() reports the failure
+    // Note: returns nullptr if file mapping is not supported or the file descriptor can't be truncated or mapped
+    ZMEYA_NODISCARD static std::shared_ptr<BlobBuilder> createFileMapped(int fd,
+                                                                         size_t reserveSizeInBytes = BlobStorage::kDefaultReserveSize)
     {
-        ZMEYA_ASSERT(src.size() > 0);
-        copyToArrayFast(dst, src.data(), src.size());
+        std::shared_ptr<BlobBuilder> blobBuilder = create(0, BlobStorageType::Vector, size_t(0));
+        if (!blobBuilder->data.useFileMapping(fd, reserveSizeInBytes))
+        {
+            return nullptr;
+        }
+        return blobBuilder;
     }
 
-    // specialization for array of strings
-    template <typename T, size_t NumElements> void copyTo(Array<String>& dst, const std::array<T, NumElements>& src)
+    // streaming builder: the blob is written to the file (starting from the current file position) as it is flushed
+    // only the working set above the last flush watermark is kept in memory, finalize() returns an empty span
+    ZMEYA_NODISCARD static std::shared_ptr<BlobBuilder> createStreaming(FILE* file, size_t initialSizeInBytes = 2048)
     {
-        ZMEYA_ASSERT(src.size() > 0);
-        copyToArray(dst, src.begin(), src.end(), src.size(),
-                    [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const T& src)
-                    {
-                        String* dst = blobBuilder->getDirectMemoryAccessUnsafe<String>(dstAbsoluteOffset);
-                        blobBuilder->copyTo(*dst, src);
-                    });
+        std::shared_ptr<BlobBuilder> blobBuilder = create(initialSizeInBytes, BlobStorageType::Streaming, size_t(0));
+        blobBuilder->data.startStreaming(file);
+        return blobBuilder;
     }
 
-    // copyTo hash set from std::unordered_set
-    template <typename Key, typename Hasher, typename KeyEq, typename TAllocator>
-    void copyTo(HashSet<Key>& dst, const std::unordered_set<Key, Hasher, KeyEq, TAllocator>& src)
+    template <typename T> friend class BlobPtr;
+#ifdef ZMEYA_FAST_BLOBPTR
+    friend class BlobBuilderRef;
+#endif
+};
+
+#ifdef ZMEYA_FAST_BLOBPTR
+inline BlobBuilderRef::BlobBuilderRef(const BlobBuilder* _builder) noexcept
+    : builder(_builder)
+{
+#ifdef ZMEYA_VALIDATE_BLOBPTR
+    serial = builder ? builder->serial : 0;
+#endif
+}
+
+inline const BlobBuilder* BlobBuilderRef::lock() const noexcept
+{
+#ifdef ZMEYA_VALIDATE_BLOBPTR
+    // BlobPtr outlived its BlobBuilder
+    ZMEYA_ASSERT(builder == nullptr || BlobBuilder::isAlive(builder, serial));
+#endif
+    return builder;
+}
+#endif
+
+template <typename T> ZMEYA_NODISCARD T* BlobPtr<T>::get() const
+{
+    auto p = blob.lock();
+    if (!p)
     {
-        typedef HashKeyAdapterGeneric<Key> DstItemAdapter;
-        typedef HashKeyAdapterGeneric<Key> SrcItemAdapter;
+        return nullptr;
+    }
+    // BlobPtr was invalidated by BlobBuilder::reset
+    ZMEYA_ASSERT(p->generation == generation);
+    return reinterpret_cast<T*>(const_cast<char*>(p->get(absoluteOffset)));
+}
 
-        copyToHash<SrcItemAdapter, DstItemAdapter>(
-            dst, src.begin(), src.end(), src.size(),
-            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
-            {
-                typename DstItemAdapter::ItemType* dstElem =
-                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
-                *dstElem = srcElem;
-            });
+template <typename T> Pointer<T>& Pointer<T>::operator=(const BlobPtr<T>& other)
+{
+    Pointer<T>& self = *this;
+    auto p = other.blob.lock();
+    BlobBuilder* blobBuilder = const_cast<BlobBuilder*>(getBlobBuilder(p));
+    if (!blobBuilder)
+    {
+        BlobBuilder::assignTo(self, nullptr);
+    }
+    else
+    {
+        blobBuilder->assignTo(self, other);
     }
+    return self;
+}
 
-    // copyTo hash set from std::unordered_set (specialization for string key)
-    template <typename Hasher, typename KeyEq, typename TAllocator>
-    void copyTo(HashSet<String>& dst, const std::unordered_set<std::string, Hasher, KeyEq, TAllocator>& src)
+template <typename T> Pointer16<T>& Pointer16<T>::operator=(const BlobPtr<T>& other)
+{
+    Pointer16<T>& self = *this;
+    auto p = other.blob.lock();
+    BlobBuilder* blobBuilder = const_cast<BlobBuilder*>(getBlobBuilder(p));
+    if (!blobBuilder)
     {
-        typedef HashKeyAdapterStdString SrcItemAdapter;
-        typedef HashKeyAdapterGeneric<String> DstItemAdapter;
+        BlobBuilder::assignTo(self, nullptr);
+    }
+    else
+    {
+        blobBuilder->assignTo(self, other);
+    }
+    return self;
+}
 
-        copyToHash<SrcItemAdapter, DstItemAdapter>(
-            dst, src.begin(), src.end(), src.size(),
-            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
-            {
-                typename DstItemAdapter::ItemType* dstElem =
-                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
-                blobBuilder->copyTo(*dstElem, srcElem);
-            });
+template <typename... Ts> template <typename U> VariantPointer<Ts...>& VariantPointer<Ts...>::operator=(const BlobPtr<U>& other)
+{
+    VariantPointer<Ts...>& self = *this;
+    auto p = other.blob.lock();
+    BlobBuilder* blobBuilder = const_cast<BlobBuilder*>(getBlobBuilder(p));
+    if (!blobBuilder)
+    {
+        BlobBuilder::assignTo(self, nullptr);
+    }
+    else
+    {
+        blobBuilder->assignTo(self, other);
     }
+    return self;
+}
 
-    // copyTo hash set from std::initializer_list
-    template <typename Key> void copyTo(HashSet<Key>& dst, std::initializer_list<Key> list)
+/*
+    ArrayWriter - appends array elements at the tail of the blob when the number of elements is not known up front
+    no other allocations are allowed until the writer is finished
+*/
+template <typename T> class ArrayWriter
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types allowed");
+
+    BlobBuilder* builder = nullptr;
+    BlobPtr<Array<T>> dst;
+    offset_t firstElementOffset = 0;
+    size_t numElements = 0;
+
+    // blob size must not change between the writes
+    void validateTail() const { ZMEYA_ASSERT(builder->getSize() == firstElementOffset + sizeof(T) * numElements); }
+
+  public:
+    ArrayWriter(BlobBuilder* _builder, const BlobPtr<Array<T>>& _dst)
+        : builder(_builder)
+        , dst(_dst)
     {
-        typedef HashKeyAdapterGeneric<Key> SrcItemAdapter;
-        typedef HashKeyAdapterGeneric<Key> DstItemAdapter;
+        // An array can be assigned/resized only once (non empty array detected)
+        ZMEYA_ASSERT(dst->relativeOffset == 0 && dst->numElements == 0);
+        firstElementOffset = builder->allocateBytes(Span<const char>(), alignof(T)).getAbsoluteOffset();
+    }
 
-        copyToHash<SrcItemAdapter, DstItemAdapter>(
-            dst, list.begin(), list.end(), list.size(),
-            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
-            {
-                typename DstItemAdapter::ItemType* dstElem =
-                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
-                *dstElem = srcElem;
-            });
+    ArrayWriter(const ArrayWriter&) = delete;
+    ArrayWriter& operator=(const ArrayWriter&) = delete;
+
+    ArrayWriter(ArrayWriter&& other) noexcept
+        : builder(other.builder)
+        , dst(std::move(other.dst))
+        , firstElementOffset(other.firstElementOffset)
+        , numElements(other.numElements)
+    {
+        other.builder = nullptr;
     }
 
-    // copyTo hash set from std::initializer_list (specialization for string key)
-    void copyTo(HashSet<String>& dst, std::initializer_list<std::string> list)
+    ~ArrayWriter() { finish(); }
+
+    void push_back(const T& item) { append(&item, 1); }
+
+    void append(const T* items, size_t count)
     {
-        typedef HashKeyAdapterStdString SrcItemAdapter;
-        typedef HashKeyAdapterGeneric<String> DstItemAdapter;
+        ZMEYA_ASSERT(builder != nullptr);
+        validateTail();
+        builder->allocateBytes(items, sizeof(T) * count, alignof(T));
+        numElements += count;
+    }
 
-        copyToHash<SrcItemAdapter, DstItemAdapter>(
-            dst, list.begin(), list.end(), list.size(),
-            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
-            {
-                typename DstItemAdapter::ItemType* dstElem =
-                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
-                blobBuilder->copyTo(*dstElem, srcElem);
-            });
+    ZMEYA_NODISCARD size_t size() const noexcept { return numElements; }
+
+    // finish the array (called automatically by the destructor)
+    void finish()
+    {
+        if (builder == nullptr)
+        {
+            return;
+        }
+        validateTail();
+        ZMEYA_ASSERT(uint64_t(numElements) < uint64_t(std::numeric_limits<asize_t>::max()));
+        dst->numElements = asize_t(numElements);
+        builder->setArrayOffset(dst, firstElementOffset);
+        builder = nullptr;
     }
+};
 
-    // copyTo hash map from std::unordered_map
-    template <typename Key, typename Value, typename Hasher, typename KeyEq, typename TAllocator>
-    void copyTo(HashMap<Key, Value>& dst, const std::unordered_map<Key, Value, Hasher, KeyEq, TAllocator>& src)
+template <typename T> ArrayWriter<T> BlobBuilder::writeArray(Array<T>& dst) { return ArrayWriter<T>(this, getBlobPtr(&dst)); }
+
+/*
+    BlobBuilderPool - thread-safe pool of reusable BlobBuilders
+    new builders are pre-sized using the recent high-water mark of the released builders
+*/
+class BlobBuilderPool
+{
+    mutable std::mutex mutex;
+    std::vector<std::shared_ptr<BlobBuilder>> freeBuilders;
+    size_t maxFreeBuilders;
+    size_t initialSizeInBytes;
+    BlobStorageType storageType;
+    // the recent high-water mark, slowly decays so a single huge blob does not pin the memory forever
+    size_t highWaterMark;
+
+  public:
+    explicit BlobBuilderPool(size_t _maxFreeBuilders = 16, size_t _initialSizeInBytes = 2048,
+                             BlobStorageType _storageType = BlobStorageType::Vector)
+        : maxFreeBuilders(_maxFreeBuilders)
+        , initialSizeInBytes(_initialSizeInBytes)
+        , storageType(_storageType)
+        , highWaterMark(_initialSizeInBytes)
     {
-        typedef HashKeyValueAdapterGeneric<std::pair<const Key, Value>> SrcItemAdapter;
-        typedef HashKeyValueAdapterGeneric<Pair<Key, Value>> DstItemAdapter;
+    }
 
-        copyToHash<SrcItemAdapter, DstItemAdapter>(
-            dst, src.begin(), src.end(), src.size(),
-            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
+    BlobBuilderPool(const BlobBuilderPool&) = delete;
+    BlobBuilderPool& operator=(const BlobBuilderPool&) = delete;
+
+    // get an empty builder (reused if possible)
+    ZMEYA_NODISCARD std::shared_ptr<BlobBuilder> acquire()
+    {
+        std::shared_ptr<BlobBuilder> builder;
+        size_t sizeHint = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            sizeHint = highWaterMark;
+            if (!freeBuilders.empty())
             {
-                typename DstItemAdapter::ItemType* dstElem =
-                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
-                dstElem->first = srcElem.first;
-                dstElem->second = srcElem.second;
-            });
+                builder = std::move(freeBuilders.back());
+                freeBuilders.pop_back();
+            }
+        }
+
+        if (!builder)
+        {
+            return BlobBuilder::create(sizeHint, storageType);
+        }
+        builder->reserve(sizeHint);
+        return builder;
     }
 
-    // copyTo hash set from std::unordered_map (specialization for string key)
-    template <typename Value, typename Hasher, typename KeyEq, typename TAllocator>
-    void copyTo(HashMap<String, Value>& dst, const std::unordered_map<std::string, Value, Hasher, KeyEq, TAllocator>& src)
+    // return the builder to the pool (all the BlobPtrs and finalized data of this builder become invalid)
+    void release(std::shared_ptr<BlobBuilder> builder)
     {
-        typedef HashKeyValueAdapterStdString<Value> SrcItemAdapter;
-        typedef HashKeyValueAdapterGeneric<Pair<String, Value>> DstItemAdapter;
+        if (!builder)
+        {
+            return;
+        }
+        size_t usedSize = builder->getSize();
+        // somebody else still holds this builder, it can't be reused
+        bool isReusable = (builder.use_count() == 1);
+        if (isReusable)
+        {
+            builder->reset();
+        }
 
-        copyToHash<SrcItemAdapter, DstItemAdapter>(
-            dst, src.begin(), src.end(), src.size(),
-            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
-            {
-                typename DstItemAdapter::ItemType* dstElem =
-                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
-                dstElem->second = srcElem.second;
-                blobBuilder->copyTo(dstElem->first, srcElem.first);
-            });
+        std::lock_guard<std::mutex> lock(mutex);
+        highWaterMark = std::max(std::max(usedSize, highWaterMark - highWaterMark / 8), initialSizeInBytes);
+        if (isReusable && freeBuilders.size() < maxFreeBuilders)
+        {
+            freeBuilders.push_back(std::move(builder));
+        }
     }
 
-    // copyTo hash set from std::unordered_map (specialization for string value)
-    template <typename Key, typename Hasher, typename KeyEq, typename TAllocator>
-    void copyTo(HashMap<Key, String>& dst, const std::unordered_map<Key, std::string, Hasher, KeyEq, TAllocator>& src)
+    ZMEYA_NODISCARD size_t getHighWaterMark() const
     {
-        typedef HashKeyValueAdapterGeneric<std::pair<const Key, std::string>> SrcItemAdapter;
-        typedef HashKeyValueAdapterGeneric<Pair<Key, String>> DstItemAdapter;
+        std::lock_guard<std::mutex> lock(mutex);
+        return highWaterMark;
+    }
 
-        copyToHash<SrcItemAdapter, DstItemAdapter>(
-            dst, src.begin(), src.end(), src.size(),
-            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
-            {
-                typename DstItemAdapter::ItemType* dstElem =
-                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
-                dstElem->first = srcElem.first;
-                blobBuilder->copyTo(dstElem->second, srcElem.second);
-            });
+    ZMEYA_NODISCARD size_t getNumFreeBuilders() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return freeBuilders.size();
     }
+};
 
-    // copyTo hash set from std::unordered_map (specialization for string key/value)
-    template <typename Hasher, typename KeyEq, typename TAllocator>
-    void copyTo(HashMap<String, String>& dst, const std::unordered_map<std::string, std::string, Hasher, KeyEq, TAllocator>& src)
+/*
+    BlobLinker - concatenates independently built chunks (one BlobBuilder per thread) into a single blob
+    Zmeya pointers are self-relative, so the chunk internal references remain valid after the copy
+    references between the chunks are recorded using linkPointer/linkArray and fixed up by link()
+*/
+class BlobLinker
+{
+    // every allocation alignment is less than ZMEYA_MAX_ALIGN, so chunks are placed at this alignment
+    static constexpr size_t kChunkAlignment = ZMEYA_MAX_ALIGN / 2;
+
+    typedef void (*FixupFunc)(BlobBuilder* blobBuilder, offset_t srcAbsoluteOffset, offset_t targetAbsoluteOffset, size_t numElements);
+
+    struct Fixup
     {
-        typedef HashKeyValueAdapterStdString<std::string> SrcItemAdapter;
-        typedef HashKeyValueAdapterGeneric<Pair<String, String>> DstItemAdapter;
+        size_t srcChunk;
+        offset_t srcOffset;
+        size_t targetChunk;
+        offset_t targetOffset;
+        size_t numElements;
+        FixupFunc func;
+    };
 
-        copyToHash<SrcItemAdapter, DstItemAdapter>(
-            dst, src.begin(), src.end(), src.size(),
-            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
-            {
-                typename DstItemAdapter::ItemType* dstElem =
-                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
-                blobBuilder->copyTo(dstElem->first, srcElem.first);
+    std::vector<std::shared_ptr<BlobBuilder>> chunks;
+    std::unordered_map<const BlobBuilder*, size_t> chunkIndices;
+    std::mutex mutex;
+    std::vector<Fixup> fixups;
 
-                dstElem = blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
-                blobBuilder->copyTo(dstElem->second, srcElem.second);
-            });
+    template <typename T> ZMEYA_NODISCARD size_t getChunkIndex(const BlobPtr<T>& p) const
+    {
+        auto it = chunkIndices.find(getBlobBuilder(p.blob.lock()));
+        // BlobPtr does not belong to any of the chunks
+        ZMEYA_ASSERT(it != chunkIndices.end());
+        return it->second;
     }
 
-    // copyTo hash map from std::initializer_list
-    template <typename Key, typename Value> void copyTo(HashMap<Key, Value>& dst, std::initializer_list<std::pair<const Key, Value>> list)
+    void addFixup(size_t srcChunk, offset_t srcOffset, size_t targetChunk, offset_t targetOffset, size_t numElements, FixupFunc func)
     {
-        typedef HashKeyValueAdapterGeneric<std::pair<const Key, Value>> SrcItemAdapter;
-        typedef HashKeyValueAdapterGeneric<Pair<Key, Value>> DstItemAdapter;
+        std::lock_guard<std::mutex> lock(mutex);
+        fixups.push_back(Fixup{srcChunk, srcOffset, targetChunk, targetOffset, numElements, func});
+    }
 
-        copyToHash<SrcItemAdapter, DstItemAdapter>(
-            dst, list.begin(), list.end(), list.size(),
-            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
-            {
-                typename DstItemAdapter::ItemType* dstElem =
-                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
-                dstElem->first = srcElem.first;
-                dstElem->second = srcElem.second;
-            });
+    template <typename T>
+    static void fixupPointer(BlobBuilder* blobBuilder, offset_t srcAbsoluteOffset, offset_t targetAbsoluteOffset, size_t)
+    {
+        blobBuilder->assignTo(*blobBuilder->getDirectMemoryAccessUnsafe<Pointer<T>>(srcAbsoluteOffset), targetAbsoluteOffset);
     }
 
-    // copyTo hash map from std::initializer_list (specialization for string key)
-    template <typename Value> void copyTo(HashMap<String, Value>& dst, std::initializer_list<std::pair<const std::string, Value>> list)
+    template <typename T>
+    static void fixupArray(BlobBuilder* blobBuilder, offset_t srcAbsoluteOffset, offset_t targetAbsoluteOffset, size_t numElements)
     {
-        typedef HashKeyValueAdapterStdString<Value> SrcItemAdapter;
-        typedef HashKeyValueAdapterGeneric<Pair<String, Value>> DstItemAdapter;
+        blobBuilder->referTo(*blobBuilder->getDirectMemoryAccessUnsafe<Array<T>>(srcAbsoluteOffset), targetAbsoluteOffset, numElements);
+    }
 
-        copyToHash<SrcItemAdapter, DstItemAdapter>(
-            dst, list.begin(), list.end(), list.size(),
-            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
-            {
-                typename DstItemAdapter::ItemType* dstElem =
-                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
-                dstElem->second = srcElem.second;
-                blobBuilder->copyTo(dstElem->first, srcElem.first);
-            });
+    static void fixupString(BlobBuilder* blobBuilder, offset_t srcAbsoluteOffset, offset_t targetAbsoluteOffset, size_t)
+    {
+        blobBuilder->referTo(*blobBuilder->getDirectMemoryAccessUnsafe<String>(srcAbsoluteOffset), targetAbsoluteOffset);
     }
 
-    // copyTo hash map from std::initializer_list (specialization for string value)
-    template <typename Key> void copyTo(HashMap<Key, String>& dst, std::initializer_list<std::pair<const Key, std::string>> list)
+  public:
+    // add a new chunk (chunks are linked in the order they were added)
+    // Note: all the chunks must be added before the build threads start, chunks must not be finalized
+    size_t addChunk(const std::shared_ptr<BlobBuilder>& chunk)
     {
-        typedef HashKeyValueAdapterGeneric<std::pair<const Key, std::string>> SrcItemAdapter;
-        typedef HashKeyValueAdapterGeneric<Pair<Key, String>> DstItemAdapter;
+        ZMEYA_ASSERT(chunk != nullptr && chunkIndices.find(chunk.get()) == chunkIndices.end());
+        size_t chunkIndex = chunks.size();
+        chunks.push_back(chunk);
+        chunkIndices[chunk.get()] = chunkIndex;
+        return chunkIndex;
+    }
 
-        copyToHash<SrcItemAdapter, DstItemAdapter>(
-            dst, list.begin(), list.end(), list.size(),
-            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
-            {
-                typename DstItemAdapter::ItemType* dstElem =
-                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
-                dstElem->first = srcElem.first;
-                blobBuilder->copyTo(dstElem->second, srcElem.second);
-            });
+    // create a new chunk
+    std::shared_ptr<BlobBuilder> createChunk(size_t initialSizeInBytes = 2048)
+    {
+        std::shared_ptr<BlobBuilder> chunk = BlobBuilder::create(initialSizeInBytes);
+        addChunk(chunk);
+        return chunk;
     }
 
-    // copyTo hash map from std::initializer_list (specialization for string key)
-    void copyTo(HashMap<String, String>& dst, std::initializer_list<std::pair<const std::string, std::string>> list)
+    ZMEYA_NODISCARD size_t getNumChunks() const noexcept { return chunks.size(); }
+
+    // record the reference from the pointer to the target object in another chunk (thread-safe)
+    template <typename T> void linkPointer(const BlobPtr<Pointer<T>>& src, const BlobPtr<T>& target)
     {
-        typedef HashKeyValueAdapterStdString<std::string> SrcItemAdapter;
-        typedef HashKeyValueAdapterGeneric<Pair<String, String>> DstItemAdapter;
+        addFixup(getChunkIndex(src), src.getAbsoluteOffset(), getChunkIndex(target), target.getAbsoluteOffset(), 0, &fixupPointer<T>);
+    }
 
-        copyToHash<SrcItemAdapter, DstItemAdapter>(
-            dst, list.begin(), list.end(), list.size(),
-            [](BlobBuilder* blobBuilder, offset_t dstAbsoluteOffset, const typename SrcItemAdapter::ItemType& srcElem)
-            {
-                typename DstItemAdapter::ItemType* dstElem =
-                    blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
-                blobBuilder->copyTo(dstElem->first, srcElem.first);
+    // record the reference from the array to the elements in another chunk (thread-safe)
+    template <typename T> void linkArray(const BlobPtr<Array<T>>& src, const BlobPtr<T>& firstElement, size_t numElements)
+    {
+        addFixup(getChunkIndex(src), src.getAbsoluteOffset(), getChunkIndex(firstElement), firstElement.getAbsoluteOffset(), numElements,
+                 &fixupArray<T>);
+    }
 
-                dstElem = blobBuilder->getDirectMemoryAccessUnsafe<typename DstItemAdapter::ItemType>(dstAbsoluteOffset);
-                blobBuilder->copyTo(dstElem->second, srcElem.second);
-            });
+    // record the reference from the string to the null-terminated characters in another chunk (thread-safe)
+    void linkString(const BlobPtr<String>& src, const BlobPtr<char>& target)
+    {
+        addFixup(getChunkIndex(src), src.getAbsoluteOffset(), getChunkIndex(target), target.getAbsoluteOffset(), 0, &fixupString);
     }
 
-    // copyTo string from const char* and size
-    void copyTo(BlobPtr<String> dst, const char* src, size_t len)
+    // copy all the chunks into the destination builder and apply the recorded references
+    // chunkAlignment can be increased (e.g. to the page size) to place every chunk at its own pages
+    // returns the absolute offsets of the chunks in the destination blob
+    std::vector<offset_t> link(BlobBuilder* dst, size_t chunkAlignment = kChunkAlignment)
     {
-        ZMEYA_ASSERT(src != nullptr && len > 0);
-        BlobPtr<char> stringData = allocate<char>(src[0]);
-        if (len > 0)
+        ZMEYA_ASSERT(dst != nullptr && chunkIndices.find(dst) == chunkIndices.end());
+        ZMEYA_ASSERT(chunkAlignment >= kChunkAlignment && (chunkAlignment & (chunkAlignment - 1)) == 0);
+
+        std::vector<offset_t> chunkOffsets(chunks.size());
+        size_t cursor = dst->getSize();
+        for (size_t chunkIndex = 0; chunkIndex < chunks.size(); chunkIndex++)
+        {
+            cursor = alignBlobOffset(cursor, chunkAlignment) + chunks[chunkIndex]->getSize();
+        }
+        dst->reserve(cursor);
+
+        for (size_t chunkIndex = 0; chunkIndex < chunks.size(); chunkIndex++)
         {
-            for (size_t i = 1; i < len; i++)
+            const BlobBuilder* chunk = chunks[chunkIndex].get();
+            // streaming chunks are not supported
+            ZMEYA_ASSERT(chunk->data.getFlushedSize() == 0);
+            // allocateBytes alignment is limited by ZMEYA_MAX_ALIGN, so larger alignment is done using zero padding
+            size_t sizeBefore = dst->getSize();
+            size_t numPaddingBytes = alignBlobOffset(sizeBefore, chunkAlignment) - sizeBefore;
+            if (numPaddingBytes > 0)
             {
-                allocate<char>(src[i]);
+                dst->allocate(numPaddingBytes, 1);
+            }
+            Span<const char> bytes(chunk->data.data(), chunk->data.size());
+            offset_t chunkOffset = dst->allocateBytes(bytes, kChunkAlignment).getAbsoluteOffset();
+            chunkOffsets[chunkIndex] = chunkOffset;
+            // chunk internal pointer sites (recorded if the chunk has the relocation table enabled)
+            for (const BlobRelocation& relocation : chunk->relocations)
+            {
+                dst->addRelocation(chunkOffset + relocation.siteOffset, chunkOffset + relocation.targetOffset, relocation.type,
+                                   relocation.numTagBits);
             }
-            allocate<char>('\0');
         }
-        assignTo(dst->data, stringData);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const Fixup& fixup : fixups)
+        {
+            offset_t srcAbsoluteOffset = chunkOffsets[fixup.srcChunk] + fixup.srcOffset;
+            offset_t targetAbsoluteOffset = chunkOffsets[fixup.targetChunk] + fixup.targetOffset;
+            fixup.func(dst, srcAbsoluteOffset, targetAbsoluteOffset, fixup.numElements);
+        }
+        return chunkOffsets;
     }
+};
 
-    void copyTo(String& _dst, const char* src, size_t len)
+/*
+    SegmentedBlobBuilder - named segments (e.g. hot, cold, strings, bulk) that are built independently
+    finalize() concatenates the segments in creation order, every segment starts at the page boundary
+    references between the segments are recorded using assignTo/referTo/copyTo and rebased by finalize()
+    this allows to madvise/mlock the frequently used segment only (see getSegmentBytes)
+*/
+class SegmentedBlobBuilder
+{
+  public:
+    static constexpr size_t kDefaultSegmentAlignment = 4096;
+
+  private:
+    struct Segment
     {
-        BlobPtr<String> dst(getBlobPtr(&_dst));
-        copyTo(dst, src, len);
-    }
+        std::string name;
+        std::shared_ptr<BlobBuilder> builder;
+        offset_t offset;
+        size_t numBytes;
+    };
 
-    // copyTo string from std::string
-    void copyTo(String& dst, const std::string& src) { copyTo(dst, src.c_str(), src.size()); }
+    BlobLinker linker;
+    std::vector<Segment> segments;
+    std::shared_ptr<BlobBuilder> output;
+    // aligned copy of the blob (used if the output storage is not aligned to the segment alignment)
+    std::vector<char> alignedCopy;
+    Span<char> blobBytes;
+    bool finalized = false;
+    bool relocationTableEnabled = false;
 
-    // copyTo string from null teminated c-string
-    void copyTo(String& _dst, const char* src)
+    ZMEYA_NODISCARD const Segment* findSegment(const char* name) const
     {
-        ZMEYA_ASSERT(src != nullptr);
-        size_t len = std::strlen(src);
-        copyTo(_dst, src, len);
+        for (const Segment& segment : segments)
+        {
+            if (segment.name == name)
+            {
+                return &segment;
+            }
+        }
+        return nullptr;
     }
 
-    void referTo(BlobPtr<String> dst, const String& src)
+  public:
+    SegmentedBlobBuilder() = default;
+    SegmentedBlobBuilder(const SegmentedBlobBuilder&) = delete;
+    SegmentedBlobBuilder& operator=(const SegmentedBlobBuilder&) = delete;
+
+    // get the named segment builder, the segment is created on the first use
+    // Note: segments are placed in the order they were created (call it upfront to define the order)
+    //       the first segment should contain the root object
+    BlobBuilder* getSegment(const char* name, size_t initialSizeInBytes = 2048)
     {
-        BlobPtr<char> stringData = getBlobPtr(src.c_str());
-        assignTo(dst->data, stringData);
+        // segments can't be added after finalize
+        ZMEYA_ASSERT(name != nullptr && !finalized);
+        if (const Segment* segment = findSegment(name))
+        {
+            return segment->builder.get();
+        }
+        segments.push_back(Segment{name, linker.createChunk(initialSizeInBytes), 0, 0});
+        segments.back().builder->setRelocationTableEnabled(relocationTableEnabled);
+        return segments.back().builder.get();
     }
 
-    // referTo another String (it is not a copy, the destination string will refer to the same data)
-    void referTo(String& dst, const String& src)
+    ZMEYA_NODISCARD size_t getNumSegments() const noexcept { return segments.size(); }
+
+    // write the relocation table of the whole blob (see BlobBuilder::setRelocationTableEnabled)
+    void setRelocationTableEnabled(bool enabled)
     {
-        BlobPtr<char> stringData = getBlobPtr(src.c_str());
-        assignTo(dst.data, stringData);
+        ZMEYA_ASSERT(!finalized);
+        relocationTableEnabled = enabled;
+        for (Segment& segment : segments)
+        {
+            segment.builder->setRelocationTableEnabled(enabled);
+        }
     }
 
-    // referTo another Array (it is not a copy, the destination string will refer to the same data)
-    template <typename T> void referTo(Array<T>& _dst, const Array<T>& src)
+    // pointer to the object in another segment
+    template <typename T> void assignTo(const BlobPtr<Pointer<T>>& dst, const BlobPtr<T>& target) { linker.linkPointer(dst, target); }
+
+    // array that refers to the elements in another segment
+    template <typename T> void referTo(const BlobPtr<Array<T>>& dst, const BlobPtr<T>& firstElement, size_t numElements)
     {
-        BlobPtr<Array<T>> dst = getBlobPtr(&_dst);
-        BlobPtr<T> arrData = getBlobPtr(src.data());
-        dst->numElements = uint32_t(src.size());
-        setArrayOffset(dst, arrData.getAbsoluteOffset());
+        linker.linkArray(dst, firstElement, numElements);
     }
 
-    // referTo another HashSet (it is not a copy, the destination string will refer to the same data)
-    template <typename Key> void referTo(HashSet<Key>& dst, const HashSet<Key>& src)
+    // string that refers to the null-terminated characters in another segment
+    void referTo(const BlobPtr<String>& dst, const BlobPtr<char>& target) { linker.linkString(dst, target); }
+
+    // copy the string characters into the given segment
+    void copyTo(const BlobPtr<String>& dst, const char* segmentName, const char* src, size_t len)
     {
-        referTo(dst.buckets, src.buckets);
-        referTo(dst.items, src.items);
+        BlobPtr<char> stringData = getSegment(segmentName)->allocateBytes(Span<const char>(src, len), 1, 1);
+        linker.linkString(dst, stringData);
     }
 
-    // referTo another HashMap (it is not a copy, the destination string will refer to the same data)
-    template <typename Key, typename Value> void referTo(HashMap<Key, Value>& dst, const HashMap<Key, Value>& src)
+    void copyTo(const BlobPtr<String>& dst, const char* segmentName, const std::string& src)
     {
-        referTo(dst.buckets, src.buckets);
-        referTo(dst.items, src.items);
+        copyTo(dst, segmentName, src.c_str(), src.size());
     }
 
-    Span<char> finalize(size_t desiredSizeShouldBeMultipleOf = 4)
+    // copy the array elements into the given segment
+    template <typename T> void copyTo(const BlobPtr<Array<T>>& dst, const char* segmentName, const std::vector<T>& src)
     {
-        size_t numPaddingBytes = desiredSizeShouldBeMultipleOf - (data.size() % desiredSizeShouldBeMultipleOf);
-        allocate(numPaddingBytes, 1);
-
-        ZMEYA_ASSERT((data.size() % desiredSizeShouldBeMultipleOf) == 0);
-        return Span<char>(data.data(), data.size());
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types allowed");
+        if (src.empty())
+        {
+            return;
+        }
+        BlobBuilder* segment = getSegment(segmentName);
+        BlobPtr<char> arrData = segment->allocateBytes(src.data(), sizeof(T) * src.size(), alignof(T));
+        linker.linkArray(dst, segment->getBlobPtr(reinterpret_cast<const T*>(arrData.get())), src.size());
     }
 
-    ZMEYA_NODISCARD static std::shared_ptr<BlobBuilder> create(size_t initialSizeInBytes = 2048)
+    // concatenate all the segments into a single blob, every segment is aligned to segmentAlignment in memory
+    // segmentAlignment - power of two (page size or large page size)
+    // Note: the returned memory is owned by the SegmentedBlobBuilder
+    Span<char> finalize(size_t segmentAlignment = kDefaultSegmentAlignment, size_t desiredSizeShouldBeMultipleOf = 4)
     {
-        BlobBuilderAllocator<BlobBuilder, ZMEYA_MAX_ALIGN> allocator;
-        return std::allocate_shared<BlobBuilder>(allocator, initialSizeInBytes, PrivateToken{});
-    }
+        // already finalized
+        ZMEYA_ASSERT(!finalized);
+        ZMEYA_ASSERT(segmentAlignment > 0 && (segmentAlignment & (segmentAlignment - 1)) == 0);
+        size_t totalSize = 0;
+        for (const Segment& segment : segments)
+        {
+            totalSize = alignBlobOffset(totalSize, segmentAlignment) + segment.builder->getSize();
+        }
 
-    template <typename T> friend class BlobPtr;
-};
+        // virtual memory storage is page aligned, so the segments are usually page aligned in memory as well
+        output = BlobBuilder::create(totalSize, BlobStorageType::VirtualMemory);
+        output->setRelocationTableEnabled(relocationTableEnabled);
+        std::vector<offset_t> segmentOffsets = linker.link(output.get(), segmentAlignment);
+        for (size_t segmentIndex = 0; segmentIndex < segments.size(); segmentIndex++)
+        {
+            Segment& segment = segments[segmentIndex];
+            segment.offset = segmentOffsets[segmentIndex];
+            segment.numBytes = segment.builder->getSize();
+            // segment builders are not needed anymore
+            segment.builder.reset();
+        }
+        blobBytes = output->finalize(desiredSizeShouldBeMultipleOf);
+        finalized = true;
 
-template <typename T> ZMEYA_NODISCARD T* BlobPtr<T>::get() const
-{
-    std::shared_ptr<const BlobBuilder> p = blob.lock();
-    if (!p)
-    {
-        return nullptr;
+        // no virtual memory (e.g. ZMEYA_DISABLE_VIRTUAL_MEMORY) or the alignment is larger than the page size
+        // the blob is relocatable, so it is moved to the memory with the requested alignment
+        size_t misalignment = uintptr_t(blobBytes.data) & (segmentAlignment - 1);
+        if (misalignment != 0)
+        {
+            alignedCopy.resize(blobBytes.size + segmentAlignment - 1);
+            char* alignedData = alignedCopy.data() + (alignBlobOffset(uintptr_t(alignedCopy.data()), segmentAlignment) -
+                                                      uintptr_t(alignedCopy.data()));
+            std::memcpy(alignedData, blobBytes.data, blobBytes.size);
+            blobBytes = Span<char>(alignedData, blobBytes.size);
+            output.reset();
+        }
+        return blobBytes;
     }
-    return reinterpret_cast<T*>(const_cast<char*>(p->get(absoluteOffset)));
-}
 
-template <typename T> Pointer<T>& Pointer<T>::operator=(const BlobPtr<T>& other)
-{
-    Pointer<T>& self = *this;
-    std::shared_ptr<const BlobBuilder> p = other.blob.lock();
-    BlobBuilder* blobBuilder = const_cast<BlobBuilder*>(p.get());
-    if (!blobBuilder)
+    // segment byte range in the finalized blob (empty span if there is no such segment)
+    ZMEYA_NODISCARD Span<char> getSegmentBytes(const char* name) const
     {
-        BlobBuilder::assignTo(self, nullptr);
+        const Segment* segment = findSegment(name);
+        if (!finalized || segment == nullptr)
+        {
+            return Span<char>();
+        }
+        return Span<char>(blobBytes.data + segment->offset, segment->numBytes);
     }
-    else
+
+    // segment offset from the beginning of the finalized blob
+    ZMEYA_NODISCARD offset_t getSegmentOffset(const char* name) const
     {
-        blobBuilder->assignTo(self, other);
+        const Segment* segment = findSegment(name);
+        ZMEYA_ASSERT(finalized && segment != nullptr);
+        return segment->offset;
     }
-    return self;
-}
+};
 
 #endif
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
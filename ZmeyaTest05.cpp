@@ -95,7 +95,7 @@ TEST(ZmeyaTestSuite, StringTest)
         validate(root.get());
 
         zm::Span<char> bytes = blobBuilder->finalize();
-        EXPECT_LE(bytes.size, std::size_t(4000500));
+        EXPECT_LE(bytes.size, std::size_t(4000500) * sizeof(zm::roffset_t) / 4);
 
         bytesCopy = utils::copyBytes(bytes);
         std::memset(bytes.data, 0xFF, bytes.size);
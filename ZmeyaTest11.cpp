@@ -102,7 +102,7 @@ TEST(ZmeyaTestSuite, ReferToTest)
         validate(root.get());
 
         zm::Span<char> bytes = blobBuilder->finalize();
-        EXPECT_LE(bytes.size, std::size_t(450000));
+        EXPECT_LE(bytes.size, std::size_t(450000) * sizeof(zm::roffset_t) / 4);
         bytesCopy = utils::copyBytes(bytes);
         std::memset(bytes.data, 0xFF, bytes.size);
     }
@@ -0,0 +1,93 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+
+struct BitSetTestRoot
+{
+    zm::BitSet bits;
+    zm::BitSet sparse;
+    zm::BitSet empty;
+};
+
+static bool isBitSet(size_t i) { return (i % 3) == 0 || (i % 7) == 0; }
+
+static void validate(const BitSetTestRoot* root, size_t numBits)
+{
+    EXPECT_EQ(root->bits.size(), numBits);
+    EXPECT_EQ(root->bits.numWords(), (numBits + 63) / 64);
+
+    size_t expectedRank = 0;
+    for (size_t i = 0; i < numBits; i++)
+    {
+        EXPECT_EQ(root->bits.rank(i), expectedRank);
+        EXPECT_EQ(root->bits.test(i), isBitSet(i));
+        if (isBitSet(i))
+        {
+            EXPECT_EQ(root->bits.select(expectedRank), i);
+            expectedRank++;
+        }
+    }
+    EXPECT_EQ(root->bits.rank(numBits), expectedRank);
+    EXPECT_EQ(root->bits.count(), expectedRank);
+    EXPECT_EQ(root->bits.select(expectedRank), numBits);
+
+    std::vector<size_t> visited;
+    root->bits.forEachSetBit([&visited](size_t index) { visited.push_back(index); });
+    EXPECT_EQ(visited.size(), root->bits.count());
+    for (size_t i = 0; i < visited.size(); i++)
+    {
+        EXPECT_TRUE(isBitSet(visited[i]));
+        EXPECT_EQ(root->bits.select(i), visited[i]);
+    }
+
+    EXPECT_EQ(root->sparse.size(), numBits);
+    EXPECT_EQ(root->sparse.count(), std::size_t(4));
+    EXPECT_TRUE(root->sparse[0]);
+    EXPECT_TRUE(root->sparse[63]);
+    EXPECT_TRUE(root->sparse[64]);
+    EXPECT_TRUE(root->sparse[numBits - 1]);
+    EXPECT_FALSE(root->sparse[1]);
+    EXPECT_EQ(root->sparse.select(2), std::size_t(64));
+    EXPECT_EQ(root->sparse.rank(numBits - 1), std::size_t(3));
+
+    std::vector<uint64_t> res(root->bits.numWords());
+    root->bits.andTo(root->sparse, res.data());
+    EXPECT_EQ(res[0], uint64_t(1) | (uint64_t(1) << 63));
+    root->bits.orTo(root->sparse, res.data());
+    EXPECT_EQ(res[1], root->bits.data()[1] | uint64_t(1));
+    root->bits.andNotTo(root->sparse, res.data());
+    EXPECT_EQ(res[0], root->bits.data()[0] & ~(uint64_t(1) | (uint64_t(1) << 63)));
+
+    EXPECT_TRUE(root->empty.empty());
+    EXPECT_EQ(root->empty.count(), std::size_t(0));
+    EXPECT_EQ(root->empty.select(0), std::size_t(0));
+}
+
+TEST(ZmeyaTestSuite, BitSetTest)
+{
+    const size_t numBits = 5000;
+
+    std::vector<char> bytesCopy;
+    {
+        std::vector<bool> src(numBits);
+        for (size_t i = 0; i < numBits; i++)
+        {
+            src[i] = isBitSet(i);
+        }
+
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+        zm::BlobPtr<BitSetTestRoot> root = blobBuilder->allocate<BitSetTestRoot>();
+        blobBuilder->copyTo(root->bits, src);
+        blobBuilder->copyTo(root->sparse, {0, 63, 64, int(numBits - 1)}, numBits);
+        blobBuilder->copyTo(root->empty, std::vector<bool>());
+
+        validate(root.get(), numBits);
+
+        zm::Span<char> bytes = blobBuilder->finalize();
+        bytesCopy = utils::copyBytes(bytes);
+        std::memset(bytes.data, 0xFF, bytes.size);
+    }
+
+    const BitSetTestRoot* rootCopy = (const BitSetTestRoot*)(bytesCopy.data());
+    validate(rootCopy, numBits);
+}
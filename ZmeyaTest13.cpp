@@ -0,0 +1,81 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+
+struct JaggedArrayTestRoot
+{
+    zm::JaggedArray<uint32_t> meshToMaterials;
+    zm::JaggedArray<float> fromIterators;
+    zm::JaggedArray<int> emptyRows;
+};
+
+static size_t rowLength(size_t row) { return (row * 7) % 5; }
+
+static void validate(const JaggedArrayTestRoot* root, size_t numRows)
+{
+    EXPECT_EQ(root->meshToMaterials.size(), numRows);
+    size_t total = 0;
+    for (size_t i = 0; i < numRows; i++)
+    {
+        zm::Span<const uint32_t> row = root->meshToMaterials.row(i);
+        EXPECT_EQ(row.size, rowLength(i));
+        EXPECT_EQ(root->meshToMaterials.rowSize(i), rowLength(i));
+        for (size_t j = 0; j < row.size; j++)
+        {
+            EXPECT_EQ(row[j], uint32_t(i * 100 + j));
+        }
+        total += row.size;
+    }
+    EXPECT_EQ(root->meshToMaterials.numValues(), total);
+
+    EXPECT_EQ(root->fromIterators.size(), std::size_t(3));
+    float expected = 1.0f;
+    for (size_t i = 0; i < root->fromIterators.size(); i++)
+    {
+        for (float v : root->fromIterators[i])
+        {
+            EXPECT_FLOAT_EQ(v, expected);
+            expected += 1.0f;
+        }
+    }
+    EXPECT_FLOAT_EQ(expected, 7.0f);
+
+    EXPECT_EQ(root->emptyRows.size(), std::size_t(2));
+    EXPECT_EQ(root->emptyRows.numValues(), std::size_t(0));
+    EXPECT_TRUE(root->emptyRows.row(0).empty());
+    EXPECT_TRUE(root->emptyRows.row(1).empty());
+}
+
+TEST(ZmeyaTestSuite, JaggedArrayTest)
+{
+    const size_t numRows = 1000;
+
+    std::vector<char> bytesCopy;
+    {
+        std::vector<std::vector<uint32_t>> meshToMaterials(numRows);
+        for (size_t i = 0; i < numRows; i++)
+        {
+            for (size_t j = 0; j < rowLength(i); j++)
+            {
+                meshToMaterials[i].push_back(uint32_t(i * 100 + j));
+            }
+        }
+
+        std::array<std::array<float, 2>, 3> rows = {{{1.0f, 2.0f}, {3.0f, 4.0f}, {5.0f, 6.0f}}};
+
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+        zm::BlobPtr<JaggedArrayTestRoot> root = blobBuilder->allocate<JaggedArrayTestRoot>();
+        blobBuilder->copyTo(root->meshToMaterials, meshToMaterials);
+        blobBuilder->copyToJaggedArray(root->fromIterators, rows.begin(), rows.end());
+        blobBuilder->copyTo(root->emptyRows, std::vector<std::vector<int>>(2));
+
+        validate(root.get(), numRows);
+
+        zm::Span<char> bytes = blobBuilder->finalize();
+        bytesCopy = utils::copyBytes(bytes);
+        std::memset(bytes.data, 0xFF, bytes.size);
+    }
+
+    const JaggedArrayTestRoot* rootCopy = (const JaggedArrayTestRoot*)(bytesCopy.data());
+    validate(rootCopy, numRows);
+}
@@ -0,0 +1,161 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+
+struct GraphTestNode
+{
+    uint32_t id;
+    float weight;
+};
+
+struct GraphTestEdge
+{
+    float cost;
+};
+
+struct GraphTestRoot
+{
+    zm::Graph<GraphTestNode> tree;
+    zm::Graph<GraphTestNode> treeRcm;
+    zm::Graph<GraphTestNode, GraphTestEdge> dag;
+    zm::Graph<GraphTestNode> cycle;
+};
+
+// binary tree: node i -> 2i+1, 2i+2
+static std::vector<std::vector<uint32_t>> makeTree(size_t numNodes)
+{
+    std::vector<std::vector<uint32_t>> adjacency(numNodes);
+    for (size_t i = 0; i < numNodes; i++)
+    {
+        for (size_t child = i * 2 + 1; child <= i * 2 + 2 && child < numNodes; child++)
+        {
+            adjacency[i].push_back(uint32_t(child));
+        }
+    }
+    return adjacency;
+}
+
+static void validateTree(const zm::Graph<GraphTestNode>& graph, size_t numNodes)
+{
+    EXPECT_EQ(graph.numNodes(), numNodes);
+    EXPECT_EQ(graph.numEdges(), numNodes - 1);
+
+    // every edge must map back to the source tree edge
+    for (size_t i = 0; i < graph.numNodes(); i++)
+    {
+        size_t original = graph.originalIndex(i);
+        EXPECT_EQ(graph.node(i).id, uint32_t(original));
+        for (uint32_t next : graph.neighbors(i))
+        {
+            size_t originalNext = graph.originalIndex(next);
+            EXPECT_TRUE(originalNext == original * 2 + 1 || originalNext == original * 2 + 2);
+        }
+    }
+
+    size_t rootIndex = 0;
+    for (size_t i = 0; i < graph.numNodes(); i++)
+    {
+        if (graph.originalIndex(i) == 0)
+        {
+            rootIndex = i;
+        }
+    }
+
+    size_t numVisited = 0;
+    uint32_t prevId = 0;
+    graph.bfs(rootIndex,
+              [&](size_t, const GraphTestNode& node)
+              {
+                  // the binary tree ids are in breadth-first order
+                  if (numVisited > 0)
+                  {
+                      EXPECT_EQ(node.id, prevId + 1);
+                  }
+                  prevId = node.id;
+                  numVisited++;
+              });
+    EXPECT_EQ(numVisited, numNodes);
+
+    std::vector<uint32_t> dfsIds;
+    graph.dfs(rootIndex, [&](size_t, const GraphTestNode& node) { dfsIds.push_back(node.id); });
+    ASSERT_EQ(dfsIds.size(), numNodes);
+    EXPECT_EQ(dfsIds[0], 0u);
+    EXPECT_EQ(dfsIds[1], 1u);
+    EXPECT_EQ(dfsIds[2], 3u);
+}
+
+static void validate(const GraphTestRoot* root, size_t numNodes)
+{
+    validateTree(root->tree, numNodes);
+    validateTree(root->treeRcm, numNodes);
+    EXPECT_EQ(root->tree.originalIndex(0), std::size_t(0));
+
+    // dag
+    EXPECT_EQ(root->dag.numNodes(), std::size_t(5));
+    EXPECT_EQ(root->dag.degree(0), std::size_t(2));
+    EXPECT_EQ(root->dag.neighbors(0)[1], 2u);
+    EXPECT_FLOAT_EQ(root->dag.edgeData(0)[1].cost, 2.0f);
+    EXPECT_FLOAT_EQ(root->dag.edgeData(3)[0].cost, 5.0f);
+    EXPECT_EQ(root->dag.degree(4), std::size_t(0));
+
+    std::vector<uint32_t> order;
+    EXPECT_TRUE(root->dag.topologicalOrder(order));
+    ASSERT_EQ(order.size(), std::size_t(5));
+    std::vector<size_t> position(5);
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        position[order[i]] = i;
+    }
+    for (size_t i = 0; i < root->dag.numNodes(); i++)
+    {
+        for (uint32_t next : root->dag.neighbors(i))
+        {
+            EXPECT_LT(position[i], position[next]);
+        }
+    }
+
+    EXPECT_FALSE(root->cycle.topologicalOrder(order));
+}
+
+TEST(ZmeyaTestSuite, GraphTest)
+{
+    const size_t numNodes = 10000;
+
+    std::vector<char> bytesCopy;
+    {
+        std::vector<GraphTestNode> nodes(numNodes);
+        for (size_t i = 0; i < numNodes; i++)
+        {
+            nodes[i].id = uint32_t(i);
+            nodes[i].weight = float(i);
+        }
+        std::vector<std::vector<uint32_t>> tree = makeTree(numNodes);
+
+        std::vector<GraphTestNode> dagNodes(nodes.begin(), nodes.begin() + 5);
+        std::vector<std::vector<std::pair<uint32_t, GraphTestEdge>>> dag = {
+            {{1, {1.0f}}, {2, {2.0f}}}, {{3, {3.0f}}}, {{3, {4.0f}}}, {{4, {5.0f}}}, {}};
+
+        std::vector<GraphTestNode> cycleNodes(nodes.begin(), nodes.begin() + 3);
+        std::vector<std::vector<uint32_t>> cycle = {{1}, {2}, {0}};
+
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+        zm::BlobPtr<GraphTestRoot> root = blobBuilder->allocate<GraphTestRoot>();
+        std::vector<uint32_t> remap;
+        blobBuilder->copyTo(root->tree, nodes, tree, zm::GraphNodeOrder::BreadthFirst, &remap);
+        EXPECT_EQ(remap.size(), numNodes);
+        EXPECT_EQ(remap[0], 0u);
+        blobBuilder->copyTo(root->treeRcm, nodes, tree, zm::GraphNodeOrder::ReverseCuthillMcKee, &remap);
+        EXPECT_EQ(root->treeRcm.originalIndex(remap[17]), std::size_t(17));
+        blobBuilder->copyTo(root->dag, dagNodes, dag);
+        blobBuilder->copyTo(root->cycle, cycleNodes, cycle);
+
+        validate(root.get(), numNodes);
+
+        zm::Span<char> bytes = blobBuilder->finalize();
+        bytesCopy = utils::copyBytes(bytes);
+        std::memset(bytes.data, 0xFF, bytes.size);
+    }
+
+    const GraphTestRoot* rootCopy = (const GraphTestRoot*)(bytesCopy.data());
+    validate(rootCopy, numNodes);
+}
@@ -0,0 +1,217 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+
+struct BvhTestObject
+{
+    uint32_t id;
+    float x;
+    float y;
+    float radius;
+};
+
+struct BvhTestRoot
+{
+    zm::BVH<BvhTestObject> objects;
+};
+
+static zm::Aabb objectBounds(const BvhTestObject& obj)
+{
+    return zm::Aabb(obj.x - obj.radius, obj.y - obj.radius, 0.0f, obj.x + obj.radius, obj.y + obj.radius, 0.0f);
+}
+
+static float objectDistanceSq(const BvhTestObject& obj, const float point[3])
+{
+    float dx = obj.x - point[0];
+    float dy = obj.y - point[1];
+    return dx * dx + dy * dy;
+}
+
+// ray vs object box hit distance (infinity if no hit)
+static float objectRayHit(const BvhTestObject& obj, const zm::Ray& ray)
+{
+    zm::Aabb box = objectBounds(obj);
+    float tn = 0.0f;
+    float tf = std::numeric_limits<float>::infinity();
+    for (int axis = 0; axis < 2; axis++)
+    {
+        float t1 = (box.min[axis] - ray.origin[axis]) / ray.dir[axis];
+        float t2 = (box.max[axis] - ray.origin[axis]) / ray.dir[axis];
+        tn = std::max(tn, std::min(t1, t2));
+        tf = std::min(tf, std::max(t1, t2));
+    }
+    return (tn <= tf) ? tn : std::numeric_limits<float>::infinity();
+}
+
+static std::vector<BvhTestObject> makeObjects(size_t count)
+{
+    std::vector<BvhTestObject> objects(count);
+    uint32_t seed = 13061979;
+    auto rnd = [&seed]()
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return float(seed >> 8) / float(1 << 24);
+    };
+    for (size_t i = 0; i < count; i++)
+    {
+        objects[i].id = uint32_t(i);
+        objects[i].x = rnd() * 1000.0f;
+        objects[i].y = rnd() * 1000.0f;
+        objects[i].radius = 0.5f + rnd() * 2.0f;
+    }
+    return objects;
+}
+
+static void validate(const BvhTestRoot* root, const std::vector<BvhTestObject>& objects)
+{
+    const zm::BVH<BvhTestObject>& bvh = root->objects;
+    EXPECT_EQ(bvh.size(), objects.size());
+    EXPECT_GT(bvh.numNodes(), std::size_t(1));
+
+    // all items are present
+    std::vector<uint8_t> seen(objects.size(), 0);
+    for (const BvhTestObject& obj : bvh)
+    {
+        seen[obj.id]++;
+    }
+    for (uint8_t v : seen)
+    {
+        EXPECT_EQ(v, 1);
+    }
+
+    // overlap query vs brute force
+    for (int q = 0; q < 20; q++)
+    {
+        float cx = float(q * 47 % 1000);
+        float cy = float(q * 131 % 1000);
+        zm::Aabb box(cx, cy, -1.0f, cx + 60.0f, cy + 40.0f, 1.0f);
+        std::vector<uint32_t> found;
+        bvh.overlap(box, [&found](const BvhTestObject& obj) { found.push_back(obj.id); });
+        std::vector<uint32_t> expected;
+        for (const BvhTestObject& obj : objects)
+        {
+            if (objectBounds(obj).overlaps(box))
+            {
+                expected.push_back(obj.id);
+            }
+        }
+        std::sort(found.begin(), found.end());
+        EXPECT_EQ(found, expected);
+    }
+
+    // closest hit ray query vs brute force
+    for (int q = 0; q < 20; q++)
+    {
+        zm::Ray ray;
+        ray.origin[0] = -10.0f;
+        ray.origin[1] = float(q * 50);
+        ray.origin[2] = 0.0f;
+        ray.dir[0] = 1.0f;
+        ray.dir[1] = 0.03f * float(q % 5);
+        ray.dir[2] = 0.0f;
+        const float inf = std::numeric_limits<float>::infinity();
+        uint32_t hitId = ~0u;
+        float t = bvh.raycast(ray, inf,
+                              [&](const BvhTestObject& obj, float tMax)
+                              {
+                                  float h = objectRayHit(obj, ray);
+                                  if (h < tMax)
+                                  {
+                                      hitId = obj.id;
+                                  }
+                                  return h;
+                              });
+        float expectedT = inf;
+        for (const BvhTestObject& obj : objects)
+        {
+            expectedT = std::min(expectedT, objectRayHit(obj, ray));
+        }
+        EXPECT_FLOAT_EQ(t, expectedT);
+        if (expectedT < inf)
+        {
+            EXPECT_FLOAT_EQ(objectRayHit(objects[hitId], ray), expectedT);
+        }
+    }
+
+    // k nearest vs brute force
+    std::vector<std::pair<float, const BvhTestObject*>> nearest;
+    for (int q = 0; q < 20; q++)
+    {
+        const float point[3] = {float(q * 37 % 1000), float(q * 71 % 1000), 0.0f};
+        bvh.nearest(point, 8, objectDistanceSq, nearest);
+        std::vector<float> expected;
+        for (const BvhTestObject& obj : objects)
+        {
+            expected.push_back(objectDistanceSq(obj, point));
+        }
+        std::sort(expected.begin(), expected.end());
+        ASSERT_EQ(nearest.size(), std::size_t(8));
+        for (size_t i = 0; i < nearest.size(); i++)
+        {
+            EXPECT_FLOAT_EQ(nearest[i].first, expected[i]);
+            EXPECT_FLOAT_EQ(objectDistanceSq(*nearest[i].second, point), expected[i]);
+        }
+    }
+}
+
+TEST(ZmeyaTestSuite, BvhTest)
+{
+    std::vector<BvhTestObject> objects = makeObjects(5000);
+
+    std::vector<char> bytesCopy;
+    {
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+        zm::BlobPtr<BvhTestRoot> root = blobBuilder->allocate<BvhTestRoot>();
+        blobBuilder->copyTo(root->objects, objects, objectBounds);
+
+        validate(root.get(), objects);
+
+        zm::Span<char> bytes = blobBuilder->finalize();
+        bytesCopy = utils::copyBytes(bytes);
+        std::memset(bytes.data, 0xFF, bytes.size);
+    }
+
+    const BvhTestRoot* rootCopy = (const BvhTestRoot*)(bytesCopy.data());
+    validate(rootCopy, objects);
+}
+
+TEST(ZmeyaTestSuite, BvhAxisAlignedRayTest)
+{
+    // unit tiles on the grid, the tile faces share the grid coordinates
+    const uint32_t kGridSize = 8;
+    std::vector<zm::Aabb> tiles;
+    for (uint32_t y = 0; y < kGridSize; y++)
+    {
+        for (uint32_t x = 0; x < kGridSize; x++)
+        {
+            tiles.emplace_back(float(x), float(y), 0.0f, float(x + 1), float(y + 1), 1.0f);
+        }
+    }
+
+    std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+    zm::BlobPtr<zm::BVH<zm::Aabb>> bvh = blobBuilder->allocate<zm::BVH<zm::Aabb>>();
+    blobBuilder->copyTo(*bvh, tiles, [](const zm::Aabb& tile) { return tile; });
+
+    // downward rays from the tile corners and edges (the origin lies exactly on the tile faces)
+    const float inf = std::numeric_limits<float>::infinity();
+    const float origins[][3] = {{2.0f, 3.0f, 5.0f}, {0.0f, 0.0f, 5.0f}, {8.0f, 8.0f, 5.0f}, {4.5f, 6.0f, 5.0f}, {7.0f, 0.5f, 5.0f}};
+    for (const float* origin : origins)
+    {
+        zm::Ray ray = {{origin[0], origin[1], origin[2]}, {0.0f, 0.0f, -1.0f}};
+        size_t numCandidates = 0;
+        float t = bvh->raycast(ray, inf,
+                               [&](const zm::Aabb& tile, float)
+                               {
+                                   numCandidates++;
+                                   return ray.origin[2] - tile.max[2];
+                               });
+        EXPECT_FLOAT_EQ(t, 4.0f);
+        EXPECT_GT(numCandidates, std::size_t(0));
+    }
+
+    // horizontal ray that slides along the top faces, and a ray that misses the grid
+    zm::Ray alongFace = {{-1.0f, 0.5f, 1.0f}, {1.0f, 0.0f, 0.0f}};
+    EXPECT_FLOAT_EQ(bvh->raycast(alongFace, inf, [](const zm::Aabb& tile, float) { return tile.min[0] + 1.0f; }), 1.0f);
+    zm::Ray above = {{-1.0f, 0.5f, 1.5f}, {1.0f, 0.0f, 0.0f}};
+    EXPECT_EQ(bvh->raycast(above, inf, [](const zm::Aabb&, float) { return 0.0f; }), inf);
+}
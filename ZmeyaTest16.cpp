@@ -0,0 +1,124 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+
+struct IntervalIndexTestRoot
+{
+    zm::IntervalIndex<uint32_t, uint32_t> tracks;
+    zm::IntervalIndex<float, int32_t> small;
+};
+
+static std::vector<zm::Interval<uint32_t, uint32_t>> makeIntervals(size_t count)
+{
+    std::vector<zm::Interval<uint32_t, uint32_t>> intervals(count);
+    uint32_t seed = 1979;
+    for (size_t i = 0; i < count; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        uint32_t start = (seed >> 8) % 100000;
+        seed = seed * 1664525u + 1013904223u;
+        uint32_t length = (i % 10 == 0) ? ((seed >> 8) % 20000) : ((seed >> 8) % 300);
+        intervals[i] = {start, start + length, uint32_t(i)};
+    }
+    return intervals;
+}
+
+static void validate(const IntervalIndexTestRoot* root, const std::vector<zm::Interval<uint32_t, uint32_t>>& intervals)
+{
+    EXPECT_EQ(root->tracks.size(), intervals.size());
+
+    for (uint32_t q = 0; q < 100; q++)
+    {
+        uint32_t first = q * 997 + 13;
+        uint32_t last = first + ((q % 3 == 0) ? 0 : q * 7);
+
+        std::vector<uint32_t> found;
+        root->tracks.overlap(first, last,
+                             [&](uint32_t start, uint32_t end, uint32_t value)
+                             {
+                                 EXPECT_EQ(intervals[value].start, start);
+                                 EXPECT_EQ(intervals[value].end, end);
+                                 found.push_back(value);
+                             });
+        std::vector<uint32_t> expected;
+        for (const zm::Interval<uint32_t, uint32_t>& interval : intervals)
+        {
+            if (interval.start <= last && interval.end >= first)
+            {
+                expected.push_back(interval.value);
+            }
+        }
+        std::sort(found.begin(), found.end());
+        EXPECT_EQ(found, expected);
+    }
+
+    std::vector<int32_t> stabbed;
+    root->small.stab(2.0f, [&](float, float, int32_t value) { stabbed.push_back(value); });
+    std::sort(stabbed.begin(), stabbed.end());
+    EXPECT_EQ(stabbed, std::vector<int32_t>({1, 2, 4}));
+    stabbed.clear();
+    root->small.stab(10.0f, [&](float, float, int32_t value) { stabbed.push_back(value); });
+    EXPECT_TRUE(stabbed.empty());
+}
+
+TEST(ZmeyaTestSuite, IntervalIndexTest)
+{
+    std::vector<zm::Interval<uint32_t, uint32_t>> intervals = makeIntervals(20000);
+
+    std::vector<char> bytesCopy;
+    {
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+        zm::BlobPtr<IntervalIndexTestRoot> root = blobBuilder->allocate<IntervalIndexTestRoot>();
+        blobBuilder->copyTo(root->tracks, intervals);
+        blobBuilder->copyTo(root->small, {zm::Interval<float, int32_t>{1.0f, 3.0f, 1}, zm::Interval<float, int32_t>{2.0f, 2.0f, 2},
+                                          zm::Interval<float, int32_t>{2.5f, 4.0f, 3}, zm::Interval<float, int32_t>{0.0f, 8.0f, 4},
+                                          zm::Interval<float, int32_t>{-5.0f, 1.0f, 5}});
+
+        validate(root.get(), intervals);
+
+        zm::Span<char> bytes = blobBuilder->finalize();
+        bytesCopy = utils::copyBytes(bytes);
+        std::memset(bytes.data, 0xFF, bytes.size);
+    }
+
+    const IntervalIndexTestRoot* rootCopy = (const IntervalIndexTestRoot*)(bytesCopy.data());
+    validate(rootCopy, intervals);
+}
+
+TEST(ZmeyaTestSuite, IntervalIndexDuplicateEndpointsTest)
+{
+    // small domain: many intervals share the endpoints (and the tree centers)
+    std::vector<zm::Interval<uint32_t, uint32_t>> intervals(500);
+    uint32_t seed = 2024;
+    for (size_t i = 0; i < intervals.size(); i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        uint32_t start = (seed >> 8) % 50;
+        seed = seed * 1664525u + 1013904223u;
+        intervals[i] = {start, start + (seed >> 8) % 10, uint32_t(i)};
+    }
+
+    std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+    zm::BlobPtr<zm::IntervalIndex<uint32_t, uint32_t>> index = blobBuilder->allocate<zm::IntervalIndex<uint32_t, uint32_t>>();
+    blobBuilder->copyTo(*index, intervals);
+
+    for (uint32_t first = 0; first < 62; first++)
+    {
+        for (uint32_t last = first; last < first + 5; last++)
+        {
+            std::vector<uint32_t> found;
+            index->overlap(first, last, [&found](uint32_t, uint32_t, uint32_t value) { found.push_back(value); });
+            std::vector<uint32_t> expected;
+            for (const zm::Interval<uint32_t, uint32_t>& interval : intervals)
+            {
+                if (interval.start <= last && interval.end >= first)
+                {
+                    expected.push_back(interval.value);
+                }
+            }
+            // every interval is reported exactly once
+            std::sort(found.begin(), found.end());
+            EXPECT_EQ(found, expected);
+        }
+    }
+}
@@ -0,0 +1,112 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+
+struct InvertedIndexTestRoot
+{
+    zm::InvertedIndex index;
+};
+
+static std::unordered_map<std::string, std::vector<uint32_t>> makePostings()
+{
+    std::unordered_map<std::string, std::vector<uint32_t>> postings;
+    for (uint32_t id = 0; id < 100000; id++)
+    {
+        if (id % 2 == 0)
+        {
+            postings["even"].push_back(id);
+        }
+        if (id % 3 == 0)
+        {
+            postings["three"].push_back(id);
+        }
+        if (id % 1000 == 7)
+        {
+            postings["rare"].push_back(id);
+        }
+    }
+    // unsorted ids with duplicates and large gaps
+    postings["sparse"] = {4000000000u, 12, 70000, 12, 99999, 0};
+    postings["empty"] = {};
+    return postings;
+}
+
+static std::vector<uint32_t> expectedIntersection(std::vector<uint32_t> a, std::vector<uint32_t> b)
+{
+    std::sort(a.begin(), a.end());
+    a.erase(std::unique(a.begin(), a.end()), a.end());
+    std::sort(b.begin(), b.end());
+    b.erase(std::unique(b.begin(), b.end()), b.end());
+    std::vector<uint32_t> res;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(res));
+    return res;
+}
+
+static void validate(const InvertedIndexTestRoot* root, std::unordered_map<std::string, std::vector<uint32_t>>& postings)
+{
+    const zm::InvertedIndex& index = root->index;
+    EXPECT_EQ(index.size(), postings.size());
+    EXPECT_EQ(index.count("even"), std::size_t(50000));
+    EXPECT_EQ(index.count("sparse"), std::size_t(5));
+    EXPECT_EQ(index.count("missing"), std::size_t(0));
+    EXPECT_TRUE(index.find("missing") == nullptr);
+
+    std::vector<uint32_t> ids;
+    index.decode("three", ids);
+    EXPECT_EQ(ids, postings["three"]);
+
+    ids.clear();
+    index.decode("sparse", ids);
+    EXPECT_EQ(ids, std::vector<uint32_t>({0, 12, 70000, 99999, 4000000000u}));
+
+    std::vector<uint32_t> result;
+    index.andQuery({"even", "three"}, result);
+    EXPECT_EQ(result, expectedIntersection(postings["even"], postings["three"]));
+
+    index.andQuery({"three", "rare", "even"}, result);
+    EXPECT_EQ(result, expectedIntersection(expectedIntersection(postings["even"], postings["three"]), postings["rare"]));
+
+    index.andQuery({"sparse", "even"}, result);
+    EXPECT_EQ(result, std::vector<uint32_t>({0, 12, 70000}));
+
+    index.andQuery({"even", "missing"}, result);
+    EXPECT_TRUE(result.empty());
+
+    index.andQuery({"even", "empty"}, result);
+    EXPECT_TRUE(result.empty());
+
+    index.orQuery({"rare", "sparse", "missing"}, result);
+    std::vector<uint32_t> expected = postings["rare"];
+    expected.insert(expected.end(), postings["sparse"].begin(), postings["sparse"].end());
+    std::sort(expected.begin(), expected.end());
+    expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+    EXPECT_EQ(result, expected);
+}
+
+TEST(ZmeyaTestSuite, InvertedIndexTest)
+{
+    std::unordered_map<std::string, std::vector<uint32_t>> postings = makePostings();
+
+    std::vector<char> bytesCopy;
+    {
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+        zm::BlobPtr<InvertedIndexTestRoot> root = blobBuilder->allocate<InvertedIndexTestRoot>();
+        blobBuilder->copyTo(root->index, postings);
+
+        validate(root.get(), postings);
+
+        zm::Span<char> bytes = blobBuilder->finalize();
+        // compressed lists are much smaller than raw 4 bytes per id
+        size_t rawSize = 0;
+        for (const auto& item : postings)
+        {
+            rawSize += item.second.size() * sizeof(uint32_t);
+        }
+        EXPECT_LT(bytes.size, rawSize / 4);
+        bytesCopy = utils::copyBytes(bytes);
+        std::memset(bytes.data, 0xFF, bytes.size);
+    }
+
+    const InvertedIndexTestRoot* rootCopy = (const InvertedIndexTestRoot*)(bytesCopy.data());
+    validate(rootCopy, postings);
+}
@@ -0,0 +1,148 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+
+struct VariantTestGroup;
+struct VariantTestMesh;
+struct VariantTestLight;
+
+typedef zm::VariantPointer<VariantTestGroup, VariantTestMesh, VariantTestLight> VariantTestNodePtr;
+
+struct VariantTestGroup
+{
+    zm::String name;
+    zm::Array<VariantTestNodePtr> children;
+};
+
+struct VariantTestMesh
+{
+    zm::String name;
+    uint32_t numTriangles;
+};
+
+struct VariantTestLight
+{
+    float intensity;
+};
+
+struct VariantTestRoot
+{
+    VariantTestNodePtr root;
+    VariantTestNodePtr empty;
+};
+
+struct VariantTestStats
+{
+    size_t numGroups = 0;
+    size_t numMeshes = 0;
+    size_t numLights = 0;
+    uint32_t numTriangles = 0;
+    float intensity = 0.0f;
+};
+
+static void collect(const VariantTestNodePtr& ptr, VariantTestStats& stats)
+{
+    ptr.visit(
+        [&stats](const auto& node)
+        {
+            typedef std::decay_t<decltype(node)> NodeType;
+            if constexpr (std::is_same<NodeType, VariantTestGroup>::value)
+            {
+                stats.numGroups++;
+                for (const VariantTestNodePtr& child : node.children)
+                {
+                    collect(child, stats);
+                }
+            }
+            else if constexpr (std::is_same<NodeType, VariantTestMesh>::value)
+            {
+                stats.numMeshes++;
+                stats.numTriangles += node.numTriangles;
+            }
+            else
+            {
+                stats.numLights++;
+                stats.intensity += node.intensity;
+            }
+        });
+}
+
+static void validate(const VariantTestRoot* root)
+{
+    EXPECT_TRUE(root->empty == nullptr);
+    EXPECT_FALSE(root->empty.is<VariantTestGroup>());
+    EXPECT_TRUE(root->empty.get<VariantTestGroup>() == nullptr);
+
+    ASSERT_TRUE(root->root != nullptr);
+    EXPECT_TRUE(root->root.is<VariantTestGroup>());
+    EXPECT_FALSE(root->root.is<VariantTestMesh>());
+    EXPECT_EQ(root->root.index(), std::size_t(0));
+    EXPECT_TRUE(root->root.get<VariantTestMesh>() == nullptr);
+    const VariantTestGroup* group = root->root.get<VariantTestGroup>();
+    ASSERT_TRUE(group != nullptr);
+    EXPECT_EQ(group->name, "root");
+    ASSERT_EQ(group->children.size(), std::size_t(3));
+    EXPECT_EQ(group->children[0].index(), std::size_t(1));
+    EXPECT_EQ(group->children[0].get<VariantTestMesh>()->name, "mesh_0");
+    EXPECT_EQ(group->children[1].index(), std::size_t(2));
+    EXPECT_EQ(group->children[2].index(), std::size_t(0));
+
+    VariantTestStats stats;
+    collect(root->root, stats);
+    EXPECT_EQ(stats.numGroups, std::size_t(2));
+    EXPECT_EQ(stats.numMeshes, std::size_t(3));
+    EXPECT_EQ(stats.numLights, std::size_t(2));
+    EXPECT_EQ(stats.numTriangles, 100u + 101u + 102u);
+    EXPECT_FLOAT_EQ(stats.intensity, 3.0f);
+
+    size_t index = root->root.visit([](const auto& node) { return sizeof(node); });
+    EXPECT_EQ(index, sizeof(VariantTestGroup));
+}
+
+TEST(ZmeyaTestSuite, VariantPointerTest)
+{
+    std::vector<char> bytesCopy;
+    {
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+        zm::BlobPtr<VariantTestRoot> root = blobBuilder->allocate<VariantTestRoot>();
+        blobBuilder->assignTo(root->empty, nullptr);
+
+        zm::BlobPtr<VariantTestGroup> group = blobBuilder->allocate<VariantTestGroup>();
+        blobBuilder->copyTo(group->name, "root");
+        root->root = group;
+        blobBuilder->resizeArray(group->children, 3);
+
+        zm::BlobPtr<VariantTestMesh> mesh = blobBuilder->allocate<VariantTestMesh>();
+        blobBuilder->copyTo(mesh->name, "mesh_0");
+        mesh->numTriangles = 100;
+        blobBuilder->assignTo(*blobBuilder->getArrayElement(group->children, 0), mesh);
+
+        zm::BlobPtr<VariantTestLight> light = blobBuilder->allocate<VariantTestLight>();
+        light->intensity = 1.0f;
+        *blobBuilder->getArrayElement(group->children, 1) = light;
+
+        zm::BlobPtr<VariantTestGroup> subGroup = blobBuilder->allocate<VariantTestGroup>();
+        blobBuilder->copyTo(subGroup->name, "sub");
+        *blobBuilder->getArrayElement(group->children, 2) = subGroup;
+        blobBuilder->resizeArray(subGroup->children, 3);
+        for (size_t i = 0; i < 2; i++)
+        {
+            zm::BlobPtr<VariantTestMesh> subMesh = blobBuilder->allocate<VariantTestMesh>();
+            blobBuilder->copyTo(subMesh->name, "mesh_" + std::to_string(i + 1));
+            subMesh->numTriangles = uint32_t(101 + i);
+            blobBuilder->assignTo(subGroup->children.get_raw_ptr_unsafe_can_be_relocated()[i], *subMesh);
+        }
+        zm::BlobPtr<VariantTestLight> subLight = blobBuilder->allocate<VariantTestLight>();
+        subLight->intensity = 2.0f;
+        *blobBuilder->getArrayElement(subGroup->children, 2) = subLight;
+
+        validate(root.get());
+
+        zm::Span<char> bytes = blobBuilder->finalize();
+        bytesCopy = utils::copyBytes(bytes);
+        std::memset(bytes.data, 0xFF, bytes.size);
+    }
+
+    const VariantTestRoot* rootCopy = (const VariantTestRoot*)(bytesCopy.data());
+    validate(rootCopy);
+}
@@ -0,0 +1,117 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+
+struct Grid2DTestRoot
+{
+    zm::Grid2D<uint16_t> heightMap;
+    zm::Grid2D<uint8_t, 4> occupancy;
+};
+
+static uint16_t heightAt(size_t x, size_t y) { return uint16_t(x * 3 + y * 1000); }
+
+static void validate(const Grid2DTestRoot* root, size_t width, size_t height)
+{
+    const zm::Grid2D<uint16_t>& grid = root->heightMap;
+    EXPECT_EQ(grid.width(), width);
+    EXPECT_EQ(grid.height(), height);
+    EXPECT_EQ(grid.numTilesX(), (width + 7) / 8);
+    EXPECT_EQ(grid.numTilesY(), (height + 7) / 8);
+    for (size_t y = 0; y < height; y++)
+    {
+        for (size_t x = 0; x < width; x++)
+        {
+            EXPECT_EQ(grid.at(x, y), heightAt(x, y));
+        }
+    }
+    EXPECT_TRUE(grid.contains(0, 0));
+    EXPECT_FALSE(grid.contains(-1, 0));
+    EXPECT_FALSE(grid.contains(int64_t(width), 0));
+
+    // the cells of one tile are contiguous
+    const uint16_t* tile = grid.tile(1, 2);
+    EXPECT_EQ(tile[0], heightAt(8, 16));
+    EXPECT_EQ(tile[9], heightAt(9, 17));
+
+    size_t numTiles = 0;
+    size_t numPadded = 0;
+    grid.forEachTile(
+        [&](size_t tileX, size_t tileY, const uint16_t* cells)
+        {
+            numTiles++;
+            for (size_t i = 0; i < zm::Grid2D<uint16_t>::kCellsPerTile; i++)
+            {
+                size_t x = tileX * 8 + i % 8;
+                size_t y = tileY * 8 + i / 8;
+                if (x >= width || y >= height)
+                {
+                    EXPECT_EQ(cells[i], 0xFFFF);
+                    numPadded++;
+                }
+            }
+        });
+    EXPECT_EQ(numTiles, grid.numTilesX() * grid.numTilesY());
+    EXPECT_EQ(numPadded, numTiles * 64 - width * height);
+
+    // region query (clipped)
+    size_t numCells = 0;
+    uint64_t sum = 0;
+    grid.forEachInRegion(-3, 5, 13, int64_t(height) + 10,
+                         [&](size_t x, size_t y, uint16_t v)
+                         {
+                             EXPECT_EQ(v, heightAt(x, y));
+                             numCells++;
+                             sum += v;
+                         });
+    EXPECT_EQ(numCells, std::size_t(13) * (height - 5));
+    uint64_t expectedSum = 0;
+    for (size_t y = 5; y < height; y++)
+    {
+        for (size_t x = 0; x < 13; x++)
+        {
+            expectedSum += heightAt(x, y);
+        }
+    }
+    EXPECT_EQ(sum, expectedSum);
+
+    numCells = 0;
+    grid.forEachInRegion(5, 5, 5, 10, [&](size_t, size_t, uint16_t) { numCells++; });
+    EXPECT_EQ(numCells, std::size_t(0));
+
+    EXPECT_EQ(root->occupancy.width(), std::size_t(3));
+    EXPECT_EQ(root->occupancy.height(), std::size_t(2));
+    EXPECT_EQ(root->occupancy(2, 1), 6);
+    EXPECT_EQ(root->occupancy(0, 1), 4);
+}
+
+TEST(ZmeyaTestSuite, Grid2DTest)
+{
+    const size_t width = 37;
+    const size_t height = 29;
+
+    std::vector<char> bytesCopy;
+    {
+        std::vector<uint16_t> heights(width * height);
+        for (size_t y = 0; y < height; y++)
+        {
+            for (size_t x = 0; x < width; x++)
+            {
+                heights[y * width + x] = heightAt(x, y);
+            }
+        }
+
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+        zm::BlobPtr<Grid2DTestRoot> root = blobBuilder->allocate<Grid2DTestRoot>();
+        blobBuilder->copyTo(root->heightMap, heights, width, height, uint16_t(0xFFFF));
+        blobBuilder->copyTo(root->occupancy, std::vector<uint8_t>({1, 2, 3, 4, 5, 6}), 3, 2);
+
+        validate(root.get(), width, height);
+
+        zm::Span<char> bytes = blobBuilder->finalize();
+        bytesCopy = utils::copyBytes(bytes);
+        std::memset(bytes.data, 0xFF, bytes.size);
+    }
+
+    const Grid2DTestRoot* rootCopy = (const Grid2DTestRoot*)(bytesCopy.data());
+    validate(rootCopy, width, height);
+}
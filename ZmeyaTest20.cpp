@@ -0,0 +1,148 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+
+struct PoolTestEntity
+{
+    zm::String name;
+    zm::Handle<PoolTestEntity, 16> parent;
+    uint16_t level;
+};
+
+struct PoolTestTransform
+{
+    float x;
+    float y;
+    zm::Handle<PoolTestEntity, 24> owner;
+};
+
+struct PoolTestRoot
+{
+    zm::Pool<PoolTestEntity> entities;
+    zm::Pool<PoolTestTransform> transforms;
+    zm::Array<zm::Handle<PoolTestTransform>> selection;
+    zm::Pool<PoolTestTransform> empty;
+};
+
+static void validate(const PoolTestRoot* root, size_t numEntities)
+{
+    EXPECT_EQ(sizeof(zm::Handle<PoolTestEntity, 16>), std::size_t(2));
+    EXPECT_EQ(sizeof(zm::Handle<PoolTestEntity, 24>), std::size_t(3));
+    EXPECT_EQ(sizeof(zm::Handle<PoolTestEntity>), std::size_t(4));
+
+    EXPECT_EQ(root->entities.size(), numEntities);
+    size_t index = 0;
+    for (const PoolTestEntity& entity : root->entities)
+    {
+        EXPECT_EQ(entity.name, "entity_" + std::to_string(index));
+        if (index == 0)
+        {
+            EXPECT_FALSE(entity.parent.isValid());
+            EXPECT_TRUE(root->entities.get(entity.parent) == nullptr);
+        }
+        else
+        {
+            ASSERT_TRUE(entity.parent.isValid());
+            EXPECT_EQ(entity.parent.index(), uint32_t((index - 1) / 2));
+            const PoolTestEntity& parent = root->entities[entity.parent];
+            EXPECT_EQ(parent.level + 1, entity.level);
+        }
+        EXPECT_EQ(root->entities.handleOf<16>(entity).index(), uint32_t(index));
+        index++;
+    }
+
+    EXPECT_EQ(root->transforms.size(), numEntities);
+    for (const PoolTestTransform& transform : root->transforms)
+    {
+        const PoolTestEntity* owner = root->entities.get(transform.owner);
+        ASSERT_TRUE(owner != nullptr);
+        EXPECT_FLOAT_EQ(transform.x, float(owner->level));
+    }
+
+    // handles to the same object are identical (can be compared and sorted)
+    ASSERT_EQ(root->selection.size(), std::size_t(4));
+    EXPECT_TRUE(root->selection[0] == root->selection[3]);
+    EXPECT_TRUE(root->selection[1] < root->selection[2]);
+    EXPECT_FLOAT_EQ(root->transforms[root->selection[2]].y, 7.0f);
+
+    EXPECT_TRUE(root->empty.empty());
+}
+
+TEST(ZmeyaTestSuite, PoolTest)
+{
+    const size_t numEntities = 1000;
+
+    std::vector<char> bytesCopy;
+    {
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+        zm::BlobPtr<PoolTestRoot> root = blobBuilder->allocate<PoolTestRoot>();
+
+        // objects are added one by one, other allocations (entity names) can be interleaved
+        blobBuilder->reservePool(root->entities, numEntities);
+        for (size_t i = 0; i < numEntities; i++)
+        {
+            zm::Handle<PoolTestEntity, 16> handle = blobBuilder->addToPool<16>(root->entities);
+            EXPECT_EQ(handle.index(), uint32_t(i));
+            EXPECT_EQ(root->entities.size(), i + 1);
+            zm::BlobPtr<PoolTestEntity> entity = blobBuilder->getPoolElement(root->entities, handle);
+            blobBuilder->copyTo(entity->name, "entity_" + std::to_string(i));
+            // the root entity keeps the zero-initialized (null) parent handle
+            if (i > 0)
+            {
+                entity->parent = zm::Handle<PoolTestEntity, 16>((i - 1) / 2);
+                entity->level = uint16_t(root->entities[entity->parent].level + 1);
+            }
+        }
+
+        std::vector<PoolTestTransform> transforms(numEntities);
+        for (size_t i = 0; i < numEntities; i++)
+        {
+            // reverse order
+            size_t entityIndex = numEntities - 1 - i;
+            transforms[i].owner = zm::Handle<PoolTestEntity, 24>(entityIndex);
+            transforms[i].x = float(root->entities[transforms[i].owner].level);
+            transforms[i].y = float(i);
+        }
+        blobBuilder->copyTo(root->transforms, transforms);
+        blobBuilder->copyTo(root->empty, std::vector<PoolTestTransform>());
+
+        blobBuilder->copyTo(root->selection, {zm::Handle<PoolTestTransform>(3), zm::Handle<PoolTestTransform>(5),
+                                              zm::Handle<PoolTestTransform>(7), zm::Handle<PoolTestTransform>(3)});
+
+        validate(root.get(), numEntities);
+
+        zm::Span<char> bytes = blobBuilder->finalize();
+        bytesCopy = utils::copyBytes(bytes);
+        std::memset(bytes.data, 0xFF, bytes.size);
+    }
+
+    const PoolTestRoot* rootCopy = (const PoolTestRoot*)(bytesCopy.data());
+    validate(rootCopy, numEntities);
+}
+
+TEST(ZmeyaTestSuite, PoolHandleTest)
+{
+    // zero-initialized handle is null (the same as Pointer<T>)
+    typedef zm::Handle<PoolTestEntity, 24> EntityHandle;
+    EntityHandle zeroHandle;
+    std::memset(&zeroHandle, 0, sizeof(zeroHandle));
+    EXPECT_FALSE(zeroHandle.isValid());
+    EXPECT_TRUE(zeroHandle == EntityHandle::invalid());
+    EXPECT_TRUE(EntityHandle(0).isValid());
+    EXPECT_TRUE(zeroHandle < EntityHandle(0));
+    typedef zm::Handle<PoolTestEntity, 16> SmallEntityHandle;
+    EXPECT_EQ(SmallEntityHandle(SmallEntityHandle::kMaxIndex).index(), uint32_t(65534));
+
+    // trivially copyable objects can be added by value
+    std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+    zm::BlobPtr<zm::Pool<PoolTestTransform>> pool = blobBuilder->allocate<zm::Pool<PoolTestTransform>>();
+    blobBuilder->reservePool(*pool, 8);
+    EXPECT_TRUE(pool->empty());
+    zm::Handle<PoolTestTransform> first = blobBuilder->addToPool(*pool, PoolTestTransform{1.0f, 2.0f, EntityHandle::invalid()});
+    zm::Handle<PoolTestTransform> second = blobBuilder->addToPool(*pool, PoolTestTransform{3.0f, 4.0f, EntityHandle(5)});
+    ASSERT_EQ(pool->size(), std::size_t(2));
+    EXPECT_FLOAT_EQ((*pool)[first].y, 2.0f);
+    EXPECT_FALSE((*pool)[first].owner.isValid());
+    EXPECT_FLOAT_EQ((*pool)[second].x, 3.0f);
+    EXPECT_EQ((*pool)[second].owner.index(), uint32_t(5));
+}
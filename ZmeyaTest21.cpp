@@ -0,0 +1,79 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+
+struct FooterTestPayload
+{
+    uint64_t value;
+};
+
+struct FooterTestRoot
+{
+    zm::Pointer<FooterTestPayload> payload;
+    zm::String name;
+    zm::Array<uint32_t> values;
+    zm::HashMap<zm::String, uint32_t> lookup;
+};
+
+static void validate(const FooterTestRoot* root)
+{
+    EXPECT_EQ(root->payload->value, 0x1122334455667788ull);
+    EXPECT_EQ(root->name, "footer test");
+    ASSERT_EQ(root->values.size(), std::size_t(100));
+    for (size_t i = 0; i < root->values.size(); i++)
+    {
+        EXPECT_EQ(root->values[i], uint32_t(i * 3));
+    }
+    EXPECT_EQ(root->lookup.find("a", 0u), uint32_t(1));
+    EXPECT_EQ(root->lookup.find("b", 0u), uint32_t(2));
+}
+
+TEST(ZmeyaTestSuite, BlobFooterTest)
+{
+    EXPECT_EQ(sizeof(zm::roffset_t) * 8, std::size_t(ZMEYA_ROFFSET_BITS));
+    EXPECT_EQ(sizeof(zm::Pointer<FooterTestPayload>), sizeof(zm::roffset_t));
+    EXPECT_EQ(sizeof(zm::Array<uint32_t>), sizeof(zm::roffset_t) + sizeof(zm::asize_t));
+
+    for (size_t multipleOf : {size_t(1), size_t(4), size_t(12), size_t(32), size_t(4096)})
+    {
+        std::vector<char> bytesCopy;
+        {
+            std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+            zm::BlobPtr<FooterTestRoot> root = blobBuilder->allocate<FooterTestRoot>();
+            zm::BlobPtr<FooterTestPayload> payload = blobBuilder->allocate<FooterTestPayload>();
+            payload->value = 0x1122334455667788ull;
+            root->payload = payload;
+            blobBuilder->copyTo(root->name, "footer test");
+            std::vector<uint32_t> values;
+            for (uint32_t i = 0; i < 100; i++)
+            {
+                values.push_back(i * 3);
+            }
+            blobBuilder->copyTo(root->values, values);
+            blobBuilder->copyTo(root->lookup, {{"a", 1}, {"b", 2}});
+
+            zm::Span<char> bytes = blobBuilder->finalize(multipleOf);
+            EXPECT_EQ(bytes.size % multipleOf, std::size_t(0));
+
+            const zm::BlobFooter* footer = zm::getBlobFooter(bytes.data, bytes.size);
+            ASSERT_TRUE(footer != nullptr);
+            EXPECT_EQ(footer->roffsetBits, uint8_t(ZMEYA_ROFFSET_BITS));
+            EXPECT_EQ(footer->version, zm::BlobFooter::kVersion);
+            EXPECT_EQ(footer->dataSize + sizeof(zm::BlobFooter), uint64_t(bytes.size));
+            EXPECT_TRUE(zm::isBlobCompatible(bytes.data, bytes.size));
+
+            bytesCopy = utils::copyBytes(bytes);
+            std::memset(bytes.data, 0xFF, bytes.size);
+        }
+
+        const FooterTestRoot* rootCopy = (const FooterTestRoot*)(bytesCopy.data());
+        validate(rootCopy);
+        EXPECT_TRUE(zm::isBlobCompatible(bytesCopy.data(), bytesCopy.size()));
+
+        // truncated or corrupted blobs has no footer
+        EXPECT_TRUE(zm::getBlobFooter(bytesCopy.data(), bytesCopy.size() - 8) == nullptr);
+        bytesCopy[bytesCopy.size() - 1] ^= 0x55;
+        EXPECT_TRUE(zm::getBlobFooter(bytesCopy.data(), bytesCopy.size()) == nullptr);
+        EXPECT_FALSE(zm::isBlobCompatible(bytesCopy.data(), bytesCopy.size()));
+    }
+}
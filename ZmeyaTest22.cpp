@@ -0,0 +1,99 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+
+struct CompactTestNode
+{
+    uint16_t id;
+    uint16_t value;
+    zm::Pointer16<CompactTestNode> parent;
+    zm::SmallArray<zm::Pointer16<CompactTestNode>> children;
+};
+
+struct CompactTestRoot
+{
+    zm::Pointer16<CompactTestNode> root;
+    zm::SmallArray<uint16_t> ids;
+    zm::SmallArray<float> empty;
+};
+
+static void validateNode(const CompactTestNode* node, const CompactTestNode* parent, uint16_t id, uint32_t depth)
+{
+    EXPECT_EQ(node->id, id);
+    EXPECT_EQ(node->value, uint16_t(id * 7));
+    EXPECT_EQ(node->parent.get(), parent);
+    if (depth == 0)
+    {
+        EXPECT_TRUE(node->children.empty());
+        return;
+    }
+
+    ASSERT_EQ(node->children.size(), std::size_t(3));
+    for (size_t i = 0; i < node->children.size(); i++)
+    {
+        validateNode(node->children[i].get(), node, uint16_t(id * 3 + 1 + i), depth - 1);
+    }
+}
+
+static void validate(const CompactTestRoot* root)
+{
+    EXPECT_EQ(sizeof(zm::Pointer16<CompactTestNode>), std::size_t(2));
+    EXPECT_EQ(sizeof(zm::SmallArray<uint16_t>), std::size_t(4));
+    EXPECT_EQ(sizeof(CompactTestNode), std::size_t(10));
+
+    ASSERT_TRUE(root->root != nullptr);
+    validateNode(root->root.get(), nullptr, 0, 4);
+
+    ASSERT_EQ(root->ids.size(), std::size_t(5));
+    uint16_t expected = 10;
+    for (uint16_t id : root->ids)
+    {
+        EXPECT_EQ(id, expected);
+        expected += 10;
+    }
+    EXPECT_TRUE(root->empty.empty());
+    EXPECT_TRUE(root->empty.begin() == root->empty.end());
+}
+
+static zm::BlobPtr<CompactTestNode> createNode(zm::BlobBuilder* blobBuilder, zm::BlobPtr<CompactTestNode> parent, uint16_t id,
+                                               uint32_t depth)
+{
+    zm::BlobPtr<CompactTestNode> node = blobBuilder->allocate<CompactTestNode>();
+    node->id = id;
+    node->value = uint16_t(id * 7);
+    node->parent = parent;
+    if (depth > 0)
+    {
+        blobBuilder->resizeArray(node->children, 3);
+        for (size_t i = 0; i < 3; i++)
+        {
+            zm::BlobPtr<CompactTestNode> child = createNode(blobBuilder, node, uint16_t(id * 3 + 1 + i), depth - 1);
+            zm::BlobPtr<zm::Pointer16<CompactTestNode>> ch = blobBuilder->getArrayElement(node->children, i);
+            *ch = child;
+        }
+    }
+    return node;
+}
+
+TEST(ZmeyaTestSuite, CompactPointerTest)
+{
+    std::vector<char> bytesCopy;
+    {
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+        zm::BlobPtr<CompactTestRoot> root = blobBuilder->allocate<CompactTestRoot>();
+        root->root = createNode(blobBuilder.get(), zm::BlobPtr<CompactTestNode>(), 0, 4);
+        blobBuilder->copyTo(root->ids, {uint16_t(10), uint16_t(20), uint16_t(30), uint16_t(40), uint16_t(50)});
+        blobBuilder->resizeArray(root->empty, 0);
+
+        validate(root.get());
+
+        zm::Span<char> bytes = blobBuilder->finalize();
+        // whole tree must fit into the 16-bit offsets range
+        EXPECT_LT(bytes.size, std::size_t(32 * 1024));
+        bytesCopy = utils::copyBytes(bytes);
+        std::memset(bytes.data, 0xFF, bytes.size);
+    }
+
+    const CompactTestRoot* rootCopy = (const CompactTestRoot*)(bytesCopy.data());
+    validate(rootCopy);
+}
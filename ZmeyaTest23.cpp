@@ -0,0 +1,170 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <random>
+
+struct PrefetchTestNode
+{
+    uint32_t payload;
+    uint32_t padding[15];
+    zm::Pointer<PrefetchTestNode> next;
+};
+
+struct PrefetchTestRoot
+{
+    zm::Array<zm::Pointer<PrefetchTestNode>> nodes;
+    zm::Array<zm::Pointer<PrefetchTestNode>> empty;
+    zm::Pointer<PrefetchTestNode> head;
+};
+
+// nodes are allocated in the shuffled order, so the array/list order does not match the memory order
+static std::vector<char> buildBlob(size_t numNodes, uint32_t seed)
+{
+    std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(numNodes * sizeof(PrefetchTestNode) * 2);
+    zm::BlobPtr<PrefetchTestRoot> root = blobBuilder->allocate<PrefetchTestRoot>();
+    blobBuilder->resizeArray(root->nodes, numNodes);
+
+    std::vector<size_t> order(numNodes);
+    for (size_t i = 0; i < numNodes; i++)
+    {
+        order[i] = i;
+    }
+    std::mt19937 gen(seed);
+    std::shuffle(order.begin(), order.end(), gen);
+
+    std::vector<zm::BlobPtr<PrefetchTestNode>> nodes(numNodes);
+    for (size_t i = 0; i < numNodes; i++)
+    {
+        size_t index = order[i];
+        nodes[index] = blobBuilder->allocate<PrefetchTestNode>();
+        nodes[index]->payload = uint32_t(index);
+    }
+
+    for (size_t i = 0; i < numNodes; i++)
+    {
+        // every 7th element is null
+        if ((i % 7) != 3)
+        {
+            *blobBuilder->getArrayElement(root->nodes, i) = nodes[i];
+        }
+        if (i + 1 < numNodes)
+        {
+            nodes[i]->next = nodes[i + 1];
+        }
+    }
+    root->head = nodes[0];
+
+    zm::Span<char> bytes = blobBuilder->finalize();
+    return utils::copyBytes(bytes);
+}
+
+static uint64_t sumArray(const PrefetchTestRoot* root, size_t distance)
+{
+    uint64_t sum = 0;
+    for (const PrefetchTestNode* node : zm::prefetching(root->nodes, distance))
+    {
+        sum += node ? node->payload : 0;
+    }
+    return sum;
+}
+
+static uint64_t sumList(const PrefetchTestRoot* root, size_t lookahead)
+{
+    uint64_t sum = 0;
+    zm::forEachInList(
+        root->head.get(), &PrefetchTestNode::next, [&sum](const PrefetchTestNode& node) { sum += node.payload; }, lookahead);
+    return sum;
+}
+
+TEST(ZmeyaTestSuite, PrefetchTraversalTest)
+{
+    const size_t numNodes = 1000;
+    std::vector<char> blob = buildBlob(numNodes, 13);
+    const PrefetchTestRoot* root = (const PrefetchTestRoot*)(blob.data());
+
+    uint64_t expectedArraySum = 0;
+    uint64_t expectedListSum = 0;
+    for (size_t i = 0; i < numNodes; i++)
+    {
+        expectedArraySum += ((i % 7) != 3) ? i : 0;
+        expectedListSum += i;
+    }
+
+    for (size_t distance : {size_t(0), size_t(1), size_t(8), size_t(5000)})
+    {
+        EXPECT_EQ(sumArray(root, distance), expectedArraySum);
+        EXPECT_EQ(sumList(root, distance), expectedListSum);
+    }
+
+    // visit order matches the array/list order
+    size_t index = 0;
+    for (const PrefetchTestNode* node : zm::prefetching(root->nodes))
+    {
+        if ((index % 7) != 3)
+        {
+            ASSERT_TRUE(node != nullptr);
+            EXPECT_EQ(node->payload, uint32_t(index));
+        }
+        else
+        {
+            EXPECT_TRUE(node == nullptr);
+        }
+        index++;
+    }
+    EXPECT_EQ(index, numNodes);
+
+    index = 0;
+    zm::forEachInList(root->head.get(), &PrefetchTestNode::next,
+                      [&index](const PrefetchTestNode& node)
+                      {
+                          EXPECT_EQ(node.payload, uint32_t(index));
+                          index++;
+                      });
+    EXPECT_EQ(index, numNodes);
+
+    for (const PrefetchTestNode* node : zm::prefetching(root->empty))
+    {
+        (void)node;
+        FAIL();
+    }
+
+    size_t count = 0;
+    zm::forEachInList((const PrefetchTestNode*)nullptr, &PrefetchTestNode::next, [&count](const PrefetchTestNode&) { count++; });
+    EXPECT_EQ(count, std::size_t(0));
+}
+
+// run with --gtest_also_run_disabled_tests to pick the default prefetch distances
+TEST(ZmeyaTestSuite, DISABLED_PrefetchDistanceBenchmark)
+{
+    const size_t numNodes = 4 * 1024 * 1024;
+    const int numIterations = 5;
+    std::vector<char> blob = buildBlob(numNodes, 13);
+    const PrefetchTestRoot* root = (const PrefetchTestRoot*)(blob.data());
+
+    for (size_t distance : {size_t(0), size_t(2), size_t(4), size_t(8), size_t(16), size_t(32), size_t(64)})
+    {
+        uint64_t sum = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < numIterations; i++)
+        {
+            sum += sumArray(root, distance);
+        }
+        auto stop = std::chrono::high_resolution_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(stop - start).count() / numIterations;
+        printf("array, distance %2d: %8.2f ms (%llu)\n", int(distance), ms, (unsigned long long)sum);
+    }
+
+    for (size_t lookahead : {size_t(0), size_t(1), size_t(2), size_t(4), size_t(8), size_t(16)})
+    {
+        uint64_t sum = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < numIterations; i++)
+        {
+            sum += sumList(root, lookahead);
+        }
+        auto stop = std::chrono::high_resolution_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(stop - start).count() / numIterations;
+        printf("list, lookahead %2d: %8.2f ms (%llu)\n", int(lookahead), ms, (unsigned long long)sum);
+    }
+}
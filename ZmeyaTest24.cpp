@@ -0,0 +1,114 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+
+struct StorageTestNode
+{
+    uint32_t payload;
+    zm::String name;
+    zm::Pointer<StorageTestNode> next;
+};
+
+struct StorageTestRoot
+{
+    zm::Array<uint32_t> values;
+    zm::Pointer<StorageTestNode> head;
+};
+
+static const uint32_t kNumNodes = 50000;
+
+static void validate(const StorageTestRoot* root)
+{
+    ASSERT_EQ(root->values.size(), std::size_t(kNumNodes));
+    for (uint32_t i = 0; i < kNumNodes; i++)
+    {
+        EXPECT_EQ(root->values[i], i * 5);
+    }
+
+    uint32_t count = 0;
+    for (const StorageTestNode* node = root->head.get(); node != nullptr; node = node->next.get())
+    {
+        EXPECT_EQ(node->payload, count);
+        EXPECT_EQ(node->name, "node_" + std::to_string(count));
+        count++;
+    }
+    EXPECT_EQ(count, kNumNodes);
+}
+
+static std::vector<char> buildBlob(const std::shared_ptr<zm::BlobBuilder>& blobBuilder)
+{
+    zm::BlobPtr<StorageTestRoot> root = blobBuilder->allocate<StorageTestRoot>();
+    const char* rootAddr = reinterpret_cast<const char*>(root.get());
+
+    std::vector<uint32_t> values(kNumNodes);
+    for (uint32_t i = 0; i < kNumNodes; i++)
+    {
+        values[i] = i * 5;
+    }
+    blobBuilder->copyTo(root->values, values);
+
+    zm::BlobPtr<StorageTestNode> prevNode;
+    for (uint32_t i = 0; i < kNumNodes; i++)
+    {
+        zm::BlobPtr<StorageTestNode> node = blobBuilder->allocate<StorageTestNode>();
+        node->payload = i;
+        blobBuilder->copyTo(node->name, "node_" + std::to_string(i));
+        if (prevNode)
+        {
+            prevNode->next = node;
+        }
+        else
+        {
+            root->head = node;
+        }
+        prevNode = node;
+    }
+
+    // stable storage never relocates the blob
+    if (blobBuilder->hasStableAddresses())
+    {
+        EXPECT_EQ(reinterpret_cast<const char*>(root.get()), rootAddr);
+    }
+
+    validate(root.get());
+
+    zm::Span<char> bytes = blobBuilder->finalize(32);
+    std::vector<char> bytesCopy = utils::copyBytes(bytes);
+    std::memset(bytes.data, 0xFF, bytes.size);
+    return bytesCopy;
+}
+
+TEST(ZmeyaTestSuite, VirtualMemoryStorageTest)
+{
+    std::shared_ptr<zm::BlobBuilder> vectorBuilder = zm::BlobBuilder::create(1);
+    EXPECT_EQ(vectorBuilder->getStorageType(), zm::BlobStorageType::Vector);
+    EXPECT_FALSE(vectorBuilder->hasStableAddresses());
+    std::vector<char> vectorBlob = buildBlob(vectorBuilder);
+
+    // small initial commit, the blob has to grow many times
+    std::shared_ptr<zm::BlobBuilder> vmBuilder = zm::BlobBuilder::create(1, zm::BlobStorageType::VirtualMemory, 256 * 1024 * 1024);
+#if !defined(ZMEYA_DISABLE_VIRTUAL_MEMORY) && (defined(_WIN32) || defined(__unix__) || defined(__APPLE__))
+    EXPECT_EQ(vmBuilder->getStorageType(), zm::BlobStorageType::VirtualMemory);
+    EXPECT_TRUE(vmBuilder->hasStableAddresses());
+#endif
+    std::vector<char> vmBlob = buildBlob(vmBuilder);
+
+    // storage type does not affect the blob content
+    ASSERT_EQ(vmBlob.size(), vectorBlob.size());
+    EXPECT_TRUE(std::memcmp(vmBlob.data(), vectorBlob.data(), vmBlob.size()) == 0);
+
+    validate((const StorageTestRoot*)(vmBlob.data()));
+}
+
+#if GTEST_HAS_DEATH_TEST && !defined(ZMEYA_DISABLE_VIRTUAL_MEMORY) && (defined(_WIN32) || defined(__unix__) || defined(__APPLE__))
+TEST(ZmeyaTestSuite, VirtualMemoryStorageHardCapTest)
+{
+    // the reserved size is a hard cap, growing past it must not write outside the reserved range
+    EXPECT_DEATH(
+        {
+            std::shared_ptr<zm::BlobBuilder> vmBuilder = zm::BlobBuilder::create(1, zm::BlobStorageType::VirtualMemory, 64 * 1024);
+            vmBuilder->allocate(128 * 1024, 16);
+        },
+        "");
+}
+#endif
@@ -0,0 +1,77 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+
+struct BlobPtrTestBase
+{
+    uint32_t id;
+};
+
+struct BlobPtrTestDerived : public BlobPtrTestBase
+{
+    float value;
+    zm::Pointer<BlobPtrTestDerived> other;
+};
+
+TEST(ZmeyaTestSuite, BlobPtrTest)
+{
+    std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+
+    // null BlobPtr
+    zm::BlobPtr<BlobPtrTestDerived> nullPtr;
+    EXPECT_FALSE(nullPtr);
+    EXPECT_TRUE(nullPtr.get() == nullptr);
+
+    zm::BlobPtr<BlobPtrTestDerived> a = blobBuilder->allocate<BlobPtrTestDerived>();
+    a->id = 1;
+    a->value = 1.5f;
+    zm::BlobPtr<BlobPtrTestDerived> b = blobBuilder->allocate<BlobPtrTestDerived>();
+    b->id = 2;
+    b->value = 2.5f;
+    EXPECT_TRUE(a);
+    EXPECT_TRUE(a != b);
+
+    // copy/move/conversion keep the builder and the offset
+    zm::BlobPtr<BlobPtrTestDerived> aCopy = a;
+    EXPECT_TRUE(aCopy == a);
+    EXPECT_EQ(aCopy.getAbsoluteOffset(), a.getAbsoluteOffset());
+    zm::BlobPtr<BlobPtrTestBase> aBase = a;
+    EXPECT_EQ(aBase->id, uint32_t(1));
+    zm::BlobPtr<BlobPtrTestDerived> bMoved = std::move(aCopy);
+    bMoved = b;
+    EXPECT_TRUE(bMoved == b);
+
+    // the same offset in a different builder is a different BlobPtr
+    std::shared_ptr<zm::BlobBuilder> otherBuilder = zm::BlobBuilder::create(1);
+    zm::BlobPtr<BlobPtrTestDerived> otherA = otherBuilder->allocate<BlobPtrTestDerived>();
+    EXPECT_EQ(otherA.getAbsoluteOffset(), a.getAbsoluteOffset());
+    EXPECT_TRUE(otherA != a);
+
+    // BlobPtr survives storage reallocation
+    for (uint32_t i = 0; i < 10000; i++)
+    {
+        zm::BlobPtr<uint32_t> v = blobBuilder->allocate<uint32_t>(i);
+        EXPECT_EQ(*v, i);
+    }
+    EXPECT_EQ(a->id, uint32_t(1));
+    EXPECT_FLOAT_EQ(b->value, 2.5f);
+
+    a->other = b;
+    b->other = nullPtr;
+    EXPECT_EQ(a->other->id, uint32_t(2));
+    EXPECT_TRUE(b->other == nullptr);
+
+    zm::Span<char> bytes = blobBuilder->finalize();
+    std::vector<char> bytesCopy = utils::copyBytes(bytes);
+    std::memset(bytes.data, 0xFF, bytes.size);
+
+    const BlobPtrTestDerived* aCopyRoot = (const BlobPtrTestDerived*)(bytesCopy.data());
+    EXPECT_EQ(aCopyRoot->id, uint32_t(1));
+    EXPECT_FLOAT_EQ(aCopyRoot->other->value, 2.5f);
+
+#ifndef ZMEYA_FAST_BLOBPTR
+    // weak reference: BlobPtr becomes null when the builder is destroyed
+    otherBuilder.reset();
+    EXPECT_TRUE(otherA.get() == nullptr);
+#endif
+}
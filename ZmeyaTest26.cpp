@@ -0,0 +1,100 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+
+struct BytesTestRoot
+{
+    zm::String shortStr;
+    zm::String longStr;
+    zm::Pointer<char> rawBytes;
+    uint32_t rawBytesSize;
+    zm::Array<uint64_t> values;
+    zm::Array<uint64_t> emptyValues;
+    zm::SmallArray<uint16_t> smallValues;
+};
+
+static std::string makeLongString(size_t len)
+{
+    std::string str;
+    str.reserve(len);
+    for (size_t i = 0; i < len; i++)
+    {
+        str.push_back(char('a' + (i % 26)));
+    }
+    return str;
+}
+
+static void validate(const BytesTestRoot* root)
+{
+    EXPECT_EQ(root->shortStr, "x");
+    EXPECT_EQ(root->longStr, makeLongString(10000));
+    EXPECT_EQ(std::strlen(root->longStr.c_str()), std::size_t(10000));
+
+    ASSERT_EQ(root->rawBytesSize, uint32_t(256));
+    const char* rawBytes = root->rawBytes.get();
+    EXPECT_EQ(uintptr_t(rawBytes) & 15, uintptr_t(0));
+    for (uint32_t i = 0; i < root->rawBytesSize; i++)
+    {
+        EXPECT_EQ(uint8_t(rawBytes[i]), uint8_t(255 - i));
+    }
+
+    ASSERT_EQ(root->values.size(), std::size_t(1000));
+    EXPECT_EQ(uintptr_t(root->values.data()) & (alignof(uint64_t) - 1), uintptr_t(0));
+    for (size_t i = 0; i < root->values.size(); i++)
+    {
+        EXPECT_EQ(root->values[i], uint64_t(i) * 0x100000001ull);
+    }
+    EXPECT_TRUE(root->emptyValues.empty());
+
+    ASSERT_EQ(root->smallValues.size(), std::size_t(3));
+    EXPECT_EQ(root->smallValues[0], uint16_t(7));
+    EXPECT_EQ(root->smallValues[2], uint16_t(9));
+}
+
+TEST(ZmeyaTestSuite, BulkBytesTest)
+{
+    std::vector<char> bytesCopy;
+    {
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+        zm::BlobPtr<BytesTestRoot> root = blobBuilder->allocate<BytesTestRoot>();
+
+        blobBuilder->copyTo(root->shortStr, "x");
+        std::string longStr = makeLongString(10000);
+        blobBuilder->copyTo(root->longStr, longStr);
+
+        // odd size to check the alignment
+        blobBuilder->allocateBytes("?", 1);
+        std::vector<uint8_t> raw(256);
+        for (size_t i = 0; i < raw.size(); i++)
+        {
+            raw[i] = uint8_t(255 - i);
+        }
+        zm::BlobPtr<char> rawData = blobBuilder->allocateBytes(raw.data(), raw.size(), 16);
+        EXPECT_EQ(rawData.getAbsoluteOffset() % 16, zm::offset_t(0));
+        root->rawBytes = rawData;
+        root->rawBytesSize = uint32_t(raw.size());
+
+        // empty range
+        blobBuilder->allocateBytes(zm::Span<const char>(), 1);
+
+        blobBuilder->allocateBytes("?", 1);
+        std::vector<uint64_t> values(1000);
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            values[i] = uint64_t(i) * 0x100000001ull;
+        }
+        blobBuilder->copyTo(root->values, values);
+        blobBuilder->copyToArrayFast(root->emptyValues, values.data(), 0);
+        blobBuilder->allocateBytes("?", 1);
+        blobBuilder->copyTo(root->smallValues, {uint16_t(7), uint16_t(8), uint16_t(9)});
+
+        validate(root.get());
+
+        zm::Span<char> bytes = blobBuilder->finalize();
+        bytesCopy = utils::copyBytes(bytes);
+        std::memset(bytes.data, 0xFF, bytes.size);
+    }
+
+    const BytesTestRoot* rootCopy = (const BytesTestRoot*)(bytesCopy.data());
+    validate(rootCopy);
+}
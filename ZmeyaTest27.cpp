@@ -0,0 +1,129 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+#include <thread>
+
+struct ReuseTestRoot
+{
+    uint32_t requestId;
+    zm::String name;
+    zm::Array<uint32_t> values;
+};
+
+static zm::Span<char> buildResponse(zm::BlobBuilder* blobBuilder, uint32_t requestId, size_t numValues)
+{
+    zm::BlobPtr<ReuseTestRoot> root = blobBuilder->allocate<ReuseTestRoot>();
+    root->requestId = requestId;
+    blobBuilder->copyTo(root->name, "response_" + std::to_string(requestId));
+    std::vector<uint32_t> values(numValues);
+    for (size_t i = 0; i < numValues; i++)
+    {
+        values[i] = requestId + uint32_t(i);
+    }
+    blobBuilder->copyTo(root->values, values);
+    return blobBuilder->finalize();
+}
+
+static void validate(const ReuseTestRoot* root, uint32_t requestId, size_t numValues)
+{
+    EXPECT_EQ(root->requestId, requestId);
+    EXPECT_EQ(root->name, "response_" + std::to_string(requestId));
+    ASSERT_EQ(root->values.size(), numValues);
+    for (size_t i = 0; i < numValues; i++)
+    {
+        EXPECT_EQ(root->values[i], requestId + uint32_t(i));
+    }
+}
+
+TEST(ZmeyaTestSuite, BuilderResetTest)
+{
+    for (zm::BlobStorageType storageType : {zm::BlobStorageType::Vector, zm::BlobStorageType::VirtualMemory})
+    {
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1, storageType, 64 * 1024 * 1024);
+
+        zm::Span<char> bytes = buildResponse(blobBuilder.get(), 1, 10000);
+        std::vector<char> firstBlob = utils::copyBytes(bytes);
+        size_t capacity = blobBuilder->getCapacity();
+        EXPECT_GE(capacity, firstBlob.size());
+
+        // dirty the memory, reset must zero everything that is reused
+        std::memset(bytes.data, 0xFF, bytes.size);
+        blobBuilder->reset();
+        EXPECT_EQ(blobBuilder->getSize(), std::size_t(0));
+        EXPECT_EQ(blobBuilder->getCapacity(), capacity);
+
+        bytes = buildResponse(blobBuilder.get(), 1, 10000);
+        ASSERT_EQ(bytes.size, firstBlob.size());
+        EXPECT_TRUE(std::memcmp(bytes.data, firstBlob.data(), bytes.size) == 0);
+        EXPECT_EQ(blobBuilder->getCapacity(), capacity);
+
+        // smaller blob after reset
+        blobBuilder->reset();
+        bytes = buildResponse(blobBuilder.get(), 7, 10);
+        std::vector<char> secondBlob = utils::copyBytes(bytes);
+        std::memset(bytes.data, 0xFF, bytes.size);
+        validate((const ReuseTestRoot*)secondBlob.data(), 7, 10);
+    }
+}
+
+TEST(ZmeyaTestSuite, BuilderPoolTest)
+{
+    zm::BlobBuilderPool pool(4, 1024);
+    EXPECT_EQ(pool.getNumFreeBuilders(), std::size_t(0));
+
+    {
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = pool.acquire();
+        zm::Span<char> bytes = buildResponse(blobBuilder.get(), 3, 50000);
+        validate((const ReuseTestRoot*)bytes.data, 3, 50000);
+        size_t usedSize = blobBuilder->getSize();
+        pool.release(std::move(blobBuilder));
+        EXPECT_EQ(pool.getNumFreeBuilders(), std::size_t(1));
+        EXPECT_EQ(pool.getHighWaterMark(), usedSize);
+
+        // reused builder is empty and already warmed up
+        std::shared_ptr<zm::BlobBuilder> reused = pool.acquire();
+        EXPECT_EQ(reused->getSize(), std::size_t(0));
+        EXPECT_GE(reused->getCapacity(), usedSize);
+        EXPECT_EQ(pool.getNumFreeBuilders(), std::size_t(0));
+
+        // builders that are still referenced are not pooled
+        std::shared_ptr<zm::BlobBuilder> extraRef = reused;
+        pool.release(reused);
+        EXPECT_EQ(pool.getNumFreeBuilders(), std::size_t(0));
+    }
+
+    const int numThreads = 8;
+    const int numRequestsPerThread = 200;
+    std::vector<std::thread> threads;
+    std::vector<int> numErrors(numThreads, 0);
+    for (int t = 0; t < numThreads; t++)
+    {
+        threads.emplace_back(
+            [&pool, &numErrors, t]()
+            {
+                for (int i = 0; i < numRequestsPerThread; i++)
+                {
+                    uint32_t requestId = uint32_t(t * numRequestsPerThread + i);
+                    size_t numValues = 1 + (requestId % 97) * 10;
+                    std::shared_ptr<zm::BlobBuilder> blobBuilder = pool.acquire();
+                    zm::Span<char> bytes = buildResponse(blobBuilder.get(), requestId, numValues);
+                    const ReuseTestRoot* root = (const ReuseTestRoot*)bytes.data;
+                    if (root->requestId != requestId || root->values.size() != numValues ||
+                        root->values[numValues - 1] != requestId + uint32_t(numValues - 1))
+                    {
+                        numErrors[t]++;
+                    }
+                    pool.release(std::move(blobBuilder));
+                }
+            });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    for (int t = 0; t < numThreads; t++)
+    {
+        EXPECT_EQ(numErrors[t], 0);
+    }
+    EXPECT_LE(pool.getNumFreeBuilders(), std::size_t(4));
+}
@@ -0,0 +1,119 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+
+struct PlannerTestItem
+{
+    uint64_t id;
+    zm::String name;
+    zm::Array<float> weights;
+};
+
+struct PlannerTestRoot
+{
+    uint8_t flags;
+    zm::String title;
+    zm::Array<PlannerTestItem> items;
+    zm::Array<zm::String> tags;
+    zm::Array<zm::Array<uint16_t>> jagged;
+    zm::HashSet<uint32_t> ids;
+    zm::HashMap<zm::String, double> params;
+    zm::HashMap<uint32_t, zm::String> names;
+    zm::Pointer<PlannerTestItem> extra;
+};
+
+struct PlannerTestSource
+{
+    std::string title;
+    std::vector<std::string> itemNames;
+    std::vector<std::string> tags;
+    std::vector<std::vector<uint16_t>> jagged;
+    std::unordered_set<uint32_t> ids;
+    std::unordered_map<std::string, double> params;
+    std::unordered_map<uint32_t, std::string> names;
+};
+
+static PlannerTestSource makeSource()
+{
+    PlannerTestSource src;
+    src.title = "Size planner test";
+    for (int i = 0; i < 37; i++)
+    {
+        src.itemNames.push_back("item_" + std::to_string(i * 13));
+        src.tags.push_back(std::string(size_t(1 + i % 5), char('a' + i % 26)));
+        src.jagged.push_back(std::vector<uint16_t>(size_t(1 + (i * 7) % 11), uint16_t(i)));
+        src.ids.insert(uint32_t(i * 31));
+        src.params["param_" + std::to_string(i)] = double(i) * 0.5;
+        src.names[uint32_t(i)] = "name_" + std::to_string(i * i);
+    }
+    return src;
+}
+
+static size_t plan(const PlannerTestSource& src, size_t multipleOf)
+{
+    zm::BlobSizePlanner planner;
+    planner.allocate<PlannerTestRoot>();
+    planner.copyTo(src.title);
+    planner.resizeArray<PlannerTestItem>(src.itemNames.size());
+    for (size_t i = 0; i < src.itemNames.size(); i++)
+    {
+        planner.copyTo(src.itemNames[i]);
+        planner.resizeArray<float>(i % 4);
+    }
+    planner.copyTo(src.tags);
+    planner.copyTo(src.jagged);
+    planner.copyTo(src.ids);
+    planner.copyTo(src.params);
+    planner.copyTo(src.names);
+    planner.allocate<PlannerTestItem>();
+    planner.allocateBytes(3, 16);
+    return planner.finalize(multipleOf);
+}
+
+static zm::Span<char> build(zm::BlobBuilder* blobBuilder, const PlannerTestSource& src, size_t multipleOf)
+{
+    zm::BlobPtr<PlannerTestRoot> root = blobBuilder->allocate<PlannerTestRoot>();
+    root->flags = 3;
+    blobBuilder->copyTo(root->title, src.title);
+    blobBuilder->resizeArray(root->items, src.itemNames.size());
+    for (size_t i = 0; i < src.itemNames.size(); i++)
+    {
+        zm::BlobPtr<PlannerTestItem> item = blobBuilder->getArrayElement(root->items, i);
+        item->id = i;
+        blobBuilder->copyTo(item->name, src.itemNames[i]);
+        blobBuilder->resizeArray(item->weights, i % 4);
+    }
+    blobBuilder->copyTo(root->tags, src.tags);
+    blobBuilder->copyTo(root->jagged, src.jagged);
+    blobBuilder->copyTo(root->ids, src.ids);
+    blobBuilder->copyTo(root->params, src.params);
+    blobBuilder->copyTo(root->names, src.names);
+    root->extra = blobBuilder->allocate<PlannerTestItem>();
+    blobBuilder->allocateBytes("xyz", 3, 16);
+    return blobBuilder->finalize(multipleOf);
+}
+
+TEST(ZmeyaTestSuite, SizePlannerTest)
+{
+    PlannerTestSource src = makeSource();
+
+    for (size_t multipleOf : {size_t(1), size_t(4), size_t(64), size_t(4096)})
+    {
+        size_t plannedSize = plan(src, multipleOf);
+
+        // build into storage of exactly the right size
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(plannedSize);
+        size_t capacity = blobBuilder->getCapacity();
+        EXPECT_GE(capacity, plannedSize);
+        zm::Span<char> bytes = build(blobBuilder.get(), src, multipleOf);
+        EXPECT_EQ(bytes.size, plannedSize);
+        // no reallocations during the build
+        EXPECT_EQ(blobBuilder->getCapacity(), capacity);
+
+        const PlannerTestRoot* root = (const PlannerTestRoot*)bytes.data;
+        EXPECT_EQ(root->title, src.title);
+        EXPECT_EQ(root->items.size(), src.itemNames.size());
+        EXPECT_EQ(root->names.find(5, ""), src.names[5]);
+        EXPECT_TRUE(zm::isBlobCompatible(bytes.data, bytes.size));
+    }
+}
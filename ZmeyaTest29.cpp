@@ -0,0 +1,140 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+#include <atomic>
+
+struct GeneratedItem
+{
+    uint32_t id;
+    float weight;
+};
+
+struct GeneratedArraysRoot
+{
+    zm::Array<GeneratedItem> items;
+    zm::Array<uint64_t> squares;
+    zm::Array<uint32_t> evenIds;
+    zm::Array<uint32_t> empty;
+    zm::Array<uint32_t> emptyWriter;
+};
+
+static const size_t kNumItems = 1000;
+static const size_t kNumSquares = 100000;
+
+static void validate(const GeneratedArraysRoot* root)
+{
+    ASSERT_EQ(root->items.size(), kNumItems);
+    for (size_t i = 0; i < kNumItems; i++)
+    {
+        EXPECT_EQ(root->items[i].id, uint32_t(i));
+        EXPECT_FLOAT_EQ(root->items[i].weight, float(i) * 0.5f);
+    }
+
+    ASSERT_EQ(root->squares.size(), kNumSquares);
+    for (size_t i = 0; i < kNumSquares; i++)
+    {
+        EXPECT_EQ(root->squares[i], uint64_t(i) * uint64_t(i));
+    }
+
+    ASSERT_EQ(root->evenIds.size(), kNumItems / 2);
+    for (size_t i = 0; i < root->evenIds.size(); i++)
+    {
+        EXPECT_EQ(root->evenIds[i], uint32_t(i * 2));
+    }
+
+    EXPECT_TRUE(root->empty.empty());
+    EXPECT_TRUE(root->emptyWriter.empty());
+}
+
+TEST(ZmeyaTestSuite, GeneratedArrayTest)
+{
+    std::vector<char> bytesCopy;
+    {
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+        zm::BlobPtr<GeneratedArraysRoot> root = blobBuilder->allocate<GeneratedArraysRoot>();
+
+        blobBuilder->buildArray(root->items, kNumItems,
+                                [](GeneratedItem* items, size_t numItems)
+                                {
+                                    for (size_t i = 0; i < numItems; i++)
+                                    {
+                                        items[i].id = uint32_t(i);
+                                        items[i].weight = float(i) * 0.5f;
+                                    }
+                                });
+
+        std::atomic<size_t> numFilled(0);
+        blobBuilder->buildArrayParallel(
+            root->squares, kNumSquares,
+            [&numFilled](uint64_t* squares, size_t firstIndex, size_t count)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    squares[i] = uint64_t(firstIndex + i) * uint64_t(firstIndex + i);
+                }
+                numFilled += count;
+            },
+            4);
+        EXPECT_EQ(numFilled.load(), kNumSquares);
+
+        // number of elements is unknown up front
+        {
+            zm::ArrayWriter<uint32_t> writer = blobBuilder->writeArray(root->evenIds);
+            for (const GeneratedItem& item : root->items)
+            {
+                if ((item.id & 1) == 0)
+                {
+                    writer.push_back(item.id);
+                }
+            }
+            EXPECT_EQ(writer.size(), kNumItems / 2);
+        }
+
+        blobBuilder->buildArray(root->empty, 0, [](uint32_t*, size_t) { FAIL(); });
+        zm::ArrayWriter<uint32_t> emptyWriter = blobBuilder->writeArray(root->emptyWriter);
+        emptyWriter.finish();
+
+        validate(root.get());
+
+        zm::Span<char> bytes = blobBuilder->finalize();
+        bytesCopy = utils::copyBytes(bytes);
+        std::memset(bytes.data, 0xFF, bytes.size);
+    }
+
+    const GeneratedArraysRoot* rootCopy = (const GeneratedArraysRoot*)(bytesCopy.data());
+    validate(rootCopy);
+}
+
+TEST(ZmeyaTestSuite, GeneratedArrayMatchesCopyTest)
+{
+    std::vector<uint32_t> values(50000);
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        values[i] = uint32_t(i * 2654435761u);
+    }
+
+    std::shared_ptr<zm::BlobBuilder> copyBuilder = zm::BlobBuilder::create(1);
+    zm::BlobPtr<zm::Array<uint32_t>> copyRoot = copyBuilder->allocate<zm::Array<uint32_t>>();
+    copyBuilder->copyTo(*copyRoot, values);
+    std::vector<char> copyBytes = utils::copyBytes(copyBuilder->finalize());
+
+    std::shared_ptr<zm::BlobBuilder> parallelBuilder = zm::BlobBuilder::create(1);
+    zm::BlobPtr<zm::Array<uint32_t>> parallelRoot = parallelBuilder->allocate<zm::Array<uint32_t>>();
+    parallelBuilder->buildArrayParallel(*parallelRoot, values.size(),
+                                        [&values](uint32_t* dst, size_t firstIndex, size_t count)
+                                        { std::memcpy(dst, values.data() + firstIndex, sizeof(uint32_t) * count); });
+    std::vector<char> parallelBytes = utils::copyBytes(parallelBuilder->finalize());
+
+    std::shared_ptr<zm::BlobBuilder> writerBuilder = zm::BlobBuilder::create(1);
+    zm::BlobPtr<zm::Array<uint32_t>> writerRoot = writerBuilder->allocate<zm::Array<uint32_t>>();
+    {
+        zm::ArrayWriter<uint32_t> writer = writerBuilder->writeArray(*writerRoot);
+        writer.append(values.data(), 100);
+        writer.append(values.data() + 100, values.size() - 100);
+    }
+    std::vector<char> writerBytes = utils::copyBytes(writerBuilder->finalize());
+
+    // all construction methods produce byte identical blobs
+    EXPECT_TRUE(copyBytes == parallelBytes);
+    EXPECT_TRUE(copyBytes == writerBytes);
+}
@@ -0,0 +1,128 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+
+struct DedupTestMaterial
+{
+    zm::String name;
+    zm::Array<uint32_t> textures;
+    zm::Array<float> curve;
+    zm::HashSet<int32_t> tags;
+    zm::HashMap<int32_t, float> params;
+};
+
+struct DedupTestRoot
+{
+    zm::Array<DedupTestMaterial> materials;
+    zm::Array<uint16_t> shortValues;
+    zm::Array<uint64_t> longValues;
+};
+
+static const size_t kNumMaterials = 64;
+
+static std::string getMaterialName(size_t index) { return "material_" + std::to_string(index % 4); }
+
+static void validate(const DedupTestRoot* root)
+{
+    ASSERT_EQ(root->materials.size(), kNumMaterials);
+    for (size_t i = 0; i < kNumMaterials; i++)
+    {
+        const DedupTestMaterial& material = root->materials[i];
+        EXPECT_EQ(material.name, getMaterialName(i));
+        ASSERT_EQ(material.textures.size(), std::size_t(4));
+        for (size_t j = 0; j < material.textures.size(); j++)
+        {
+            EXPECT_EQ(material.textures[j], uint32_t(100 + j));
+        }
+        ASSERT_EQ(material.curve.size(), std::size_t(3));
+        EXPECT_FLOAT_EQ(material.curve[0], 0.0f);
+        EXPECT_FLOAT_EQ(material.curve[1], 0.5f);
+        EXPECT_FLOAT_EQ(material.curve[2], 1.0f);
+        EXPECT_EQ(material.tags.size(), std::size_t(3));
+        EXPECT_TRUE(material.tags.contains(1));
+        EXPECT_TRUE(material.tags.contains(2));
+        EXPECT_TRUE(material.tags.contains(int32_t(i % 2) + 3));
+        EXPECT_FALSE(material.tags.contains(5));
+        EXPECT_EQ(material.params.size(), std::size_t(2));
+        EXPECT_FLOAT_EQ(material.params.find(7, 0.0f), 0.7f);
+        EXPECT_FLOAT_EQ(material.params.find(9, 0.0f), 0.9f);
+    }
+
+    ASSERT_EQ(root->shortValues.size(), std::size_t(4));
+    ASSERT_EQ(root->longValues.size(), std::size_t(1));
+    EXPECT_EQ(root->longValues[0], uint64_t(0x0004000300020001ull));
+    EXPECT_EQ(uintptr_t(root->longValues.data()) % alignof(uint64_t), uintptr_t(0));
+}
+
+static zm::Span<char> build(zm::BlobBuilder* blobBuilder)
+{
+    const std::unordered_map<int32_t, float> params = {{7, 0.7f}, {9, 0.9f}};
+    zm::BlobPtr<DedupTestRoot> root = blobBuilder->allocate<DedupTestRoot>();
+    blobBuilder->resizeArray(root->materials, kNumMaterials);
+    for (size_t i = 0; i < kNumMaterials; i++)
+    {
+        zm::BlobPtr<DedupTestMaterial> material = blobBuilder->getArrayElement(root->materials, i);
+        blobBuilder->copyTo(material->name, getMaterialName(i));
+        blobBuilder->copyTo(material->textures, {uint32_t(100), uint32_t(101), uint32_t(102), uint32_t(103)});
+        blobBuilder->copyTo(material->curve, {0.0f, 0.5f, 1.0f});
+        blobBuilder->copyTo(material->tags, {1, 2, int32_t(i % 2) + 3});
+        blobBuilder->copyTo(material->params, params);
+    }
+
+    // same bytes, but the 64-bit array can only reuse a suitably aligned region
+    blobBuilder->copyTo(root->shortValues, {uint16_t(1), uint16_t(2), uint16_t(3), uint16_t(4)});
+    blobBuilder->copyTo(root->longValues, {uint64_t(0x0004000300020001ull)});
+    return blobBuilder->finalize();
+}
+
+TEST(ZmeyaTestSuite, DeduplicationTest)
+{
+    std::shared_ptr<zm::BlobBuilder> plainBuilder = zm::BlobBuilder::create(1);
+    EXPECT_FALSE(plainBuilder->isDeduplicationEnabled());
+    zm::Span<char> plainBytes = build(plainBuilder.get());
+    validate((const DedupTestRoot*)plainBytes.data);
+    EXPECT_EQ(plainBuilder->getDeduplicationStats().numDeduplicatedRegions, std::size_t(0));
+    EXPECT_EQ(plainBuilder->getDeduplicationStats().numBytesSaved, std::size_t(0));
+
+    std::vector<char> bytesCopy;
+    {
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+        blobBuilder->setDeduplicationEnabled(true);
+        zm::Span<char> bytes = build(blobBuilder.get());
+        const DedupTestRoot* root = (const DedupTestRoot*)bytes.data;
+        validate(root);
+
+        // identical data is shared
+        const DedupTestMaterial& first = root->materials[0];
+        for (size_t i = 1; i < kNumMaterials; i++)
+        {
+            const DedupTestMaterial& material = root->materials[i];
+            EXPECT_EQ(material.textures.data(), first.textures.data());
+            EXPECT_EQ(material.curve.data(), first.curve.data());
+            EXPECT_EQ(material.params.find(7), first.params.find(7));
+            EXPECT_EQ(material.name.c_str(), root->materials[i % 4].name.c_str());
+            EXPECT_EQ(material.tags.contains(1), root->materials[i % 2].tags.contains(1));
+        }
+        EXPECT_NE(root->materials[0].tags.begin(), root->materials[1].tags.begin());
+        EXPECT_EQ(root->materials[0].tags.begin(), root->materials[2].tags.begin());
+
+        const zm::DeduplicationStats& stats = blobBuilder->getDeduplicationStats();
+        EXPECT_GT(stats.numDeduplicatedRegions, (kNumMaterials - 4) * 4);
+        EXPECT_GT(stats.numBytesSaved, std::size_t(0));
+        EXPECT_LT(bytes.size * 2, plainBytes.size);
+
+        bytesCopy = utils::copyBytes(bytes);
+        std::memset(bytes.data, 0xFF, bytes.size);
+
+        // reset clears the deduplication state
+        blobBuilder->reset();
+        EXPECT_EQ(blobBuilder->getDeduplicationStats().numBytesSaved, std::size_t(0));
+        EXPECT_TRUE(blobBuilder->isDeduplicationEnabled());
+        zm::Span<char> rebuiltBytes = build(blobBuilder.get());
+        ASSERT_EQ(rebuiltBytes.size, bytesCopy.size());
+        EXPECT_TRUE(std::memcmp(rebuiltBytes.data, bytesCopy.data(), bytesCopy.size()) == 0);
+    }
+
+    const DedupTestRoot* rootCopy = (const DedupTestRoot*)(bytesCopy.data());
+    validate(rootCopy);
+}
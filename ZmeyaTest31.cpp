@@ -0,0 +1,144 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+#include <thread>
+
+struct LinkTestChunk
+{
+    uint32_t index;
+    zm::String name;
+    zm::Array<uint32_t> values;
+    zm::Pointer<LinkTestChunk> next;
+    zm::Array<uint32_t> prevValues;
+};
+
+struct LinkTestRoot
+{
+    uint32_t magic;
+    zm::Array<zm::Pointer<LinkTestChunk>> chunks;
+};
+
+static const size_t kNumChunks = 6;
+
+static size_t getNumValues(size_t chunkIndex) { return 1000 + chunkIndex * 17; }
+
+static void validate(const LinkTestRoot* root)
+{
+    EXPECT_EQ(root->magic, uint32_t(0x12345678));
+    ASSERT_EQ(root->chunks.size(), kNumChunks);
+    for (size_t i = 0; i < kNumChunks; i++)
+    {
+        const LinkTestChunk* chunk = root->chunks[i].get();
+        ASSERT_TRUE(chunk != nullptr);
+        EXPECT_EQ(chunk->index, uint32_t(i));
+        EXPECT_EQ(chunk->name, "chunk_" + std::to_string(i));
+        ASSERT_EQ(chunk->values.size(), getNumValues(i));
+        for (size_t j = 0; j < chunk->values.size(); j++)
+        {
+            EXPECT_EQ(chunk->values[j], uint32_t(i * 100000 + j));
+        }
+
+        if (i + 1 < kNumChunks)
+        {
+            EXPECT_EQ(chunk->next.get(), root->chunks[i + 1].get());
+        }
+        else
+        {
+            EXPECT_TRUE(chunk->next == nullptr);
+        }
+
+        if (i > 0)
+        {
+            const LinkTestChunk* prev = root->chunks[i - 1].get();
+            ASSERT_EQ(chunk->prevValues.size(), prev->values.size());
+            EXPECT_EQ(chunk->prevValues.data(), prev->values.data());
+        }
+        else
+        {
+            EXPECT_TRUE(chunk->prevValues.empty());
+        }
+    }
+}
+
+TEST(ZmeyaTestSuite, BlobLinkerTest)
+{
+    zm::BlobLinker linker;
+    std::shared_ptr<zm::BlobBuilder> rootChunk = linker.createChunk();
+    std::vector<std::shared_ptr<zm::BlobBuilder>> chunks;
+    for (size_t i = 0; i < kNumChunks; i++)
+    {
+        chunks.emplace_back(linker.createChunk(1));
+    }
+    EXPECT_EQ(linker.getNumChunks(), kNumChunks + 1);
+
+    zm::BlobPtr<LinkTestRoot> root = rootChunk->allocate<LinkTestRoot>();
+    root->magic = 0x12345678;
+    rootChunk->resizeArray(root->chunks, kNumChunks);
+
+    // build the chunks in parallel
+    std::vector<zm::BlobPtr<LinkTestChunk>> chunkRoots(kNumChunks);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < kNumChunks; i++)
+    {
+        threads.emplace_back(
+            [&, i]()
+            {
+                zm::BlobBuilder* blobBuilder = chunks[i].get();
+                // some padding to make chunk offsets different
+                blobBuilder->allocate(i * 3 + 1, 1);
+                zm::BlobPtr<LinkTestChunk> chunk = blobBuilder->allocate<LinkTestChunk>();
+                chunk->index = uint32_t(i);
+                blobBuilder->copyTo(chunk->name, "chunk_" + std::to_string(i));
+                std::vector<uint32_t> values(getNumValues(i));
+                for (size_t j = 0; j < values.size(); j++)
+                {
+                    values[j] = uint32_t(i * 100000 + j);
+                }
+                blobBuilder->copyTo(chunk->values, values);
+                chunkRoots[i] = chunk;
+
+                // root chunk -> this chunk
+                linker.linkPointer(rootChunk->getArrayElement(root->chunks, i), chunk);
+            });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    // chunk -> chunk references
+    for (size_t i = 0; i < kNumChunks; i++)
+    {
+        zm::BlobBuilder* blobBuilder = chunks[i].get();
+        if (i + 1 < kNumChunks)
+        {
+            linker.linkPointer(blobBuilder->getBlobPtr(&chunkRoots[i]->next), chunkRoots[i + 1]);
+        }
+        if (i > 0)
+        {
+            const zm::Array<uint32_t>& prevValues = chunkRoots[i - 1]->values;
+            linker.linkArray(blobBuilder->getBlobPtr(&chunkRoots[i]->prevValues), chunks[i - 1]->getBlobPtr(prevValues.data()),
+                             prevValues.size());
+        }
+    }
+
+    std::vector<char> bytesCopy;
+    {
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+        std::vector<zm::offset_t> chunkOffsets = linker.link(blobBuilder.get());
+        ASSERT_EQ(chunkOffsets.size(), kNumChunks + 1);
+        EXPECT_EQ(chunkOffsets[0], zm::offset_t(0));
+        for (size_t i = 1; i < chunkOffsets.size(); i++)
+        {
+            EXPECT_GT(chunkOffsets[i], chunkOffsets[i - 1]);
+        }
+
+        zm::Span<char> bytes = blobBuilder->finalize();
+        validate((const LinkTestRoot*)bytes.data);
+        bytesCopy = utils::copyBytes(bytes);
+        std::memset(bytes.data, 0xFF, bytes.size);
+    }
+
+    const LinkTestRoot* rootCopy = (const LinkTestRoot*)(bytesCopy.data());
+    validate(rootCopy);
+}
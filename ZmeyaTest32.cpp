@@ -0,0 +1,118 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+
+struct ParallelCopyTestRoot
+{
+    zm::Array<zm::String> names;
+    zm::Array<zm::String> tags;
+    zm::Array<zm::Array<uint16_t>> shortLists;
+    zm::Array<zm::Array<uint64_t>> longLists;
+};
+
+struct ParallelCopyTestData
+{
+    std::vector<std::string> names;
+    std::vector<const char*> tags;
+    std::vector<std::vector<uint16_t>> shortLists;
+    std::vector<std::vector<uint64_t>> longLists;
+};
+
+static ParallelCopyTestData generateData()
+{
+    static const char* kTags[] = {"a", "tag", "another_tag", "x1"};
+
+    ParallelCopyTestData data;
+    uint32_t seed = 7;
+    for (size_t i = 0; i < 20000; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        data.names.emplace_back("name_" + std::to_string(i) + std::string((seed >> 16) % 13, 'z'));
+        data.tags.push_back(kTags[(seed >> 8) % 4]);
+    }
+    for (size_t i = 0; i < 5000; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        std::vector<uint16_t> shortList(1 + (seed >> 16) % 7);
+        for (size_t j = 0; j < shortList.size(); j++)
+        {
+            shortList[j] = uint16_t(i + j);
+        }
+        data.shortLists.emplace_back(std::move(shortList));
+        data.longLists.emplace_back(1 + (seed >> 20) % 3, uint64_t(i) << 32);
+    }
+    return data;
+}
+
+static void validate(const ParallelCopyTestRoot* root, const ParallelCopyTestData& data)
+{
+    ASSERT_EQ(root->names.size(), data.names.size());
+    for (size_t i = 0; i < data.names.size(); i++)
+    {
+        EXPECT_EQ(root->names[i], data.names[i]);
+    }
+    ASSERT_EQ(root->tags.size(), data.tags.size());
+    for (size_t i = 0; i < data.tags.size(); i++)
+    {
+        EXPECT_EQ(root->tags[i], data.tags[i]);
+    }
+    ASSERT_EQ(root->shortLists.size(), data.shortLists.size());
+    ASSERT_EQ(root->longLists.size(), data.longLists.size());
+    for (size_t i = 0; i < data.shortLists.size(); i++)
+    {
+        ASSERT_EQ(root->shortLists[i].size(), data.shortLists[i].size());
+        for (size_t j = 0; j < data.shortLists[i].size(); j++)
+        {
+            EXPECT_EQ(root->shortLists[i][j], data.shortLists[i][j]);
+        }
+        ASSERT_EQ(root->longLists[i].size(), data.longLists[i].size());
+        for (size_t j = 0; j < data.longLists[i].size(); j++)
+        {
+            EXPECT_EQ(root->longLists[i][j], data.longLists[i][j]);
+        }
+        EXPECT_EQ(uintptr_t(root->longLists[i].data()) % alignof(uint64_t), uintptr_t(0));
+    }
+}
+
+static std::vector<char> build(const ParallelCopyTestData& data, bool parallel, bool deduplication)
+{
+    std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+    blobBuilder->setDeduplicationEnabled(deduplication);
+    zm::BlobPtr<ParallelCopyTestRoot> root = blobBuilder->allocate<ParallelCopyTestRoot>();
+    if (parallel)
+    {
+        blobBuilder->copyToParallel(root->names, data.names, 4);
+        blobBuilder->copyToParallel(root->tags, data.tags, 3);
+        blobBuilder->copyToParallel(root->shortLists, data.shortLists, 4);
+        blobBuilder->copyToParallel(root->longLists, data.longLists);
+    }
+    else
+    {
+        blobBuilder->copyTo(root->names, data.names);
+        blobBuilder->copyTo(root->tags, data.tags);
+        blobBuilder->copyTo(root->shortLists, data.shortLists);
+        blobBuilder->copyTo(root->longLists, data.longLists);
+    }
+    zm::Span<char> bytes = blobBuilder->finalize();
+    validate((const ParallelCopyTestRoot*)bytes.data, data);
+    std::vector<char> bytesCopy = utils::copyBytes(bytes);
+    std::memset(bytes.data, 0xFF, bytes.size);
+    return bytesCopy;
+}
+
+TEST(ZmeyaTestSuite, ParallelCopyTest)
+{
+    ParallelCopyTestData data = generateData();
+
+    std::vector<char> serialBytes = build(data, false, false);
+    std::vector<char> parallelBytes = build(data, true, false);
+    EXPECT_TRUE(serialBytes == parallelBytes);
+    validate((const ParallelCopyTestRoot*)parallelBytes.data(), data);
+
+    // deduplication falls back to the serial path
+    std::vector<char> serialDedupBytes = build(data, false, true);
+    std::vector<char> parallelDedupBytes = build(data, true, true);
+    EXPECT_TRUE(serialDedupBytes == parallelDedupBytes);
+    EXPECT_LT(parallelDedupBytes.size(), parallelBytes.size());
+    validate((const ParallelCopyTestRoot*)parallelDedupBytes.data(), data);
+}
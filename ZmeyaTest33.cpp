@@ -0,0 +1,135 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+#include <cstdio>
+
+struct StreamTestNode
+{
+    uint32_t id;
+    zm::Pointer<StreamTestNode> prev;
+    zm::Pointer<StreamTestNode> next;
+    zm::String name;
+    zm::Array<uint32_t> values;
+};
+
+struct StreamTestRoot
+{
+    uint32_t numNodes;
+    zm::Pointer<StreamTestNode> head;
+    zm::Array<uint32_t> lastValues;
+};
+
+static const uint32_t kNumNodes = 2000;
+static const size_t kNumValues = 256;
+
+static void validate(const StreamTestRoot* root)
+{
+    ASSERT_EQ(root->numNodes, kNumNodes);
+    const StreamTestNode* prev = nullptr;
+    const StreamTestNode* node = root->head.get();
+    for (uint32_t i = 0; i < kNumNodes; i++)
+    {
+        ASSERT_TRUE(node != nullptr);
+        EXPECT_EQ(node->id, i);
+        EXPECT_EQ(node->prev.get(), prev);
+        EXPECT_EQ(node->name, "node_" + std::to_string(i));
+        ASSERT_EQ(node->values.size(), kNumValues);
+        EXPECT_EQ(node->values[0], i);
+        EXPECT_EQ(node->values[kNumValues - 1], i + uint32_t(kNumValues - 1));
+        prev = node;
+        node = node->next.get();
+    }
+    EXPECT_TRUE(node == nullptr);
+    ASSERT_EQ(root->lastValues.size(), kNumValues);
+    EXPECT_EQ(root->lastValues.data(), prev->values.data());
+}
+
+// builds the linked list, all the forward references are patched later
+static zm::Span<char> build(zm::BlobBuilder* blobBuilder, bool streaming)
+{
+    zm::BlobPtr<StreamTestRoot> root = blobBuilder->allocate<StreamTestRoot>();
+    root->numNodes = kNumNodes;
+    zm::BlobPtr<zm::Pointer<StreamTestNode>> head = blobBuilder->getBlobPtr(&root->head);
+    zm::BlobPtr<zm::Array<uint32_t>> lastValues = blobBuilder->getBlobPtr(&root->lastValues);
+
+    std::vector<uint32_t> values(kNumValues);
+    zm::BlobPtr<zm::Pointer<StreamTestNode>> prevNext = head;
+    zm::BlobPtr<StreamTestNode> prev;
+    size_t maxWorkingSet = 0;
+    for (uint32_t i = 0; i < kNumNodes; i++)
+    {
+        zm::BlobPtr<StreamTestNode> node = blobBuilder->allocate<StreamTestNode>();
+        node->id = i;
+        if (prev)
+        {
+            // backward reference to the (possibly flushed) data
+            node->prev = prev;
+        }
+        blobBuilder->copyTo(node->name, "node_" + std::to_string(i));
+        for (size_t j = 0; j < kNumValues; j++)
+        {
+            values[j] = i + uint32_t(j);
+        }
+        blobBuilder->copyTo(node->values, values);
+
+        // forward reference from the (possibly flushed) data
+        blobBuilder->patchPointer(prevNext, node);
+        if (i == kNumNodes - 1)
+        {
+            blobBuilder->patchArray(lastValues, blobBuilder->getBlobPtr(node->values.data()), kNumValues);
+        }
+        prevNext = blobBuilder->getBlobPtr(&node->next);
+        prev = node;
+
+        // node is complete, keep only the last node in memory
+        if (streaming)
+        {
+            blobBuilder->flush(node.getAbsoluteOffset());
+            maxWorkingSet = std::max(maxWorkingSet, blobBuilder->getSize() - blobBuilder->getFlushedSize());
+        }
+    }
+
+    if (streaming)
+    {
+        EXPECT_GT(blobBuilder->getFlushedSize(), std::size_t(0));
+        EXPECT_LT(maxWorkingSet, std::size_t(4096));
+        EXPECT_LT(blobBuilder->getCapacity() - blobBuilder->getFlushedSize(), blobBuilder->getSize() / 100);
+    }
+    return blobBuilder->finalize();
+}
+
+TEST(ZmeyaTestSuite, StreamingBuilderTest)
+{
+    std::shared_ptr<zm::BlobBuilder> memoryBuilder = zm::BlobBuilder::create(1);
+    zm::Span<char> memoryBytes = build(memoryBuilder.get(), false);
+    validate((const StreamTestRoot*)memoryBytes.data);
+
+    FILE* file = std::tmpfile();
+    ASSERT_TRUE(file != nullptr);
+    // the blob can be written after some other data
+    const char header[] = "header";
+    ASSERT_EQ(std::fwrite(header, 1, sizeof(header), file), sizeof(header));
+
+    size_t streamedSize = 0;
+    {
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::createStreaming(file, 1);
+        EXPECT_EQ(blobBuilder->getStorageType(), zm::BlobStorageType::Streaming);
+        zm::Span<char> bytes = build(blobBuilder.get(), true);
+        EXPECT_EQ(bytes.size, std::size_t(0));
+        EXPECT_FALSE(blobBuilder->hasIoError());
+        streamedSize = blobBuilder->getSize();
+    }
+
+    // streamed blob is identical to the in-memory one
+    ASSERT_EQ(streamedSize, memoryBytes.size);
+    std::vector<char> fileBytes(sizeof(header) + streamedSize);
+    std::rewind(file);
+    ASSERT_EQ(std::fread(fileBytes.data(), 1, fileBytes.size(), file), fileBytes.size());
+    std::fclose(file);
+    EXPECT_TRUE(std::memcmp(fileBytes.data(), header, sizeof(header)) == 0);
+    EXPECT_TRUE(std::memcmp(fileBytes.data() + sizeof(header), memoryBytes.data, memoryBytes.size) == 0);
+
+    std::vector<char> bytesCopy(fileBytes.begin() + sizeof(header), fileBytes.end());
+    std::memset(memoryBytes.data, 0xFF, memoryBytes.size);
+    validate((const StreamTestRoot*)bytesCopy.data());
+}
@@ -0,0 +1,161 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+#include <cstdio>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct ExternalStorageTestRoot
+{
+    uint32_t magic;
+    zm::String name;
+    zm::Array<uint32_t> values;
+};
+
+static void build(zm::BlobBuilder* blobBuilder, size_t numValues)
+{
+    zm::BlobPtr<ExternalStorageTestRoot> root = blobBuilder->allocate<ExternalStorageTestRoot>();
+    root->magic = 0xC0FFEE;
+    blobBuilder->copyTo(root->name, "external storage");
+    std::vector<uint32_t> values(numValues);
+    for (size_t i = 0; i < numValues; i++)
+    {
+        values[i] = uint32_t(i * 3);
+    }
+    blobBuilder->copyTo(root->values, values);
+}
+
+static void validate(const ExternalStorageTestRoot* root, size_t numValues)
+{
+    EXPECT_EQ(root->magic, uint32_t(0xC0FFEE));
+    EXPECT_EQ(root->name, "external storage");
+    ASSERT_EQ(root->values.size(), numValues);
+    for (size_t i = 0; i < numValues; i++)
+    {
+        EXPECT_EQ(root->values[i], uint32_t(i * 3));
+    }
+}
+
+TEST(ZmeyaTestSuite, ExternalBufferTest)
+{
+    alignas(ZMEYA_MAX_ALIGN) static char buffer[16 * 1024];
+    std::memset(buffer, 0xCD, sizeof(buffer));
+
+    std::vector<char> bytesCopy;
+    {
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::createInBuffer(buffer, sizeof(buffer));
+        EXPECT_EQ(blobBuilder->getStorageType(), zm::BlobStorageType::ExternalBuffer);
+        // the blob can still be moved to the heap on overflow
+        EXPECT_FALSE(blobBuilder->hasStableAddresses());
+        EXPECT_EQ(blobBuilder->getCapacity(), sizeof(buffer));
+        build(blobBuilder.get(), 100);
+
+        // the blob is built in place
+        zm::Span<char> bytes = blobBuilder->finalize();
+        EXPECT_FALSE(blobBuilder->hasOverflowed());
+        EXPECT_EQ(bytes.data, buffer);
+        validate((const ExternalStorageTestRoot*)buffer, 100);
+        EXPECT_TRUE(zm::isBlobCompatible(buffer, bytes.size));
+        bytesCopy = utils::copyBytes(bytes);
+        std::memset(bytes.data, 0xFF, bytes.size);
+    }
+    validate((const ExternalStorageTestRoot*)bytesCopy.data(), 100);
+
+    // the blob doesn't fit, the data is moved to the heap
+    {
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::createInBuffer(buffer, sizeof(buffer));
+        build(blobBuilder.get(), 10000);
+        zm::Span<char> bytes = blobBuilder->finalize();
+        EXPECT_TRUE(blobBuilder->hasOverflowed());
+        EXPECT_EQ(blobBuilder->getStorageType(), zm::BlobStorageType::Vector);
+        EXPECT_FALSE(blobBuilder->hasStableAddresses());
+        EXPECT_NE(bytes.data, buffer);
+        EXPECT_GT(bytes.size, sizeof(buffer));
+        validate((const ExternalStorageTestRoot*)bytes.data, 10000);
+    }
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+TEST(ZmeyaTestSuite, FileMappedBuilderTest)
+{
+    FILE* file = std::tmpfile();
+    ASSERT_TRUE(file != nullptr);
+    int fd = fileno(file);
+
+    const size_t numValues = 100000;
+    size_t blobSize = 0;
+    {
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::createFileMapped(fd, 64 * 1024 * 1024);
+        if (!blobBuilder)
+        {
+            // file mapping is disabled (ZMEYA_DISABLE_VIRTUAL_MEMORY)
+            std::fclose(file);
+            return;
+        }
+        EXPECT_EQ(blobBuilder->getStorageType(), zm::BlobStorageType::FileMapping);
+        EXPECT_TRUE(blobBuilder->hasStableAddresses());
+        build(blobBuilder.get(), numValues);
+        zm::Span<char> bytes = blobBuilder->finalize();
+        EXPECT_FALSE(blobBuilder->hasIoError());
+        validate((const ExternalStorageTestRoot*)bytes.data, numValues);
+        blobSize = bytes.size;
+    }
+
+    // the file contains exactly the blob, another mapping of the same file sees the data
+    struct stat st;
+    ASSERT_EQ(fstat(fd, &st), 0);
+    ASSERT_EQ(size_t(st.st_size), blobSize);
+    void* mapping = mmap(nullptr, blobSize, PROT_READ, MAP_SHARED, fd, 0);
+    ASSERT_TRUE(mapping != MAP_FAILED);
+    EXPECT_TRUE(zm::isBlobCompatible(mapping, blobSize));
+    validate((const ExternalStorageTestRoot*)mapping, numValues);
+    munmap(mapping, blobSize);
+    std::fclose(file);
+}
+
+TEST(ZmeyaTestSuite, FileMappedBuilderErrorTest)
+{
+    // invalid file descriptor
+    EXPECT_TRUE(zm::BlobBuilder::createFileMapped(-1) == nullptr);
+
+    char path[] = "/tmp/zmeya_filemapXXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    int readOnlyFd = open(path, O_RDONLY);
+    unlink(path);
+    ASSERT_GE(readOnlyFd, 0);
+
+    // read-only file descriptor can't be truncated
+    EXPECT_TRUE(zm::BlobBuilder::createFileMapped(readOnlyFd) == nullptr);
+
+    std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::createFileMapped(fd, 64 * 1024 * 1024);
+    if (!blobBuilder)
+    {
+        // file mapping is disabled (ZMEYA_DISABLE_VIRTUAL_MEMORY)
+        close(readOnlyFd);
+        close(fd);
+        return;
+    }
+
+    // the first pages are mapped from the file, then the descriptor becomes read-only and the file can't grow anymore
+    const size_t kPrefixSize = 1024;
+    zm::BlobPtr<char> prefix = blobBuilder->allocate(kPrefixSize, 16);
+    ASSERT_EQ(prefix.getAbsoluteOffset(), size_t(0));
+    ASSERT_EQ(dup2(readOnlyFd, fd), fd);
+
+    // the blob is completed in memory and the failure is reported
+    const size_t numValues = 100000;
+    build(blobBuilder.get(), numValues);
+    zm::Span<char> bytes = blobBuilder->finalize();
+    EXPECT_TRUE(blobBuilder->hasIoError());
+    validate((const ExternalStorageTestRoot*)(bytes.data + kPrefixSize), numValues);
+
+    blobBuilder.reset();
+    close(readOnlyFd);
+    close(fd);
+}
+#endif
@@ -0,0 +1,137 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+
+struct SegmentTestColdInfo
+{
+    uint32_t version;
+    zm::String description;
+    zm::Array<zm::String> names;
+};
+
+struct SegmentTestRoot
+{
+    zm::Array<uint32_t> lookup;
+    zm::String name;
+    zm::Pointer<SegmentTestColdInfo> cold;
+    zm::Array<float> bulk;
+};
+
+static bool isInside(const void* p, const char* begin, size_t numBytes)
+{
+    return uintptr_t(p) >= uintptr_t(begin) && uintptr_t(p) < uintptr_t(begin) + numBytes;
+}
+
+static void validate(const SegmentTestRoot* root)
+{
+    ASSERT_EQ(root->lookup.size(), std::size_t(100));
+    for (size_t i = 0; i < root->lookup.size(); i++)
+    {
+        EXPECT_EQ(root->lookup[i], uint32_t(i * 3));
+    }
+    EXPECT_EQ(root->name, "hot root");
+
+    ASSERT_TRUE(root->cold != nullptr);
+    EXPECT_EQ(root->cold->version, uint32_t(42));
+    EXPECT_EQ(root->cold->description, "rarely used description");
+    ASSERT_EQ(root->cold->names.size(), std::size_t(10));
+    for (size_t i = 0; i < root->cold->names.size(); i++)
+    {
+        EXPECT_EQ(root->cold->names[i], "name_" + std::to_string(i));
+    }
+
+    ASSERT_EQ(root->bulk.size(), std::size_t(5000));
+    for (size_t i = 0; i < root->bulk.size(); i++)
+    {
+        EXPECT_EQ(root->bulk[i], float(i) * 0.5f);
+    }
+}
+
+static void buildAndValidate(size_t segmentAlignment)
+{
+    std::vector<char> bytesCopy;
+    zm::offset_t segmentOffsets[4] = {};
+    {
+        zm::SegmentedBlobBuilder segmentedBuilder;
+        zm::BlobBuilder* hot = segmentedBuilder.getSegment("hot");
+        zm::BlobBuilder* cold = segmentedBuilder.getSegment("cold");
+        segmentedBuilder.getSegment("strings");
+        segmentedBuilder.getSegment("bulk");
+        EXPECT_EQ(segmentedBuilder.getNumSegments(), std::size_t(4));
+        EXPECT_EQ(segmentedBuilder.getSegment("hot"), hot);
+
+        zm::BlobPtr<SegmentTestRoot> root = hot->allocate<SegmentTestRoot>();
+        std::vector<uint32_t> lookup(100);
+        for (size_t i = 0; i < lookup.size(); i++)
+        {
+            lookup[i] = uint32_t(i * 3);
+        }
+        hot->copyTo(root->lookup, lookup);
+        segmentedBuilder.copyTo(hot->getBlobPtr(&root->name), "strings", std::string("hot root"));
+
+        zm::BlobPtr<SegmentTestColdInfo> coldInfo = cold->allocate<SegmentTestColdInfo>();
+        coldInfo->version = 42;
+        segmentedBuilder.assignTo(hot->getBlobPtr(&root->cold), coldInfo);
+        segmentedBuilder.copyTo(cold->getBlobPtr(&coldInfo->description), "strings", std::string("rarely used description"));
+        cold->resizeArray(coldInfo->names, 10);
+        for (size_t i = 0; i < 10; i++)
+        {
+            segmentedBuilder.copyTo(cold->getArrayElement(coldInfo->names, i), "strings", "name_" + std::to_string(i));
+        }
+
+        std::vector<float> bulk(5000);
+        for (size_t i = 0; i < bulk.size(); i++)
+        {
+            bulk[i] = float(i) * 0.5f;
+        }
+        segmentedBuilder.copyTo(hot->getBlobPtr(&root->bulk), "bulk", bulk);
+
+        zm::Span<char> bytes = segmentedBuilder.finalize(segmentAlignment);
+        const SegmentTestRoot* finalRoot = (const SegmentTestRoot*)bytes.data;
+        validate(finalRoot);
+
+        const char* names[4] = {"hot", "cold", "strings", "bulk"};
+        for (size_t i = 0; i < 4; i++)
+        {
+            zm::Span<char> segment = segmentedBuilder.getSegmentBytes(names[i]);
+            segmentOffsets[i] = segmentedBuilder.getSegmentOffset(names[i]);
+            EXPECT_EQ(segmentOffsets[i] % segmentAlignment, zm::offset_t(0));
+            EXPECT_EQ(segment.data, bytes.data + segmentOffsets[i]);
+            // segments are aligned in memory (not just relative to the blob start)
+            EXPECT_EQ(uintptr_t(segment.data) % segmentAlignment, uintptr_t(0));
+            EXPECT_LE(size_t(segmentOffsets[i]) + segment.size, bytes.size);
+            if (i > 0)
+            {
+                EXPECT_GE(size_t(segmentOffsets[i]), size_t(segmentOffsets[i - 1]));
+            }
+        }
+        EXPECT_EQ(segmentOffsets[0], zm::offset_t(0));
+        EXPECT_TRUE(segmentedBuilder.getSegmentBytes("unknown").empty());
+
+        // every object is placed into its own segment
+        zm::Span<char> hotBytes = segmentedBuilder.getSegmentBytes("hot");
+        zm::Span<char> coldBytes = segmentedBuilder.getSegmentBytes("cold");
+        zm::Span<char> stringBytes = segmentedBuilder.getSegmentBytes("strings");
+        zm::Span<char> bulkBytes = segmentedBuilder.getSegmentBytes("bulk");
+        EXPECT_TRUE(isInside(finalRoot->lookup.data(), hotBytes.data, hotBytes.size));
+        EXPECT_TRUE(isInside(finalRoot->cold.get(), coldBytes.data, coldBytes.size));
+        EXPECT_TRUE(isInside(finalRoot->name.c_str(), stringBytes.data, stringBytes.size));
+        EXPECT_TRUE(isInside(finalRoot->cold->names[9].c_str(), stringBytes.data, stringBytes.size));
+        EXPECT_TRUE(isInside(finalRoot->bulk.data(), bulkBytes.data, bulkBytes.size));
+        EXPECT_LT(hotBytes.size, std::size_t(1024));
+
+        bytesCopy = utils::copyBytes(bytes);
+        std::memset(bytes.data, 0xFF, bytes.size);
+    }
+
+    const SegmentTestRoot* rootCopy = (const SegmentTestRoot*)(bytesCopy.data());
+    validate(rootCopy);
+    EXPECT_EQ(uintptr_t(rootCopy->cold.get()) - uintptr_t(bytesCopy.data()), uintptr_t(segmentOffsets[1]));
+}
+
+TEST(ZmeyaTestSuite, SegmentedBuilderTest)
+{
+    buildAndValidate(zm::SegmentedBlobBuilder::kDefaultSegmentAlignment);
+    // large page alignment (larger than the alignment of the virtual memory storage)
+    buildAndValidate(2 * 1024 * 1024);
+}
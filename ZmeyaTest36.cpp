@@ -0,0 +1,190 @@
+#include "TestHelper.h"
+#include "Zmeya.h"
+#include "gtest/gtest.h"
+
+struct RelocationTestMesh;
+struct RelocationTestLight;
+
+struct RelocationTestMesh
+{
+    zm::String name;
+    uint32_t numTriangles;
+};
+
+struct RelocationTestLight
+{
+    float intensity;
+};
+
+struct RelocationTestNode
+{
+    uint16_t id;
+    zm::Pointer16<RelocationTestNode> parent;
+    zm::SmallArray<uint16_t> values;
+};
+
+struct RelocationTestRoot
+{
+    zm::String name;
+    zm::Pointer<RelocationTestMesh> mesh;
+    zm::Pointer<RelocationTestMesh> reassigned;
+    zm::Pointer<RelocationTestMesh> nulled;
+    zm::VariantPointer<RelocationTestMesh, RelocationTestLight> variant;
+    zm::Array<zm::String> names;
+    zm::Array<RelocationTestNode> nodes;
+};
+
+static size_t countRelocations(const zm::BlobRelocationTable& table, zm::BlobRelocationType type)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < table.size(); i++)
+    {
+        count += (table[i].type == type) ? 1 : 0;
+    }
+    return count;
+}
+
+static zm::Span<char> buildBlob(zm::BlobBuilder* blobBuilder)
+{
+    zm::BlobPtr<RelocationTestRoot> root = blobBuilder->allocate<RelocationTestRoot>();
+    blobBuilder->copyTo(root->name, "relocations");
+
+    zm::BlobPtr<RelocationTestMesh> mesh = blobBuilder->allocate<RelocationTestMesh>();
+    blobBuilder->copyTo(mesh->name, "mesh");
+    mesh->numTriangles = 12;
+    root->mesh = mesh;
+    root->nulled = mesh;
+    root->nulled = zm::BlobPtr<RelocationTestMesh>();
+
+    zm::BlobPtr<RelocationTestMesh> otherMesh = blobBuilder->allocate<RelocationTestMesh>();
+    otherMesh->numTriangles = 24;
+    root->reassigned = mesh;
+    root->reassigned = otherMesh;
+
+    zm::BlobPtr<RelocationTestLight> light = blobBuilder->allocate<RelocationTestLight>();
+    light->intensity = 2.0f;
+    root->variant = light;
+
+    blobBuilder->copyTo(root->names, std::vector<std::string>{"a", "bb", "ccc"});
+
+    blobBuilder->resizeArray(root->nodes, 4);
+    for (size_t i = 0; i < 4; i++)
+    {
+        zm::BlobPtr<RelocationTestNode> node = blobBuilder->getArrayElement(root->nodes, i);
+        node->id = uint16_t(i);
+        if (i > 0)
+        {
+            node->parent = blobBuilder->getArrayElement(root->nodes, 0);
+        }
+        blobBuilder->copyTo(node->values, {uint16_t(i), uint16_t(i + 1)});
+    }
+    return blobBuilder->finalize(16);
+}
+
+TEST(ZmeyaTestSuite, RelocationTableTest)
+{
+    std::vector<char> bytesCopy;
+    std::vector<char> bytesWithoutTable;
+    {
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+        EXPECT_FALSE(blobBuilder->isRelocationTableEnabled());
+        zm::Span<char> bytes = buildBlob(blobBuilder.get());
+        bytesWithoutTable = utils::copyBytes(bytes);
+        EXPECT_TRUE(zm::getBlobRelocations(bytes.data, bytes.size).empty());
+
+        blobBuilder = zm::BlobBuilder::create(1);
+        blobBuilder->setRelocationTableEnabled(true);
+        bytes = buildBlob(blobBuilder.get());
+        EXPECT_EQ(bytes.size % 16, std::size_t(0));
+        bytesCopy = utils::copyBytes(bytes);
+        std::memset(bytes.data, 0xFF, bytes.size);
+    }
+
+    const zm::BlobFooter* footer = zm::getBlobFooter(bytesCopy.data(), bytesCopy.size());
+    ASSERT_TRUE(footer != nullptr);
+    EXPECT_EQ(footer->flags, zm::BlobFooter::kFlagRelocationTable);
+    EXPECT_TRUE(zm::isBlobCompatible(bytesCopy.data(), bytesCopy.size()));
+
+    zm::BlobRelocationTable table = zm::getBlobRelocations(bytesCopy.data(), bytesCopy.size());
+    ASSERT_FALSE(table.empty());
+    EXPECT_TRUE(table.validate());
+    // the table is appended after the data, the data itself is the same
+    EXPECT_LE(table.getDataSize(), bytesWithoutTable.size());
+    EXPECT_TRUE(std::memcmp(bytesCopy.data(), bytesWithoutTable.data(), table.getDataSize()) == 0);
+
+    // root: name, mesh, reassigned, variant, names, nodes + mesh name, 3 strings, 3 parents, 4 value arrays
+    EXPECT_EQ(table.size(), std::size_t(17));
+    EXPECT_EQ(countRelocations(table, zm::BlobRelocationType::Pointer), std::size_t(7));
+    EXPECT_EQ(countRelocations(table, zm::BlobRelocationType::VariantPointer), std::size_t(1));
+    EXPECT_EQ(countRelocations(table, zm::BlobRelocationType::Pointer16), std::size_t(3));
+    EXPECT_EQ(countRelocations(table, zm::BlobRelocationType::Array), std::size_t(2));
+    EXPECT_EQ(countRelocations(table, zm::BlobRelocationType::SmallArray), std::size_t(4));
+
+    const RelocationTestRoot* root = (const RelocationTestRoot*)(bytesCopy.data());
+    EXPECT_EQ(root->name, "relocations");
+    EXPECT_EQ(root->mesh->numTriangles, uint32_t(12));
+    EXPECT_EQ(root->reassigned->numTriangles, uint32_t(24));
+    EXPECT_TRUE(root->nulled == nullptr);
+
+    // every site points to the same address as the typed pointers do
+    for (size_t i = 0; i < table.size(); i++)
+    {
+        zm::BlobRelocation relocation = table[i];
+        if (relocation.siteOffset == offsetof(RelocationTestRoot, reassigned))
+        {
+            EXPECT_EQ(bytesCopy.data() + relocation.targetOffset, (const char*)root->reassigned.get());
+        }
+        if (relocation.siteOffset == offsetof(RelocationTestRoot, nulled))
+        {
+            ADD_FAILURE() << "null pointer site is in the table";
+        }
+        if (relocation.siteOffset == offsetof(RelocationTestRoot, variant))
+        {
+            EXPECT_EQ(relocation.type, zm::BlobRelocationType::VariantPointer);
+            EXPECT_EQ(bytesCopy.data() + relocation.targetOffset, (const char*)root->variant.get<RelocationTestLight>());
+        }
+    }
+
+    // untyped validation detects the corrupted pointer
+    std::memset(bytesCopy.data() + offsetof(RelocationTestRoot, mesh), 0x11, sizeof(zm::Pointer<RelocationTestMesh>));
+    EXPECT_FALSE(table.validate());
+}
+
+TEST(ZmeyaTestSuite, RelocationTableLinkerTest)
+{
+    std::vector<char> bytesCopy;
+    {
+        zm::BlobLinker linker;
+        std::shared_ptr<zm::BlobBuilder> first = linker.createChunk();
+        std::shared_ptr<zm::BlobBuilder> second = linker.createChunk();
+        first->setRelocationTableEnabled(true);
+        second->setRelocationTableEnabled(true);
+
+        zm::BlobPtr<RelocationTestRoot> root = first->allocate<RelocationTestRoot>();
+        first->copyTo(root->name, "first");
+        zm::BlobPtr<RelocationTestMesh> mesh = second->allocate<RelocationTestMesh>();
+        second->copyTo(mesh->name, "second");
+        mesh->numTriangles = 3;
+        linker.linkPointer(first->getBlobPtr(&root->mesh), mesh);
+        first->copyToParallel(root->names, std::vector<std::string>{"x", "yy", "zzz", "wwww"}, 2);
+
+        std::shared_ptr<zm::BlobBuilder> blobBuilder = zm::BlobBuilder::create(1);
+        blobBuilder->setRelocationTableEnabled(true);
+        std::vector<zm::offset_t> chunkOffsets = linker.link(blobBuilder.get());
+        zm::Span<char> bytes = blobBuilder->finalize();
+        bytesCopy = utils::copyBytes(bytes);
+        std::memset(bytes.data, 0xFF, bytes.size);
+        ASSERT_EQ(chunkOffsets.size(), std::size_t(2));
+    }
+
+    const RelocationTestRoot* root = (const RelocationTestRoot*)(bytesCopy.data());
+    EXPECT_EQ(root->name, "first");
+    EXPECT_EQ(root->mesh->name, "second");
+    ASSERT_EQ(root->names.size(), std::size_t(4));
+    EXPECT_EQ(root->names[3], "wwww");
+
+    zm::BlobRelocationTable table = zm::getBlobRelocations(bytesCopy.data(), bytesCopy.size());
+    EXPECT_TRUE(table.validate());
+    // root name, root mesh, names array, 4 strings, mesh name
+    EXPECT_EQ(table.size(), std::size_t(8));
+}